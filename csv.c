@@ -50,6 +50,7 @@ struct csv_parse_t {
   int nullstrsz;        /* strlen(nullstr) */
 
   char *lastbuf; /* used by feed_last when we must add \n to end */
+  int rawcr;     /* set if csv_rawfields() took the CR off the last field */
 
   struct {
     int64_t linenum;
@@ -176,6 +177,42 @@ static int reterr(csv_parse_t *cp, int errnum, const char *const errmsg,
   return -1;
 }
 
+/**
+ *	unquote - remove quotes and escapes in p..q, writing the result to s.
+ *	s may be the same as p. Returns the length of the result.
+ */
+static int unquote(const char *p, const char *const q, char *s, char qte,
+                   char esc) {
+  int inquote = 0;
+  char *start = s;
+  while (p < q) {
+    char ch = *p++;
+    int special = (ch == esc) | (ch == qte);
+    if (unlikely(special)) {
+      if (inquote && ch == esc) {
+        char nextch = (p < q ? *p : 0);
+        if (nextch == qte || nextch == esc) {
+          // do the escape
+          p++;
+          *s++ = nextch;
+          continue;
+        }
+        // ignore the escape
+      }
+      if (ch == qte) {
+        inquote = !inquote;
+        continue;
+      }
+      // fallthru
+    }
+    *s++ = ch;
+  }
+  assert(!inquote);
+  *s = 0; /* NUL term */
+
+  return s - start;
+}
+
 /**
  *	touchup - NUL terminate, replace nullstr, and unescape each field
  */
@@ -184,8 +221,6 @@ static void touchup(csv_parse_t *cp) {
   const int nullstrsz = cp->nullstrsz;
   const char esc = cp->esc;
   const char qte = cp->qte;
-  (void)esc;
-  (void)qte; /* prevent unused var warning */
 
   /* process the fields one by one */
   const int top = cp->fldtop;
@@ -211,39 +246,11 @@ static void touchup(csv_parse_t *cp) {
       continue;
     }
 
-    int inquote = 0;
-    char *start = p;
-    char *s = p;
-    while (p < q) {
-      char ch = *p++;
-      int special = (ch == esc) | (ch == qte);
-      if (unlikely(special)) {
-        if (inquote && ch == esc) {
-          char nextch = (p < q ? *p : 0);
-          if (nextch == qte || nextch == esc) {
-            // do the escape
-            p++;
-            *s++ = nextch;
-            continue;
-          }
-          // ignore the escape
-        }
-        if (ch == qte) {
-          inquote = !inquote;
-          continue;
-        }
-        // fallthru
-      }
-      *s++ = ch;
-    }
-    assert(!inquote);
-    *s = 0; /* NUL term */
-
-    cp->fld[i] = start;
-    cp->len[i] = s - start;
+    cp->len[i] = unquote(p, q, p, qte, esc);
   }
 
-  // remove the last \r in the last field
+  // remove the last \r in the last field; what is left is NULL if it
+  // is empty, as it would be on a LF line, or if it is the nullstr
   if (top > 0) {
     char *p = cp->fld[top - 1];
     if (p) {
@@ -251,7 +258,8 @@ static void touchup(csv_parse_t *cp) {
       if (q - p > 0 && q[-1] == '\r') {
         *--q = 0;
         cp->len[top - 1] = q - p;
-        if (q - p == nullstrsz && 0 == memcmp(p, nullstr, nullstrsz)) {
+        if (q == p ||
+            (q - p == nullstrsz && 0 == memcmp(p, nullstr, nullstrsz))) {
           cp->fld[top - 1] = 0; /* make it a nullptr to indicate sql NULL field */
         }
       }
@@ -367,6 +375,7 @@ ENDVAL : {
 
 FINROW : {
   int rowsz = ppp - buf;
+  cp->rawcr = 0;
   nline++;
   cp->state.linenum += nline;
   cp->state.rownum++;
@@ -376,6 +385,53 @@ FINROW : {
 }
 }
 
+int csv_rawfields(csv_parse_t *const cp, char ***ret_field, int **ret_len,
+                  char **ret_quoted) {
+  const int top = cp->fldtop;
+
+  // leave out the \r of a CRLF line ending
+  if (top > 0 && !cp->rawcr) {
+    int *len = &cp->len[top - 1];
+    if (*len > 0 && cp->fld[top - 1][*len - 1] == '\r') {
+      --*len;
+      cp->rawcr = 1;
+    }
+  }
+
+  *ret_field = cp->fld;
+  *ret_len = cp->len;
+  *ret_quoted = cp->quoted;
+  return top;
+}
+
+void csv_touchup(csv_parse_t *const cp, char ***ret_field, int *ret_nfield) {
+  // touchup() expects the \r that csv_rawfields() may have left out
+  if (cp->rawcr) {
+    cp->len[cp->fldtop - 1]++;
+    cp->rawcr = 0;
+  }
+
+  *ret_field = cp->fld;
+  *ret_nfield = cp->fldtop;
+  touchup(cp);
+}
+
+int csv_decode(csv_parse_t *const cp, const char *raw, int len, int quoted,
+               char *dst) {
+  if (len == 0) {
+    return -1; /* sql NULL */
+  }
+  if (len == cp->nullstrsz && 0 == memcmp(raw, cp->nullstr, len)) {
+    return -1; /* sql NULL */
+  }
+  if (!quoted) {
+    memmove(dst, raw, len);
+    dst[len] = 0;
+    return len;
+  }
+  return unquote(raw, raw + len, dst, cp->qte, cp->esc);
+}
+
 int csv_feed(csv_parse_t *const cp, char *buf, int bufsz, char ***ret_field,
              int *ret_nfield) {
   *ret_field = 0;
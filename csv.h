@@ -45,6 +45,9 @@
 #define CSV_EROWTOOLONG -105  /* for csv_scan, buffer overflow */
 #define CSV_EEXTRAINPUT -106  /* for csv_scan, parse error  */
 
+/* max num bytes to give csv_line() at a time, as its bufsz is an int */
+#define CSV_WINDOW (1 << 30)
+
 typedef struct csv_parse_t csv_parse_t;
 
 /**
@@ -115,6 +118,36 @@ CSV_EXTERN int csv_errfldnum(csv_parse_t *cp);
  */
 CSV_EXTERN int csv_line(csv_parse_t *const cp, const char *buf, int bufsz);
 
+/**
+ * Get the fields of the row last parsed by csv_line() as raw spans
+ * into buf[], without unquoting, unescaping or NUL terminating them.
+ * Returns the number of fields.
+ *
+ * Also returns the start of each field in field[], its length in
+ * len[], and in quoted[] a flag telling if the field contains a quote
+ * char. A field that is not quoted is the same as its value. The CR of
+ * a CRLF line ending is not part of the last field.
+ */
+CSV_EXTERN int csv_rawfields(csv_parse_t *const cp, char ***ret_field,
+                             int **ret_len, char **ret_quoted);
+
+/**
+ * Unquote and unescape one raw field from csv_rawfields() into dst[],
+ * which must have room for len+1 bytes and may be the same as raw.
+ * The value is NUL terminated. Returns the length of the value, or -1
+ * if the field is an sql NULL.
+ */
+CSV_EXTERN int csv_decode(csv_parse_t *const cp, const char *raw, int len,
+                          int quoted, char *dst);
+
+/**
+ * Finish the row last parsed by csv_line() the way csv_feed() would:
+ * the fields are unescaped and unquoted in place in buf[], and are
+ * returned in field[]. See csv_feed for details.
+ */
+CSV_EXTERN void csv_touchup(csv_parse_t *const cp, char ***ret_field,
+                            int *ret_nfield);
+
 /**
  *  Scan using callbacks. Maximum row size is fixed at 10MB.
  *
@@ -0,0 +1,745 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-s] [-t types] [-b rows] [-d delim] [-q quote] [-e esc]\n\
+            [-n nullstr] [FILE]\n\
+                        \n\
+                        \n\
+  Print a csv file in the Arrow IPC file format (Feather v2), or with\n\
+  -s, in the Arrow IPC stream format. The header row names the\n\
+  columns, and every column is nullable.   \n\
+                                           \n\
+  Without -t, the type of each column is inferred from all the rows:\n\
+  int64 if all values are integers, double if all values are numbers,\n\
+  date if all values are YYYY-MM-DD, and string otherwise. This reads\n\
+  the input twice; a pipe is first copied to a temp file. Types are a\n\
+  comma-separated list of:                 \n\
+                                           \n\
+    string, int32, int64, float, double, date, bool\n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -s         : print the stream format instead of the file format   \n\
+      -t types   : specify column types                                  \n\
+      -b rows    : specify num rows per record batch; default to 65536   \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      -n nullstr : specify string representing null; default to \"\"     \n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csv.h"
+#include "csvcol.h"
+#include "csvwr.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+const char *pname = 0;
+const char *fname = 0;
+int qte = '"';
+int esc = '"';
+int delim = ',';
+char nullstr[20] = {0};
+int64_t batchrows = 65536;
+int streamfmt = 0;
+
+/* column types from -t, or inferred */
+csvcol_type_t *argtype = 0;
+int nargtype = 0;
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+static void *xrealloc(void *p, size_t sz) {
+  if (!(p = realloc(p, sz))) {
+    fatal("ERROR: out of memory\n");
+  }
+  return p;
+}
+
+/* parse the -t types list into argtype[] */
+static void parse_types(char *s) {
+  for (char *tok = strtok(s, ","); tok; tok = strtok(0, ",")) {
+    const int i = csvcol_type(tok);
+    if (i < 0) {
+      usage(1, "Error: -t types expects a list of string, int32, int64, "
+               "float, double, date or bool.");
+    }
+    argtype = xrealloc(argtype, (nargtype + 1) * sizeof(*argtype));
+    argtype[nargtype++] = i;
+  }
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d, *n;
+  q = e = d = n = 0;
+  while ((opt = getopt(argc, argv, "d:q:e:n:t:b:sh")) != -1) {
+    switch (opt) {
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'n':
+      n = optarg;
+      break;
+    case 't':
+      parse_types(optarg);
+      break;
+    case 'b':
+      batchrows = strtoll(optarg, 0, 10);
+      if (batchrows <= 0 || batchrows > INT32_MAX) {
+        usage(1, "Error: -b rows expects a positive number.");
+      }
+      break;
+    case 's':
+      streamfmt = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* fname */
+  if (optind == argc)
+    ; /* read from stdin */
+  else if (optind + 1 == argc)
+    fname = argv[optind];
+  else
+    usage(1, "Error: please supply only one filename");
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+
+  /* nullstr */
+  if (n) {
+    if (strlen(n) >= 20) {
+      usage(1, "Error: -n nullstr is too long. max is 19 chars");
+    }
+    strcpy(nullstr, n);
+  }
+}
+
+/* ------------------------------------------------------------------ */
+/* flatbuffers                                                         */
+
+/*
+ * A minimal flatbuffer builder that writes front to back: a table is
+ * written with placeholder offsets to its strings, vectors and
+ * sub-tables, which are written after it and then patched in. Each
+ * vtable is put right before its table.
+ */
+typedef struct fbtab_t fbtab_t;
+struct fbtab_t {
+  int nfield;
+  struct {
+    int size; /* 0 if absent; 4 for an offset */
+    uint64_t val;
+  } f[8];
+  int pos[8]; /* position of each field after fb_table() */
+};
+
+static inline void fb_pad(csvwr_t *fb, int align, int skew) {
+  while ((fb->top + skew) % align) {
+    csvwr_putc(fb, 0);
+  }
+}
+
+static void fb_add(fbtab_t *t, int id, int size, uint64_t val) {
+  t->f[id].size = size;
+  t->f[id].val = val;
+  t->nfield = id + 1 > t->nfield ? id + 1 : t->nfield;
+}
+
+/* write table t and its vtable. Returns the position of the table. */
+static int fb_table(csvwr_t *fb, fbtab_t *t) {
+  /* lay out the fields after the soffset, largest first */
+  uint16_t vt[2 + 8] = {0};
+  int tsize = 4;
+  for (int size = 8; size >= 1; size /= 2) {
+    for (int i = 0; i < t->nfield; i++) {
+      if (t->f[i].size == size) {
+        vt[2 + i] = tsize;
+        tsize += size;
+      }
+    }
+  }
+  vt[0] = 4 + 2 * t->nfield;
+  vt[1] = tsize;
+
+  /* the table starts at 4 mod 8 so its 8-byte fields are aligned */
+  fb_pad(fb, 2, 0);
+  while ((fb->top + vt[0]) % 8 != 4) {
+    csvwr_putc(fb, 0);
+  }
+  const int vtpos = fb->top;
+  csvwr_write(fb, vt, vt[0]);
+  const int tpos = fb->top;
+  const int32_t soff = tpos - vtpos;
+  csvwr_write(fb, &soff, 4);
+  for (int size = 8; size >= 1; size /= 2) {
+    for (int i = 0; i < t->nfield; i++) {
+      if (t->f[i].size == size) {
+        t->pos[i] = fb->top;
+        csvwr_write(fb, &t->f[i].val, size);
+      }
+    }
+  }
+  return tpos;
+}
+
+/* point the offset at slot to target */
+static void fb_patch(csvwr_t *fb, int slot, int target) {
+  uint32_t v = target - slot;
+  memcpy(fb->buf + slot, &v, 4);
+}
+
+static int fb_string(csvwr_t *fb, const char *s) {
+  fb_pad(fb, 4, 0);
+  const int pos = fb->top;
+  const uint32_t len = strlen(s);
+  csvwr_write(fb, &len, 4);
+  csvwr_write(fb, s, len + 1);
+  return pos;
+}
+
+/* write a vector of n elements of elemsz bytes each */
+static int fb_vector(csvwr_t *fb, const void *elem, int elemsz, int n) {
+  fb_pad(fb, 8, 4); /* elements are 8-byte aligned */
+  const int pos = fb->top;
+  const uint32_t len = n;
+  csvwr_write(fb, &len, 4);
+  csvwr_write(fb, elem, elemsz * n);
+  return pos;
+}
+
+/* ------------------------------------------------------------------ */
+/* arrow                                                               */
+
+enum { V5 = 4 };
+enum { HDR_SCHEMA = 1, HDR_RECORDBATCH = 3 };
+enum { T_INT = 2, T_FLOAT = 3, T_UTF8 = 5, T_BOOL = 6, T_DATE = 8 };
+
+/*
+ * A column of the current record batch. Fixed-width values are kept in
+ * val[], one slot per row, zero for nulls; bools take one byte each
+ * until written. Strings are kept in data[] with off[] giving the start
+ * of each row.
+ */
+typedef struct column_t column_t;
+struct column_t {
+  char *name;
+  csvcol_type_t type;
+  int width;      /* num bytes of a value in val[] */
+  uint8_t *valid; /* valid[r] is 1 if row r is not null */
+  int64_t nnull;
+  char *val;
+  int32_t *off;
+  char *data;
+  int64_t datasz, datamax;
+};
+
+struct {
+  column_t *col;
+  int ncol;
+  int64_t nrow;   /* num rows in the current batch */
+  int64_t rowmax; /* num allocated rows */
+  int schema;     /* the schema message has been written */
+} tab = {0};
+
+/* the record batches written so far, for the file footer */
+typedef struct block_t block_t;
+struct block_t {
+  int64_t offset;
+  int32_t metasz;
+  int32_t pad;
+  int64_t bodysz;
+};
+block_t *block = 0;
+int nblock = 0;
+
+csvwr_t out;
+int64_t fpos = 0; /* num bytes written to out */
+
+static void put(const void *p, int64_t n) {
+  while (n > 0) {
+    int k = n < (1 << 30) ? n : (1 << 30);
+    csvwr_write(&out, p, k);
+    p = (const char *)p + k;
+    n -= k;
+    fpos += k;
+  }
+  if (out.err) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+}
+
+static void put_pad(int64_t n) {
+  static const char zero[8] = {0};
+  put(zero, (8 - n % 8) % 8);
+}
+
+/* write the Field table for column cp */
+static int fb_field(csvwr_t *fb, const column_t *cp) {
+  static const uint8_t typeid[] = {T_UTF8, T_INT,  T_INT, T_FLOAT,
+                                   T_FLOAT, T_DATE, T_BOOL};
+  fbtab_t t = {0};
+  fb_add(&t, 0, 4, 0);              /* name */
+  fb_add(&t, 1, 1, 1);              /* nullable */
+  fb_add(&t, 2, 1, typeid[cp->type]); /* type_type */
+  fb_add(&t, 3, 4, 0);              /* type */
+  fb_add(&t, 5, 4, 0);              /* children */
+  const int pos = fb_table(fb, &t);
+
+  fb_patch(fb, t.pos[0], fb_string(fb, cp->name));
+
+  fbtab_t ty = {0};
+  switch (cp->type) {
+  case CSVCOL_INT32:
+  case CSVCOL_INT64:
+    fb_add(&ty, 0, 4, cp->type == CSVCOL_INT32 ? 32 : 64); /* bitWidth */
+    fb_add(&ty, 1, 1, 1);                                  /* is_signed */
+    break;
+  case CSVCOL_FLOAT:
+  case CSVCOL_DOUBLE:
+    fb_add(&ty, 0, 2, cp->type == CSVCOL_FLOAT ? 1 : 2); /* precision */
+    break;
+  case CSVCOL_DATE:
+    fb_add(&ty, 0, 2, 0); /* unit: DAY */
+    break;
+  default:
+    break;
+  }
+  fb_patch(fb, t.pos[3], fb_table(fb, &ty));
+  fb_patch(fb, t.pos[5], fb_vector(fb, 0, 4, 0));
+  return pos;
+}
+
+/* write the Schema table */
+static int fb_schema(csvwr_t *fb) {
+  fbtab_t t = {0};
+  fb_add(&t, 0, 2, 0); /* endianness: Little */
+  fb_add(&t, 1, 4, 0); /* fields */
+  const int pos = fb_table(fb, &t);
+
+  const int vec = fb_vector(fb, 0, 4, 0);
+  fb->top = vec + 4;
+  for (int i = 0; i < tab.ncol; i++) {
+    csvwr_write(fb, "\0\0\0\0", 4);
+  }
+  memcpy(fb->buf + vec, &tab.ncol, 4);
+  fb_patch(fb, t.pos[1], vec);
+  for (int i = 0; i < tab.ncol; i++) {
+    fb_patch(fb, vec + 4 + 4 * i, fb_field(fb, &tab.col[i]));
+  }
+  return pos;
+}
+
+/* write an encapsulated message: metadata in fb, then the body. Returns
+ * the size of the metadata including its prefix. */
+static int put_message(csvwr_t *fb) {
+  fb_pad(fb, 8, 0);
+  if (fb->err) {
+    fatal("ERROR: out of memory\n");
+  }
+  const uint32_t prefix[2] = {0xffffffff, fb->top};
+  put(prefix, 8);
+  put(fb->buf, fb->top);
+  return 8 + fb->top;
+}
+
+/* start a Message table in fb. Returns the slot of its header. */
+static int fb_message(csvwr_t *fb, int hdrtype, int64_t bodysz) {
+  csvwr_reset(fb);
+  csvwr_write(fb, "\0\0\0\0", 4); /* root offset */
+  fbtab_t t = {0};
+  fb_add(&t, 0, 2, V5);      /* version */
+  fb_add(&t, 1, 1, hdrtype); /* header_type */
+  fb_add(&t, 2, 4, 0);       /* header */
+  fb_add(&t, 3, 8, bodysz);  /* bodyLength */
+  fb_patch(fb, 0, fb_table(fb, &t));
+  return t.pos[2];
+}
+
+csvwr_t meta; /* scratch for flatbuffers */
+
+static void put_schema(void) {
+  const int slot = fb_message(&meta, HDR_SCHEMA, 0);
+  fb_patch(&meta, slot, fb_schema(&meta));
+  put_message(&meta);
+}
+
+/* ------------------------------------------------------------------ */
+/* column values                                                       */
+
+/* set the value of row r of cp to s[0..len), or NULL if s is 0 */
+static int set_value(column_t *cp, int64_t r, const char *s, int len) {
+  cp->valid[r] = (s != 0);
+  if (cp->type == CSVCOL_STRING) {
+    if (s) {
+      if (cp->datasz + len > INT32_MAX) {
+        fatal("ERROR: more than 2GB of strings in a batch; use -b\n");
+      }
+      if (cp->datasz + len > cp->datamax) {
+        cp->datamax = (cp->datasz + len) * 1.5 + 4096;
+        cp->datamax = cp->datamax < INT32_MAX ? cp->datamax : INT32_MAX;
+        cp->data = xrealloc(cp->data, cp->datamax);
+      }
+      memcpy(cp->data + cp->datasz, s, len);
+      cp->datasz += len;
+    }
+    cp->off[r + 1] = cp->datasz;
+  }
+  if (!s) {
+    cp->nnull++;
+    if (cp->type != CSVCOL_STRING) {
+      memset(cp->val + r * cp->width, 0, cp->width);
+    }
+    return 0;
+  }
+  if (cp->type == CSVCOL_STRING) {
+    return 0;
+  }
+  return csvcol_value(cp->type, s, len, cp->val + r * cp->width);
+}
+
+/* ------------------------------------------------------------------ */
+/* record batches                                                      */
+
+/* scratch for the bitmaps of a batch */
+csvwr_t bits;
+
+/* pack flag[0..n) into a bitmap in bits[] */
+static void pack_bits(const uint8_t *flag, int64_t n) {
+  csvwr_reset(&bits);
+  for (int64_t i = 0; i < n; i += 8) {
+    uint8_t acc = 0;
+    for (int k = 0; k < 8 && i + k < n; k++) {
+      acc |= (flag[i + k] & 1) << k;
+    }
+    csvwr_putc(&bits, acc);
+  }
+  if (bits.err) {
+    fatal("ERROR: out of memory\n");
+  }
+}
+
+static void flush_batch(void) {
+  if (!tab.schema) {
+    put_schema();
+    tab.schema = 1;
+  }
+  if (tab.nrow == 0) {
+    return;
+  }
+  const int64_t n = tab.nrow;
+  const int64_t nbitmap = (n + 7) / 8;
+#define PAD8(x) (((x) + 7) & ~(int64_t)7)
+
+  /* lay out the body: per column, the validity bitmap, then offsets
+   * and data for strings, or the values */
+  int64_t nodes[2 * tab.ncol];
+  int64_t bufs[2 * 3 * tab.ncol];
+  int nbuf = 0;
+  int64_t bodysz = 0;
+  for (int i = 0; i < tab.ncol; i++) {
+    column_t *cp = &tab.col[i];
+    nodes[2 * i] = n;
+    nodes[2 * i + 1] = cp->nnull;
+
+    const int64_t validsz = cp->nnull ? nbitmap : 0;
+    bufs[2 * nbuf] = bodysz;
+    bufs[2 * nbuf++ + 1] = validsz;
+    bodysz += PAD8(validsz);
+
+    int64_t sz[2];
+    int k = 0;
+    if (cp->type == CSVCOL_STRING) {
+      sz[k++] = (n + 1) * 4;
+      sz[k++] = cp->datasz;
+    } else if (cp->type == CSVCOL_BOOL) {
+      sz[k++] = nbitmap;
+    } else {
+      sz[k++] = n * cp->width;
+    }
+    for (int j = 0; j < k; j++) {
+      bufs[2 * nbuf] = bodysz;
+      bufs[2 * nbuf++ + 1] = sz[j];
+      bodysz += PAD8(sz[j]);
+    }
+  }
+
+  /* metadata */
+  const int slot = fb_message(&meta, HDR_RECORDBATCH, bodysz);
+  fbtab_t t = {0};
+  fb_add(&t, 0, 8, n); /* length */
+  fb_add(&t, 1, 4, 0); /* nodes */
+  fb_add(&t, 2, 4, 0); /* buffers */
+  fb_patch(&meta, slot, fb_table(&meta, &t));
+  fb_patch(&meta, t.pos[1], fb_vector(&meta, nodes, 16, tab.ncol));
+  fb_patch(&meta, t.pos[2], fb_vector(&meta, bufs, 16, nbuf));
+
+  block = xrealloc(block, (nblock + 1) * sizeof(*block));
+  block_t *bp = &block[nblock++];
+  bp->offset = fpos;
+  bp->metasz = put_message(&meta);
+  bp->pad = 0;
+  bp->bodysz = bodysz;
+
+  /* body */
+  for (int i = 0; i < tab.ncol; i++) {
+    column_t *cp = &tab.col[i];
+    if (cp->nnull) {
+      pack_bits(cp->valid, n);
+      put(bits.buf, bits.top);
+      put_pad(bits.top);
+    }
+    if (cp->type == CSVCOL_STRING) {
+      put(cp->off, (n + 1) * 4);
+      put_pad((n + 1) * 4);
+      put(cp->data, cp->datasz);
+      put_pad(cp->datasz);
+    } else if (cp->type == CSVCOL_BOOL) {
+      pack_bits((const uint8_t *)cp->val, n);
+      put(bits.buf, bits.top);
+      put_pad(bits.top);
+    } else {
+      put(cp->val, n * cp->width);
+      put_pad(n * cp->width);
+    }
+
+    cp->nnull = 0;
+    cp->datasz = 0;
+  }
+#undef PAD8
+  tab.nrow = 0;
+}
+
+/* write the end of stream marker, and for files, the footer */
+static void put_end(void) {
+  const uint32_t eos[2] = {0xffffffff, 0};
+  put(eos, 8);
+  if (streamfmt) {
+    return;
+  }
+
+  csvwr_reset(&meta);
+  csvwr_write(&meta, "\0\0\0\0", 4); /* root offset */
+  fbtab_t t = {0};
+  fb_add(&t, 0, 2, V5); /* version */
+  fb_add(&t, 1, 4, 0);  /* schema */
+  fb_add(&t, 3, 4, 0);  /* recordBatches */
+  fb_patch(&meta, 0, fb_table(&meta, &t));
+  fb_patch(&meta, t.pos[1], fb_schema(&meta));
+  fb_patch(&meta, t.pos[3], fb_vector(&meta, block, 24, nblock));
+  if (meta.err) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  const int32_t n = meta.top;
+  put(meta.buf, meta.top);
+  put(&n, 4);
+  put("ARROW1", 6);
+}
+
+/* ------------------------------------------------------------------ */
+/* csv input                                                           */
+
+/* set up the columns from the header row */
+static void set_header(char **field, int nfield) {
+  if (nargtype != nfield) {
+    fatal("ERROR: header has %d fields, but -t has %d types\n", nfield,
+          nargtype);
+  }
+  tab.ncol = nfield;
+  tab.col = xrealloc(0, nfield * sizeof(*tab.col));
+  memset(tab.col, 0, nfield * sizeof(*tab.col));
+  for (int i = 0; i < nfield; i++) {
+    column_t *cp = &tab.col[i];
+    char tmp[20];
+    if (field[i] && *field[i]) {
+      cp->name = strdup(field[i]);
+    } else {
+      sprintf(tmp, "col%d", i);
+      cp->name = strdup(tmp);
+    }
+    if (!cp->name) {
+      fatal("ERROR: out of memory\n");
+    }
+    cp->type = argtype[i];
+    cp->width = csvcol_width(cp->type);
+  }
+}
+
+int do_read(intptr_t handle, char *buf, int bufsz) {
+  FILE *fp = (FILE *)handle;
+  return fread(buf, 1, bufsz, fp);
+}
+
+int do_row(intptr_t handle, int64_t rownum, char **field, int nfield) {
+  (void)handle;
+  if (rownum == 1) {
+    set_header(field, nfield);
+    return 0;
+  }
+  if (nfield > tab.ncol) {
+    fatal("ERROR: row %" PRId64 " has %d fields, but the header has %d\n",
+          rownum, nfield, tab.ncol);
+  }
+
+  /* make room for one more row */
+  if (tab.nrow == tab.rowmax) {
+    tab.rowmax = tab.rowmax * 1.5 + 1024;
+    tab.rowmax = tab.rowmax < batchrows ? tab.rowmax : batchrows;
+    for (int i = 0; i < tab.ncol; i++) {
+      column_t *cp = &tab.col[i];
+      cp->valid = xrealloc(cp->valid, tab.rowmax);
+      if (cp->type == CSVCOL_STRING) {
+        const int isnew = (cp->off == 0);
+        cp->off = xrealloc(cp->off, (tab.rowmax + 1) * 4);
+        cp->off[0] = isnew ? 0 : cp->off[0];
+      } else {
+        cp->val = xrealloc(cp->val, tab.rowmax * cp->width);
+      }
+    }
+  }
+
+  const int64_t r = tab.nrow++;
+  for (int i = 0; i < tab.ncol; i++) {
+    column_t *cp = &tab.col[i];
+    const char *s = i < nfield ? field[i] : 0;
+    if (set_value(cp, r, s, s ? strlen(s) : 0)) {
+      fatal("ERROR: row %" PRId64 " field %d: invalid %s value '%s'\n",
+            rownum, i + 1, csvcol_name(cp->type), s);
+    }
+  }
+
+  if (tab.nrow == batchrows) {
+    flush_batch();
+  }
+  return 0;
+}
+
+void do_error(intptr_t handle, int errtype, const char *errmsg,
+              csv_parse_t *cp) {
+  (void)handle;
+  (void)errtype;
+  errmsg = cp ? csv_errmsg(cp) : errmsg;
+  fatal("ERROR: %s\n", errmsg);
+}
+
+/* infer the column types from all the rows of fp into argtype[].
+ * Returns the file to read the rows from again. */
+static FILE *infer_types(FILE *fp) {
+  char errbuf[200];
+  int fd = fileno(fp);
+  if (csvcol_infer(&fd, qte, esc, delim, nullstr, &argtype, &nargtype,
+                   errbuf, sizeof(errbuf))) {
+    fatal("ERROR: %s\n", errbuf);
+  }
+  if (fd != fileno(fp)) {
+    // the input was copied to a temp file
+    fclose(fp);
+    if (!(fp = fdopen(fd, "r"))) {
+      fatal("ERROR: fdopen - %s\n", strerror(errno));
+    }
+  }
+  return fp;
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+  FILE *fp = stdin;
+
+  if (fname && !(fp = fopen(fname, "r"))) {
+    perr("ERROR: fopen %s - %s\n", fname, strerror(errno));
+    exit(1);
+  }
+  if (!nargtype) {
+    fp = infer_types(fp);
+  }
+
+  if (csvwr_init(&out, 1, 4 * 1024 * 1024) || csvwr_init(&meta, -1, 0) ||
+      csvwr_init(&bits, -1, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  if (!streamfmt) {
+    put("ARROW1\0\0", 8);
+  }
+  csv_scan((intptr_t)fp, qte, esc, delim, nullstr, do_read, do_row, do_error);
+  if (!tab.col) {
+    fatal("ERROR: no header row\n");
+  }
+  flush_batch();
+  put_end();
+
+  if (csvwr_fini(&out)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+  fclose(fp);
+
+  return 0;
+}
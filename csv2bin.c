@@ -0,0 +1,287 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-x] [-d delim] [-q quote] [-e esc] [-n nullstr] [FILE]\n\
+                        \n\
+                        \n\
+  Convert a csv file into a stream of length-prefixed binary rows, or\n\
+  with -x, convert such a stream back into a csv file. The binary\n\
+  rows can be read without parsing by the csvbin_row() and\n\
+  csvbin_next() functions in csvbin.h.     \n\
+                                           \n\
+  For example:                             \n\
+                                           \n\
+    %s FILE | stage1 | stage2 | %s -x      \n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -x         : convert binary rows back into csv                     \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      -n nullstr : specify string representing null; default to \"\"     \n\
+      \n\
+  The -d, -q, -e and -n options apply to the csv input, or with -x, to\n\
+  the csv output.      \n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csv.h"
+#include "csvbin.h"
+#include "csvrd.h"
+#include "csvwr.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+const char *pname = 0;
+const char *fname = 0;
+int qte = '"';
+int esc = 0;
+int delim = ',';
+char nullstr[20] = {0};
+int nullsz = 0;
+csvwr_dialect_t odialect; /* output dialect */
+int decode = 0;
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname, pname, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d, *n;
+  q = e = d = n = 0;
+  while ((opt = getopt(argc, argv, "d:q:e:n:xh")) != -1) {
+    switch (opt) {
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'n':
+      n = optarg;
+      break;
+    case 'x':
+      decode = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* fname */
+  if (optind == argc)
+    ; /* read from stdin */
+  else if (optind + 1 == argc)
+    fname = argv[optind];
+  else
+    usage(1, "Error: please supply only one filename");
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+  esc = esc ? esc : qte;
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+
+  /* nullstr */
+  if (n) {
+    if (strlen(n) >= 20) {
+      usage(1, "Error: -n nullstr is too long. max is 19 chars");
+    }
+    strcpy(nullstr, n);
+  }
+  nullsz = strlen(nullstr);
+
+  odialect = (csvwr_dialect_t){qte, esc, delim, nullstr, nullsz};
+}
+
+/* csv to binary rows */
+static void do_encode(int fd, csvwr_t *out) {
+  csv_parse_t *cp = csv_open(qte, esc, delim, nullstr);
+  if (!cp) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  csvrd_t in;
+  if (csvrd_init(&in, fd, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  csvbin_put_header(out);
+  char *row;
+  int nb;
+  while ((nb = csvrd_line(&in, cp, &row)) > 0) {
+    if (csvbin_put_csvrow(out, cp)) {
+      fatal("ERROR: cannot write to stdout - %s\n", strerror(out->err));
+    }
+  }
+  if (nb < 0) {
+    fatal("ERROR: %s\n", in.errmsg);
+  }
+
+  csvrd_fini(&in);
+  csv_close(cp);
+}
+
+/* input buffer of the binary rows; data is in buf[p..q) */
+struct {
+  char *buf;
+  int max;
+  int p, q;
+  int eof;
+} in = {0};
+
+/* move the unconsumed data to the front of buf[] and read more.
+ * buf[] is expanded if it is full. */
+static void fill(int fd) {
+  if (in.p) {
+    memmove(in.buf, in.buf + in.p, in.q - in.p);
+    in.q -= in.p;
+    in.p = 0;
+  }
+  if (in.q == in.max) {
+    in.max = in.max ? in.max * 2 : 1024 * 1024;
+    if (!(in.buf = realloc(in.buf, in.max))) {
+      fatal("ERROR: out of memory\n");
+    }
+  }
+  for (;;) {
+    int nb = read(fd, in.buf + in.q, in.max - in.q);
+    if (nb < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      fatal("ERROR: read - %s\n", strerror(errno));
+    }
+    in.q += nb;
+    in.eof = (nb == 0);
+    return;
+  }
+}
+
+/* binary rows to csv */
+static void do_decode(int fd, csvwr_t *out) {
+  int hdr = 0;
+  while (!in.eof) {
+    fill(fd);
+    if (!hdr) {
+      hdr = csvbin_check_header(in.buf + in.p, in.q - in.p);
+      if (hdr < 0 || (hdr == 0 && in.eof && in.q > in.p)) {
+        fatal("ERROR: input is not a csvbin stream\n");
+      }
+      in.p += hdr;
+    }
+    if (!hdr) {
+      continue;
+    }
+
+    while (in.p < in.q) {
+      csvbin_row_t row;
+      int nb = csvbin_row(in.buf + in.p, in.q - in.p, &row);
+      if (nb < 0) {
+        fatal("ERROR: malformed row in csvbin stream\n");
+      }
+      if (nb == 0) {
+        break;
+      }
+      const char *val;
+      int len;
+      for (int i = 0; 0 == csvbin_next(&row, &val, &len); i++) {
+        if (i) {
+          csvwr_putc(out, delim);
+        }
+        csvwr_value(out, &odialect, len < 0 ? 0 : val, len);
+      }
+      csvwr_putc(out, '\n');
+      in.p += nb;
+    }
+  }
+
+  if (in.p != in.q) {
+    fatal("ERROR: truncated row at end of csvbin stream\n");
+  }
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+  int fd = 0;
+  csvwr_t out;
+
+  if (fname && (fd = open(fname, O_RDONLY)) < 0) {
+    perr("ERROR: open %s - %s\n", fname, strerror(errno));
+    exit(1);
+  }
+  if (csvwr_init(&out, 1, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  if (decode) {
+    do_decode(fd, &out);
+  } else {
+    do_encode(fd, &out);
+  }
+
+  if (csvwr_fini(&out)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+  free(in.buf);
+  close(fd);
+  return 0;
+}
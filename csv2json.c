@@ -0,0 +1,381 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-t] [-d delim] [-q quote] [-e esc] [-n nullstr] [FILE]\n\
+                        \n\
+                        \n\
+  Print a csv file as JSON Lines, one object per row, keyed by the\n\
+  names in the header row.                 \n\
+                                           \n\
+  For example, a csv file with these lines:\n\
+    id,name,score                          \n\
+    1,\"Doe, John\",                       \n\
+                                           \n\
+  will be printed as:                      \n\
+                                           \n\
+    {\"id\":\"1\",\"name\":\"Doe, John\",\"score\":null}\n\
+                                           \n\
+  or with -t as:                           \n\
+                                           \n\
+    {\"id\":1,\"name\":\"Doe, John\",\"score\":null}\n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -t         : print numbers and true/false as json values           \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      -n nullstr : specify string representing null; default to \"\"     \n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csv.h"
+#include "csvwr.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __ARM_NEON__
+#include "simde/x86/avx2.h"
+#else
+#include <x86intrin.h>
+#endif
+
+#define likely(x) __builtin_expect((x), 1)
+#define unlikely(x) __builtin_expect((x), 0)
+
+const char *pname = 0;
+const char *fname = 0;
+int qte = '"';
+int esc = '"';
+int delim = ',';
+char nullstr[20] = {0};
+int typed = 0;
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d, *n;
+  q = e = d = n = 0;
+  while ((opt = getopt(argc, argv, "d:q:e:n:th")) != -1) {
+    switch (opt) {
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'n':
+      n = optarg;
+      break;
+    case 't':
+      typed = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* fname */
+  if (optind == argc)
+    ; /* read from stdin */
+  else if (optind + 1 == argc)
+    fname = argv[optind];
+  else
+    usage(1, "Error: please supply only one filename");
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+
+  /* nullstr */
+  if (n) {
+    if (strlen(n) >= 20) {
+      usage(1, "Error: -n nullstr is too long. max is 19 chars");
+    }
+    strcpy(nullstr, n);
+  }
+}
+
+csvwr_t out;
+
+/* keys from the header row, each already quoted and escaped */
+struct {
+  char **key;
+  int *len;
+  int nkey;
+} hdr = {0};
+
+/* write a control char, dquote or backslash as a json escape */
+static void put_escape(csvwr_t *wr, uint8_t ch) {
+  static const char hex[] = "0123456789abcdef";
+  char buf[6] = {'\\', 0};
+  switch (ch) {
+  case '"':
+  case '\\':
+    buf[1] = ch;
+    break;
+  case '\b':
+    buf[1] = 'b';
+    break;
+  case '\f':
+    buf[1] = 'f';
+    break;
+  case '\n':
+    buf[1] = 'n';
+    break;
+  case '\r':
+    buf[1] = 'r';
+    break;
+  case '\t':
+    buf[1] = 't';
+    break;
+  default:
+    memcpy(buf + 1, "u00", 3);
+    buf[4] = hex[ch >> 4];
+    buf[5] = hex[ch & 15];
+    csvwr_write(wr, buf, 6);
+    return;
+  }
+  csvwr_write(wr, buf, 2);
+}
+
+/* bitmap of chars in p[0..32) that need escaping in a json string */
+static inline uint32_t escmap(const char *p) {
+  __m256i src = _mm256_loadu_si256((const __m256i *)p);
+  __m256i dq = _mm256_cmpeq_epi8(src, _mm256_set1_epi8('"'));
+  __m256i bs = _mm256_cmpeq_epi8(src, _mm256_set1_epi8('\\'));
+  /* ch <= 0x1f iff min(ch, 0x1f) == ch */
+  __m256i cc =
+      _mm256_cmpeq_epi8(_mm256_min_epu8(src, _mm256_set1_epi8(0x1f)), src);
+  return _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(dq, bs), cc));
+}
+
+/* write s[0..len) as a json string. Clean runs are copied as is. */
+static void put_string(csvwr_t *wr, const char *s, int len) {
+  const char *p = s;
+  const char *const q = s + len;
+  csvwr_putc(wr, '"');
+
+  while (q - p >= 32) {
+    uint32_t bmap = escmap(p);
+    if (likely(bmap == 0)) {
+      p += 32;
+      continue;
+    }
+    const char *x = p + __builtin_ctz(bmap);
+    csvwr_write(wr, s, x - s);
+    put_escape(wr, *x);
+    s = p = x + 1;
+  }
+
+  for (; p < q; p++) {
+    uint8_t ch = *p;
+    if (unlikely(ch < 0x20 || ch == '"' || ch == '\\')) {
+      csvwr_write(wr, s, p - s);
+      put_escape(wr, ch);
+      s = p + 1;
+    }
+  }
+  csvwr_write(wr, s, q - s);
+  csvwr_putc(wr, '"');
+}
+
+/* check for -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)? */
+static int is_number(const char *p, int len) {
+  const char *const q = p + len;
+#define DIGIT(p) ((p) < q && (unsigned)(*(p) - '0') <= 9)
+  if (p < q && *p == '-') {
+    p++;
+  }
+  if (!DIGIT(p)) {
+    return 0;
+  }
+  if (*p++ != '0') {
+    while (DIGIT(p)) {
+      p++;
+    }
+  }
+  if (p < q && *p == '.') {
+    p++;
+    if (!DIGIT(p)) {
+      return 0;
+    }
+    while (DIGIT(p)) {
+      p++;
+    }
+  }
+  if (p < q && (*p == 'e' || *p == 'E')) {
+    p++;
+    if (p < q && (*p == '+' || *p == '-')) {
+      p++;
+    }
+    if (!DIGIT(p)) {
+      return 0;
+    }
+    while (DIGIT(p)) {
+      p++;
+    }
+  }
+#undef DIGIT
+  return p == q;
+}
+
+static void put_value(csvwr_t *wr, const char *s) {
+  if (!s) {
+    csvwr_write(wr, "null", 4);
+    return;
+  }
+  const int len = strlen(s);
+  if (typed && (is_number(s, len) || 0 == strcmp(s, "true") ||
+                0 == strcmp(s, "false"))) {
+    csvwr_write(wr, s, len);
+    return;
+  }
+  put_string(wr, s, len);
+}
+
+/* save the header row as quoted keys */
+static void set_header(char **col, int ncol) {
+  csvwr_t tmp;
+  if (!(hdr.key = calloc(ncol, sizeof(*hdr.key))) ||
+      !(hdr.len = calloc(ncol, sizeof(*hdr.len))) ||
+      csvwr_init(&tmp, -1, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+  for (int i = 0; i < ncol; i++) {
+    csvwr_reset(&tmp);
+    put_string(&tmp, col[i] ? col[i] : "", col[i] ? strlen(col[i]) : 0);
+    csvwr_putc(&tmp, ':');
+    if (tmp.err || !(hdr.key[i] = malloc(tmp.top))) {
+      fatal("ERROR: out of memory\n");
+    }
+    memcpy(hdr.key[i], tmp.buf, tmp.top);
+    hdr.len[i] = tmp.top;
+  }
+  hdr.nkey = ncol;
+  csvwr_fini(&tmp);
+}
+
+int do_read(intptr_t handle, char *buf, int bufsz) {
+  FILE *fp = (FILE *)handle;
+  return fread(buf, 1, bufsz, fp);
+}
+
+int do_row(intptr_t handle, int64_t rownum, char **col, int ncol) {
+  (void)handle;
+  if (rownum == 1) {
+    set_header(col, ncol);
+    return 0;
+  }
+
+  csvwr_putc(&out, '{');
+  for (int i = 0; i < ncol; i++) {
+    if (i) {
+      csvwr_putc(&out, ',');
+    }
+    if (i < hdr.nkey) {
+      csvwr_write(&out, hdr.key[i], hdr.len[i]);
+    } else {
+      /* no name in the header; use the column number */
+      char key[20];
+      csvwr_write(&out, key, sprintf(key, "\"%d\":", i + 1));
+    }
+    put_value(&out, col[i]);
+  }
+  csvwr_write(&out, "}\n", 2);
+
+  if (out.err) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+  return 0;
+}
+
+void do_error(intptr_t handle, int errtype, const char *errmsg,
+              csv_parse_t *cp) {
+  (void)handle;
+  (void)errtype;
+  errmsg = cp ? csv_errmsg(cp) : errmsg;
+  fatal("ERROR: %s\n", errmsg);
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+  FILE *fp = stdin;
+
+  if (fname && !(fp = fopen(fname, "r"))) {
+    perr("ERROR: fopen %s - %s\n", fname, strerror(errno));
+    exit(1);
+  }
+
+  if (csvwr_init(&out, 1, 4 * 1024 * 1024)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  csv_scan((intptr_t)fp, qte, esc, delim, nullstr, do_read, do_row, do_error);
+
+  if (csvwr_fini(&out)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+  fclose(fp);
+
+  return 0;
+}
@@ -0,0 +1,913 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-t types] [-r rows] [-z] [-d delim] [-q quote] [-e esc]\n\
+            [-n nullstr] [FILE]\n\
+                        \n\
+                        \n\
+  Print a csv file in the Parquet format. The header row names the\n\
+  columns, and every column is nullable.   \n\
+                                           \n\
+  Without -t, the type of each column is inferred from all the rows:\n\
+  int64 if all values are integers, double if all values are numbers,\n\
+  date if all values are YYYY-MM-DD, and string otherwise. This reads\n\
+  the input twice; a pipe is first copied to a temp file. Types are a\n\
+  comma-separated list of:                 \n\
+                                           \n\
+    string, int32, int64, float, double, date, bool\n\
+                                           \n\
+  Columns are dictionary encoded when that is smaller, and plain\n\
+  encoded otherwise.                       \n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -t types   : specify column types                                  \n\
+      -r rows    : specify num rows per row group; default to 1048576    \n\
+      -z         : compress pages with zstd, if built with libzstd       \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      -n nullstr : specify string representing null; default to \"\"     \n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csv.h"
+#include "csvcol.h"
+#include "csvwr.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+const char *pname = 0;
+const char *fname = 0;
+int qte = '"';
+int esc = '"';
+int delim = ',';
+char nullstr[20] = {0};
+int64_t grouprows = 1048576;
+int usezstd = 0;
+
+/* column types from -t, or inferred */
+csvcol_type_t *argtype = 0;
+int nargtype = 0;
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+static void *xrealloc(void *p, size_t sz) {
+  if (!(p = realloc(p, sz))) {
+    fatal("ERROR: out of memory\n");
+  }
+  return p;
+}
+
+/* parse the -t types list into argtype[] */
+static void parse_types(char *s) {
+  for (char *tok = strtok(s, ","); tok; tok = strtok(0, ",")) {
+    const int i = csvcol_type(tok);
+    if (i < 0) {
+      usage(1, "Error: -t types expects a list of string, int32, int64, "
+               "float, double, date or bool.");
+    }
+    argtype = xrealloc(argtype, (nargtype + 1) * sizeof(*argtype));
+    argtype[nargtype++] = i;
+  }
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d, *n;
+  q = e = d = n = 0;
+  while ((opt = getopt(argc, argv, "d:q:e:n:t:r:zh")) != -1) {
+    switch (opt) {
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'n':
+      n = optarg;
+      break;
+    case 't':
+      parse_types(optarg);
+      break;
+    case 'r':
+      grouprows = strtoll(optarg, 0, 10);
+      if (grouprows <= 0 || grouprows > INT32_MAX) {
+        usage(1, "Error: -r rows expects a positive number.");
+      }
+      break;
+    case 'z':
+#ifndef HAVE_ZSTD
+      usage(1, "Error: -z needs a build with libzstd.");
+#endif
+      usezstd = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* fname */
+  if (optind == argc)
+    ; /* read from stdin */
+  else if (optind + 1 == argc)
+    fname = argv[optind];
+  else
+    usage(1, "Error: please supply only one filename");
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+
+  /* nullstr */
+  if (n) {
+    if (strlen(n) >= 20) {
+      usage(1, "Error: -n nullstr is too long. max is 19 chars");
+    }
+    strcpy(nullstr, n);
+  }
+}
+
+/* parquet enums */
+enum { PQ_BOOLEAN = 0, PQ_INT32 = 1, PQ_INT64 = 2, PQ_FLOAT = 4,
+       PQ_DOUBLE = 5, PQ_BYTE_ARRAY = 6 };
+enum { PQ_PLAIN = 0, PQ_RLE = 3, PQ_RLE_DICTIONARY = 8 };
+enum { PQ_DATA_PAGE = 0, PQ_DICTIONARY_PAGE = 2 };
+enum { PQ_UNCOMPRESSED = 0, PQ_ZSTD = 6 };
+enum { PQ_UTF8 = 0, PQ_DATE = 6 };
+enum { PQ_OPTIONAL = 1 };
+
+#define PAGESZ (1024 * 1024) /* target num value bytes in a data page */
+#define DICTMAX (1024 * 1024) /* max num bytes in a dictionary page */
+
+/* physical type of each column type */
+static const int pqtype[] = {PQ_BYTE_ARRAY, PQ_INT32,  PQ_INT64, PQ_FLOAT,
+                             PQ_DOUBLE,     PQ_INT32,  PQ_BOOLEAN};
+
+/*
+ * A column of the current row group. The values of the non-null rows
+ * are kept in val[] in the PLAIN encoding of the column type, except
+ * for bool, which is one byte per value.
+ */
+typedef struct column_t column_t;
+struct column_t {
+  char *name;
+  csvcol_type_t type;
+  uint8_t *def; /* def[r] is 1 if row r is not null */
+  int64_t nrow; /* num rows in the row group */
+  int64_t nval; /* num non-null values in val[] */
+  char *val;
+  int64_t valsz, valmax;
+
+  /* where the column chunk went in the file */
+  int64_t dictoff, dataoff, nbytes, zbytes;
+  int usedict;
+};
+
+struct {
+  column_t *col;
+  int ncol;
+  int64_t nrow;    /* num rows in the current row group */
+  int64_t rowmax;  /* num allocated rows in def[] */
+  int64_t totrows; /* num rows written */
+} tab = {0};
+
+/* the row groups written so far, for the footer */
+typedef struct group_t group_t;
+struct group_t {
+  int64_t nrow;
+  int64_t nbytes;
+  int64_t *dictoff, *dataoff, *nbytes_col, *zbytes_col, *nval;
+  int *usedict;
+};
+group_t *group = 0;
+int ngroup = 0;
+
+csvwr_t out;
+int64_t fpos = 0; /* num bytes written to out */
+
+static void put(const void *p, int64_t n) {
+  while (n > 0) {
+    int k = n < (1 << 30) ? n : (1 << 30);
+    csvwr_write(&out, p, k);
+    p = (const char *)p + k;
+    n -= k;
+    fpos += k;
+  }
+  if (out.err) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+}
+
+/* ------------------------------------------------------------------ */
+/* thrift compact protocol                                             */
+
+enum { TT_TRUE = 1, TT_FALSE = 2, TT_I32 = 5, TT_I64 = 6, TT_BINARY = 8,
+       TT_LIST = 9, TT_STRUCT = 12 };
+
+typedef struct thrift_t thrift_t;
+struct thrift_t {
+  csvwr_t *wr;
+  int16_t last[16]; /* last field id in each nested struct */
+  int depth;
+};
+
+static void tw_varint(thrift_t *t, uint64_t v) {
+  while (v >= 0x80) {
+    csvwr_putc(t->wr, (v & 0x7f) | 0x80);
+    v >>= 7;
+  }
+  csvwr_putc(t->wr, v);
+}
+
+static void tw_zigzag(thrift_t *t, int64_t v) {
+  tw_varint(t, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+static void tw_field(thrift_t *t, int id, int type) {
+  const int delta = id - t->last[t->depth];
+  if (0 < delta && delta <= 15) {
+    csvwr_putc(t->wr, delta << 4 | type);
+  } else {
+    csvwr_putc(t->wr, type);
+    tw_zigzag(t, id);
+  }
+  t->last[t->depth] = id;
+}
+
+static void tw_begin(thrift_t *t) { t->last[++t->depth] = 0; }
+
+static void tw_end(thrift_t *t) {
+  csvwr_putc(t->wr, 0);
+  t->depth--;
+}
+
+static void tw_i32(thrift_t *t, int id, int32_t v) {
+  tw_field(t, id, TT_I32);
+  tw_zigzag(t, v);
+}
+
+static void tw_i64(thrift_t *t, int id, int64_t v) {
+  tw_field(t, id, TT_I64);
+  tw_zigzag(t, v);
+}
+
+static void tw_binary(thrift_t *t, const char *s, int len) {
+  tw_varint(t, len);
+  csvwr_write(t->wr, s, len);
+}
+
+static void tw_string(thrift_t *t, int id, const char *s) {
+  tw_field(t, id, TT_BINARY);
+  tw_binary(t, s, strlen(s));
+}
+
+static void tw_list(thrift_t *t, int id, int elemtype, int n) {
+  tw_field(t, id, TT_LIST);
+  if (n < 15) {
+    csvwr_putc(t->wr, n << 4 | elemtype);
+  } else {
+    csvwr_putc(t->wr, 0xf0 | elemtype);
+    tw_varint(t, n);
+  }
+}
+
+static void tw_struct(thrift_t *t, int id) {
+  tw_field(t, id, TT_STRUCT);
+  tw_begin(t);
+}
+
+/* ------------------------------------------------------------------ */
+/* RLE / bit-packed hybrid encoding                                    */
+
+static void put_varint(csvwr_t *wr, uint64_t v) {
+  while (v >= 0x80) {
+    csvwr_putc(wr, (v & 0x7f) | 0x80);
+    v >>= 7;
+  }
+  csvwr_putc(wr, v);
+}
+
+/* length of the run of equal values at v[i], counting at most max */
+static inline int64_t runlen(const uint32_t *v, int64_t i, int64_t n,
+                             int64_t max) {
+  int64_t j = i + 1;
+  while (j < n && j - i < max && v[j] == v[i]) {
+    j++;
+  }
+  return j - i;
+}
+
+/* write v[0..n) with bit width bw. Runs of 8 or more equal values are
+ * run-length encoded; everything else is bit-packed in groups of 8. */
+static void put_hybrid(csvwr_t *wr, const uint32_t *v, int64_t n, int bw) {
+  int64_t i = 0;
+  while (i < n) {
+    int64_t r = runlen(v, i, n, INT32_MAX);
+    if (r >= 8) {
+      put_varint(wr, r << 1);
+      for (int k = 0; k < bw; k += 8) {
+        csvwr_putc(wr, v[i] >> k);
+      }
+      i += r;
+      continue;
+    }
+
+    /* bit-pack groups of 8 until a long run starts on a group */
+    int64_t j = i + 8;
+    while (j < n && runlen(v, j, n, 8) < 8) {
+      j += 8;
+    }
+    put_varint(wr, ((j - i) / 8) << 1 | 1);
+    uint64_t acc = 0;
+    int nbit = 0;
+    for (; i < j; i++) {
+      acc |= (uint64_t)(i < n ? v[i] : 0) << nbit;
+      nbit += bw;
+      while (nbit >= 8) {
+        csvwr_putc(wr, acc);
+        acc >>= 8;
+        nbit -= 8;
+      }
+    }
+  }
+}
+
+/* ------------------------------------------------------------------ */
+/* column values                                                       */
+
+static int bitwidth(uint32_t maxval) {
+  int bw = 1;
+  while (bw < 32 && (maxval >> bw)) {
+    bw++;
+  }
+  return bw;
+}
+
+static void val_room(column_t *cp, int64_t n) {
+  if (cp->valsz + n > cp->valmax) {
+    cp->valmax = (cp->valsz + n) * 1.5 + 4096;
+    cp->val = xrealloc(cp->val, cp->valmax);
+  }
+}
+
+/* append value s[0..len) to cp->val[] in the column type */
+static int add_value(column_t *cp, const char *s, int len) {
+  if (cp->type == CSVCOL_STRING) {
+    const int32_t n = len;
+    val_room(cp, 4 + len);
+    memcpy(cp->val + cp->valsz, &n, 4);
+    memcpy(cp->val + cp->valsz + 4, s, len);
+    cp->valsz += 4 + len;
+    return 0;
+  }
+  val_room(cp, csvcol_width(cp->type));
+  if (csvcol_value(cp->type, s, len, cp->val + cp->valsz)) {
+    return -1;
+  }
+  cp->valsz += csvcol_width(cp->type);
+  return 0;
+}
+
+/* size of the value at p in cp->val[] */
+static inline int value_size(const column_t *cp, const char *p) {
+  if (cp->type == CSVCOL_STRING) {
+    int32_t len;
+    memcpy(&len, p, 4);
+    return 4 + len;
+  }
+  return csvcol_width(cp->type);
+}
+
+/* ------------------------------------------------------------------ */
+/* pages                                                               */
+
+/* scratch buffers for building pages */
+csvwr_t body;  /* page data */
+csvwr_t zbody; /* compressed page data */
+csvwr_t head;  /* page header */
+
+/* write a page; body holds its uncompressed data */
+static void put_page(column_t *cp, int pagetype, int nval, int encoding) {
+  const char *data = body.buf;
+  int datasz = body.top;
+
+#ifdef HAVE_ZSTD
+  if (usezstd) {
+    size_t bound = ZSTD_compressBound(body.top);
+    csvwr_reset(&zbody);
+    if (bound > INT32_MAX || csvwr_room(&zbody, bound)) {
+      fatal("ERROR: out of memory\n");
+    }
+    size_t n = ZSTD_compress(zbody.buf, bound, body.buf, body.top, 1);
+    if (ZSTD_isError(n)) {
+      fatal("ERROR: zstd - %s\n", ZSTD_getErrorName(n));
+    }
+    data = zbody.buf;
+    datasz = n;
+  }
+#endif
+
+  thrift_t t = {&head, {0}, 0};
+  csvwr_reset(&head);
+  tw_i32(&t, 1, pagetype);
+  tw_i32(&t, 2, body.top);
+  tw_i32(&t, 3, datasz);
+  if (pagetype == PQ_DATA_PAGE) {
+    tw_struct(&t, 5);
+    tw_i32(&t, 1, nval);
+    tw_i32(&t, 2, encoding);
+    tw_i32(&t, 3, PQ_RLE); /* definition levels */
+    tw_i32(&t, 4, PQ_RLE); /* repetition levels */
+    tw_end(&t);
+  } else {
+    tw_struct(&t, 7);
+    tw_i32(&t, 1, nval);
+    tw_i32(&t, 2, encoding);
+    tw_end(&t);
+  }
+  csvwr_putc(&head, 0);
+  if (head.err || body.err || zbody.err) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  put(head.buf, head.top);
+  put(data, datasz);
+  cp->nbytes += head.top + body.top;
+  cp->zbytes += head.top + datasz;
+}
+
+/* dictionary of the distinct values of a column chunk */
+struct {
+  uint32_t *slot; /* hash table of entry# + 1; 0 is empty */
+  int64_t nslot;
+  int64_t *off; /* off[k]: offset in val[] of entry k */
+  int64_t nent, entmax;
+  int64_t nbytes; /* num bytes in the dictionary page */
+  uint32_t *idx;  /* idx[v]: entry# of value v */
+  int64_t idxmax;
+} dict = {0};
+
+static inline uint64_t hash_bytes(const char *p, int n) {
+  uint64_t h = 0xcbf29ce484222325ull; /* FNV-1a */
+  for (int i = 0; i < n; i++) {
+    h = (h ^ (uint8_t)p[i]) * 0x100000001b3ull;
+  }
+  return h ^ (h >> 29);
+}
+
+/* build the dictionary of cp. Returns 0 if it pays off, else -1. */
+static int build_dict(column_t *cp) {
+  if (cp->type == CSVCOL_BOOL || cp->nval < 2) {
+    return -1;
+  }
+  int64_t nslot = 1024;
+  while (nslot < cp->nval * 2 && nslot < (1 << 20) * 4) {
+    nslot *= 2;
+  }
+  if (nslot > dict.nslot) {
+    dict.slot = xrealloc(dict.slot, nslot * sizeof(*dict.slot));
+  }
+  dict.nslot = nslot;
+  memset(dict.slot, 0, nslot * sizeof(*dict.slot));
+  if (cp->nval > dict.idxmax) {
+    dict.idxmax = cp->nval;
+    dict.idx = xrealloc(dict.idx, dict.idxmax * sizeof(*dict.idx));
+  }
+  dict.nent = dict.nbytes = 0;
+
+  const char *p = cp->val;
+  for (int64_t v = 0; v < cp->nval; v++) {
+    const int n = value_size(cp, p);
+    int64_t h = hash_bytes(p, n) & (nslot - 1);
+    for (;;) {
+      uint32_t k = dict.slot[h];
+      if (k == 0) {
+        /* new entry; give up when the dictionary gets too big */
+        dict.nbytes += n;
+        if (dict.nbytes > DICTMAX || dict.nent * 2 >= nslot) {
+          return -1;
+        }
+        if (dict.nent == dict.entmax) {
+          dict.entmax = dict.entmax * 1.5 + 1024;
+          dict.off = xrealloc(dict.off, dict.entmax * sizeof(*dict.off));
+        }
+        dict.off[dict.nent] = p - cp->val;
+        dict.slot[h] = ++dict.nent;
+        dict.idx[v] = dict.nent - 1;
+        break;
+      }
+      const char *e = cp->val + dict.off[k - 1];
+      if (value_size(cp, e) == n && 0 == memcmp(e, p, n)) {
+        dict.idx[v] = k - 1;
+        break;
+      }
+      h = (h + 1) & (nslot - 1);
+    }
+    p += n;
+  }
+
+  /* dictionary pays off if the indices plus the dictionary are smaller
+   * than the plain values */
+  const int64_t idxbytes = cp->nval * bitwidth(dict.nent - 1) / 8 + 1;
+  return dict.nbytes + idxbytes < cp->valsz ? 0 : -1;
+}
+
+/* write the column chunk of cp in the current row group */
+static void put_column(column_t *cp) {
+  cp->nbytes = cp->zbytes = 0;
+  cp->dictoff = -1;
+  cp->usedict = (0 == build_dict(cp));
+
+  if (cp->usedict) {
+    csvwr_reset(&body);
+    for (int64_t k = 0; k < dict.nent; k++) {
+      const char *e = cp->val + dict.off[k];
+      csvwr_write(&body, e, value_size(cp, e));
+    }
+    cp->dictoff = fpos;
+    put_page(cp, PQ_DICTIONARY_PAGE, dict.nent, PQ_PLAIN);
+  }
+  cp->dataoff = fpos;
+
+  const int bw = cp->usedict ? bitwidth(dict.nent - 1) : 0;
+  uint32_t *tmp = 0;
+  int64_t tmpmax = 0;
+
+  /* cut the rows into pages of about PAGESZ value bytes */
+  const char *p = cp->val;
+  int64_t v = 0; /* index of the first value in the page */
+  for (int64_t r0 = 0; r0 < cp->nrow;) {
+    int64_t r1 = r0;
+    int64_t v1 = v;
+    const char *q = p;
+    while (r1 < cp->nrow && q - p < PAGESZ) {
+      if (cp->def[r1++]) {
+        q += value_size(cp, q);
+        v1++;
+      }
+    }
+
+    csvwr_reset(&body);
+    if (r1 - r0 > tmpmax || v1 - v > tmpmax) {
+      tmpmax = (r1 - r0) * 2;
+      tmp = xrealloc(tmp, tmpmax * sizeof(*tmp));
+    }
+
+    /* definition levels, prefixed by their length */
+    for (int64_t r = r0; r < r1; r++) {
+      tmp[r - r0] = cp->def[r];
+    }
+    csvwr_write(&body, "\0\0\0\0", 4);
+    put_hybrid(&body, tmp, r1 - r0, 1);
+    uint32_t n = body.top - 4;
+    memcpy(body.buf, &n, 4);
+
+    if (cp->usedict) {
+      csvwr_putc(&body, bw);
+      put_hybrid(&body, dict.idx + v, v1 - v, bw);
+    } else if (cp->type == CSVCOL_BOOL) {
+      for (int64_t i = v; i < v1; i++) {
+        tmp[i - v] = (uint8_t)cp->val[i];
+      }
+      /* plain booleans are bit-packed without a header */
+      uint8_t acc = 0;
+      for (int64_t i = 0; i < v1 - v; i++) {
+        acc |= tmp[i] << (i & 7);
+        if ((i & 7) == 7) {
+          csvwr_putc(&body, acc);
+          acc = 0;
+        }
+      }
+      if ((v1 - v) & 7) {
+        csvwr_putc(&body, acc);
+      }
+    } else {
+      csvwr_write(&body, p, q - p);
+    }
+
+    put_page(cp, PQ_DATA_PAGE, r1 - r0,
+             cp->usedict ? PQ_RLE_DICTIONARY : PQ_PLAIN);
+    r0 = r1;
+    v = v1;
+    p = q;
+  }
+  free(tmp);
+}
+
+/* write out the current row group */
+static void flush_group(void) {
+  if (tab.nrow == 0) {
+    return;
+  }
+
+  group = xrealloc(group, (ngroup + 1) * sizeof(*group));
+  group_t *g = &group[ngroup++];
+  g->nrow = tab.nrow;
+  g->nbytes = 0;
+  g->dictoff = xrealloc(0, tab.ncol * sizeof(int64_t));
+  g->dataoff = xrealloc(0, tab.ncol * sizeof(int64_t));
+  g->nbytes_col = xrealloc(0, tab.ncol * sizeof(int64_t));
+  g->zbytes_col = xrealloc(0, tab.ncol * sizeof(int64_t));
+  g->nval = xrealloc(0, tab.ncol * sizeof(int64_t));
+  g->usedict = xrealloc(0, tab.ncol * sizeof(int));
+
+  for (int i = 0; i < tab.ncol; i++) {
+    column_t *cp = &tab.col[i];
+    cp->nrow = tab.nrow;
+    put_column(cp);
+    g->dictoff[i] = cp->dictoff;
+    g->dataoff[i] = cp->dataoff;
+    g->nbytes_col[i] = cp->nbytes;
+    g->zbytes_col[i] = cp->zbytes;
+    g->nval[i] = tab.nrow;
+    g->usedict[i] = cp->usedict;
+    g->nbytes += cp->nbytes;
+
+    cp->nval = cp->valsz = 0;
+  }
+  tab.totrows += tab.nrow;
+  tab.nrow = 0;
+}
+
+/* write the FileMetaData and the trailer */
+static void put_footer(void) {
+  csvwr_t meta;
+  if (csvwr_init(&meta, -1, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+  thrift_t t = {&meta, {0}, 0};
+
+  tw_i32(&t, 1, 1); /* version */
+
+  /* schema: the root, then one leaf per column */
+  tw_list(&t, 2, TT_STRUCT, tab.ncol + 1);
+  tw_begin(&t);
+  tw_string(&t, 4, "schema");
+  tw_i32(&t, 5, tab.ncol);
+  tw_end(&t);
+  for (int i = 0; i < tab.ncol; i++) {
+    const column_t *cp = &tab.col[i];
+    tw_begin(&t);
+    tw_i32(&t, 1, pqtype[cp->type]);
+    tw_i32(&t, 3, PQ_OPTIONAL);
+    tw_string(&t, 4, cp->name);
+    if (cp->type == CSVCOL_STRING) {
+      tw_i32(&t, 6, PQ_UTF8);
+    } else if (cp->type == CSVCOL_DATE) {
+      tw_i32(&t, 6, PQ_DATE);
+    }
+    tw_end(&t);
+  }
+
+  tw_i64(&t, 3, tab.totrows);
+
+  tw_list(&t, 4, TT_STRUCT, ngroup);
+  for (int gi = 0; gi < ngroup; gi++) {
+    const group_t *g = &group[gi];
+    tw_begin(&t);
+    tw_list(&t, 1, TT_STRUCT, tab.ncol);
+    for (int i = 0; i < tab.ncol; i++) {
+      const column_t *cp = &tab.col[i];
+      const int64_t off = g->dictoff[i] >= 0 ? g->dictoff[i] : g->dataoff[i];
+      tw_begin(&t); /* ColumnChunk */
+      tw_i64(&t, 2, off);
+      tw_struct(&t, 3); /* ColumnMetaData */
+      tw_i32(&t, 1, pqtype[cp->type]);
+      if (g->usedict[i]) {
+        tw_list(&t, 2, TT_I32, 3);
+        tw_zigzag(&t, PQ_PLAIN);
+        tw_zigzag(&t, PQ_RLE);
+        tw_zigzag(&t, PQ_RLE_DICTIONARY);
+      } else {
+        tw_list(&t, 2, TT_I32, 2);
+        tw_zigzag(&t, PQ_PLAIN);
+        tw_zigzag(&t, PQ_RLE);
+      }
+      tw_list(&t, 3, TT_BINARY, 1);
+      tw_binary(&t, cp->name, strlen(cp->name));
+      tw_i32(&t, 4, usezstd ? PQ_ZSTD : PQ_UNCOMPRESSED);
+      tw_i64(&t, 5, g->nval[i]);
+      tw_i64(&t, 6, g->nbytes_col[i]);
+      tw_i64(&t, 7, g->zbytes_col[i]);
+      tw_i64(&t, 9, g->dataoff[i]);
+      if (g->dictoff[i] >= 0) {
+        tw_i64(&t, 11, g->dictoff[i]);
+      }
+      tw_end(&t);
+      tw_end(&t);
+    }
+    tw_i64(&t, 2, g->nbytes);
+    tw_i64(&t, 3, g->nrow);
+    tw_end(&t);
+  }
+
+  tw_string(&t, 6, "csvc99 csv2parquet");
+  csvwr_putc(&meta, 0);
+  if (meta.err) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  uint32_t n = meta.top;
+  put(meta.buf, meta.top);
+  put(&n, 4);
+  put("PAR1", 4);
+  csvwr_fini(&meta);
+}
+
+/* ------------------------------------------------------------------ */
+/* csv input                                                           */
+
+/* set up the columns from the header row */
+static void set_header(char **field, int nfield) {
+  if (nargtype != nfield) {
+    fatal("ERROR: header has %d fields, but -t has %d types\n", nfield,
+          nargtype);
+  }
+  tab.ncol = nfield;
+  tab.col = xrealloc(0, nfield * sizeof(*tab.col));
+  memset(tab.col, 0, nfield * sizeof(*tab.col));
+  for (int i = 0; i < nfield; i++) {
+    column_t *cp = &tab.col[i];
+    char tmp[20];
+    if (field[i] && *field[i]) {
+      cp->name = strdup(field[i]);
+    } else {
+      sprintf(tmp, "col%d", i);
+      cp->name = strdup(tmp);
+    }
+    if (!cp->name) {
+      fatal("ERROR: out of memory\n");
+    }
+    cp->type = argtype[i];
+  }
+}
+
+int do_read(intptr_t handle, char *buf, int bufsz) {
+  FILE *fp = (FILE *)handle;
+  return fread(buf, 1, bufsz, fp);
+}
+
+int do_row(intptr_t handle, int64_t rownum, char **field, int nfield) {
+  (void)handle;
+  if (rownum == 1) {
+    set_header(field, nfield);
+    return 0;
+  }
+  if (nfield > tab.ncol) {
+    fatal("ERROR: row %" PRId64 " has %d fields, but the header has %d\n",
+          rownum, nfield, tab.ncol);
+  }
+
+  /* make room for one more row */
+  if (tab.nrow == tab.rowmax) {
+    tab.rowmax = tab.rowmax * 1.5 + 1024;
+    tab.rowmax = tab.rowmax < grouprows ? tab.rowmax : grouprows;
+    for (int i = 0; i < tab.ncol; i++) {
+      column_t *cp = &tab.col[i];
+      cp->def = xrealloc(cp->def, tab.rowmax);
+    }
+  }
+
+  const int64_t r = tab.nrow++;
+  for (int i = 0; i < tab.ncol; i++) {
+    column_t *cp = &tab.col[i];
+    const char *s = i < nfield ? field[i] : 0;
+    cp->def[r] = (s != 0);
+    if (!s) {
+      continue;
+    }
+    if (add_value(cp, s, strlen(s))) {
+      fatal("ERROR: row %" PRId64 " field %d: invalid %s value '%s'\n",
+            rownum, i + 1, csvcol_name(cp->type), s);
+    }
+    cp->nval++;
+  }
+
+  if (tab.nrow == grouprows) {
+    flush_group();
+  }
+  return 0;
+}
+
+void do_error(intptr_t handle, int errtype, const char *errmsg,
+              csv_parse_t *cp) {
+  (void)handle;
+  (void)errtype;
+  errmsg = cp ? csv_errmsg(cp) : errmsg;
+  fatal("ERROR: %s\n", errmsg);
+}
+
+/* infer the column types from all the rows of fp into argtype[].
+ * Returns the file to read the rows from again. */
+static FILE *infer_types(FILE *fp) {
+  char errbuf[200];
+  int fd = fileno(fp);
+  if (csvcol_infer(&fd, qte, esc, delim, nullstr, &argtype, &nargtype,
+                   errbuf, sizeof(errbuf))) {
+    fatal("ERROR: %s\n", errbuf);
+  }
+  if (fd != fileno(fp)) {
+    // the input was copied to a temp file
+    fclose(fp);
+    if (!(fp = fdopen(fd, "r"))) {
+      fatal("ERROR: fdopen - %s\n", strerror(errno));
+    }
+  }
+  return fp;
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+  FILE *fp = stdin;
+
+  if (fname && !(fp = fopen(fname, "r"))) {
+    perr("ERROR: fopen %s - %s\n", fname, strerror(errno));
+    exit(1);
+  }
+  if (!nargtype) {
+    fp = infer_types(fp);
+  }
+
+  if (csvwr_init(&out, 1, 4 * 1024 * 1024) || csvwr_init(&body, -1, 0) ||
+      csvwr_init(&zbody, -1, 0) || csvwr_init(&head, -1, 1024)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  put("PAR1", 4);
+  csv_scan((intptr_t)fp, qte, esc, delim, nullstr, do_read, do_row, do_error);
+  if (!tab.col) {
+    fatal("ERROR: no header row\n");
+  }
+  flush_group();
+  put_footer();
+
+  if (csvwr_fini(&out)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+  fclose(fp);
+
+  return 0;
+}
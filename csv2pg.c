@@ -0,0 +1,351 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-H] [-t types] [-d delim] [-q quote] [-e esc] [-n nullstr]\n\
+            [FILE]\n\
+                        \n\
+                        \n\
+  Print a csv file in the PostgreSQL binary COPY format, to be loaded\n\
+  with:                                    \n\
+                                           \n\
+    COPY table FROM STDIN (FORMAT binary)  \n\
+                                           \n\
+  By default every field is sent as text, which the server converts to\n\
+  the column type. With -t, fields are encoded in the binary form of\n\
+  the given column types, which must match the table. Types are a\n\
+  comma-separated list of:                 \n\
+                                           \n\
+    text, int2, int4, int8, float4, float8, date, bool\n\
+                                           \n\
+  For example: -t int8,text,float8,date    \n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -H         : skip the header row                                   \n\
+      -t types   : specify column types                                  \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      -n nullstr : specify string representing null; default to \"\"     \n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csv.h"
+#include "csvnum.h"
+#include "csvwr.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+const char *pname = 0;
+const char *fname = 0;
+int qte = '"';
+int esc = '"';
+int delim = ',';
+char nullstr[20] = {0};
+int skiphdr = 0;
+
+/* column types for -t */
+typedef enum pgtype_t pgtype_t;
+enum pgtype_t { TEXT, INT2, INT4, INT8, FLOAT4, FLOAT8, DATE, BOOL };
+const char *const typename[] = {"text",   "int2",   "int4", "int8",
+                                "float4", "float8", "date", "bool"};
+pgtype_t *coltype = 0;
+int ncoltype = 0;
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+/* parse the -t types list into coltype[] */
+static void parse_types(char *s) {
+  for (char *tok = strtok(s, ","); tok; tok = strtok(0, ",")) {
+    int i;
+    for (i = 0; i <= BOOL; i++) {
+      if (0 == strcmp(tok, typename[i])) {
+        break;
+      }
+    }
+    if (i > BOOL) {
+      usage(1, "Error: -t types expects a list of text, int2, int4, int8, "
+               "float4, float8, date or bool.");
+    }
+    if (!(coltype = realloc(coltype, (ncoltype + 1) * sizeof(*coltype)))) {
+      fatal("ERROR: out of memory\n");
+    }
+    coltype[ncoltype++] = i;
+  }
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d, *n;
+  q = e = d = n = 0;
+  while ((opt = getopt(argc, argv, "d:q:e:n:t:Hh")) != -1) {
+    switch (opt) {
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'n':
+      n = optarg;
+      break;
+    case 't':
+      parse_types(optarg);
+      break;
+    case 'H':
+      skiphdr = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* fname */
+  if (optind == argc)
+    ; /* read from stdin */
+  else if (optind + 1 == argc)
+    fname = argv[optind];
+  else
+    usage(1, "Error: please supply only one filename");
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+
+  /* nullstr */
+  if (n) {
+    if (strlen(n) >= 20) {
+      usage(1, "Error: -n nullstr is too long. max is 19 chars");
+    }
+    strcpy(nullstr, n);
+  }
+}
+
+csvwr_t out;
+
+/* write v in network byte order */
+static inline void put_int16(int16_t v) {
+  uint16_t x = __builtin_bswap16(v);
+  csvwr_write(&out, &x, 2);
+}
+
+static inline void put_int32(int32_t v) {
+  uint32_t x = __builtin_bswap32(v);
+  csvwr_write(&out, &x, 4);
+}
+
+static inline void put_int64(int64_t v) {
+  uint64_t x = __builtin_bswap64(v);
+  csvwr_write(&out, &x, 8);
+}
+
+/* convert s[0..len) to type and write it as a field */
+static int put_typed(pgtype_t type, const char *s, int len) {
+  int64_t ival;
+  double dval;
+  int32_t date;
+
+  switch (type) {
+  case TEXT:
+    put_int32(len);
+    csvwr_write(&out, s, len);
+    return 0;
+
+  case INT2:
+  case INT4:
+  case INT8:
+    if (csvnum_int64(s, len, &ival)) {
+      return -1;
+    }
+    if (type == INT2 && ival == (int16_t)ival) {
+      put_int32(2);
+      put_int16(ival);
+    } else if (type == INT4 && ival == (int32_t)ival) {
+      put_int32(4);
+      put_int32(ival);
+    } else if (type == INT8) {
+      put_int32(8);
+      put_int64(ival);
+    } else {
+      return -1; /* out of range */
+    }
+    return 0;
+
+  case FLOAT4:
+  case FLOAT8:
+    if (csvnum_double(s, len, &dval)) {
+      return -1;
+    }
+    if (type == FLOAT4) {
+      float f = dval;
+      int32_t x;
+      memcpy(&x, &f, 4);
+      put_int32(4);
+      put_int32(x);
+    } else {
+      int64_t x;
+      memcpy(&x, &dval, 8);
+      put_int32(8);
+      put_int64(x);
+    }
+    return 0;
+
+  case DATE:
+    if (csvnum_date(s, len, &date)) {
+      return -1;
+    }
+    put_int32(4);
+    put_int32(date - 10957); /* days since 2000-01-01 */
+    return 0;
+
+  case BOOL: {
+    static const char *const yes[] = {"t", "true", "y", "yes", "on", "1", 0};
+    static const char *const no[] = {"f", "false", "n", "no", "off", "0", 0};
+    for (int i = 0; yes[i]; i++) {
+      if (0 == strcasecmp(s, yes[i]) || 0 == strcasecmp(s, no[i])) {
+        put_int32(1);
+        csvwr_putc(&out, 0 == strcasecmp(s, yes[i]));
+        return 0;
+      }
+    }
+    return -1;
+  }
+  }
+
+  return -1;
+}
+
+int do_read(intptr_t handle, char *buf, int bufsz) {
+  FILE *fp = (FILE *)handle;
+  return fread(buf, 1, bufsz, fp);
+}
+
+int do_row(intptr_t handle, int64_t rownum, char **col, int ncol) {
+  (void)handle;
+  if (rownum == 1 && skiphdr) {
+    return 0;
+  }
+  if (ncoltype && ncol != ncoltype) {
+    fatal("ERROR: row %" PRId64 " has %d fields, but -t has %d types\n",
+          rownum, ncol, ncoltype);
+  }
+
+  put_int16(ncol);
+  for (int i = 0; i < ncol; i++) {
+    const char *s = col[i];
+    if (!s) {
+      put_int32(-1); /* NULL */
+      continue;
+    }
+    pgtype_t type = ncoltype ? coltype[i] : TEXT;
+    if (put_typed(type, s, strlen(s))) {
+      fatal("ERROR: row %" PRId64 " field %d: invalid %s value '%s'\n", rownum,
+            i + 1, typename[type], s);
+    }
+  }
+
+  if (out.err) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+  return 0;
+}
+
+void do_error(intptr_t handle, int errtype, const char *errmsg,
+              csv_parse_t *cp) {
+  (void)handle;
+  (void)errtype;
+  errmsg = cp ? csv_errmsg(cp) : errmsg;
+  fatal("ERROR: %s\n", errmsg);
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+  FILE *fp = stdin;
+
+  if (fname && !(fp = fopen(fname, "r"))) {
+    perr("ERROR: fopen %s - %s\n", fname, strerror(errno));
+    exit(1);
+  }
+
+  if (csvwr_init(&out, 1, 4 * 1024 * 1024)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  /* signature, flags and header extension length */
+  csvwr_write(&out, "PGCOPY\n\377\r\n\0", 11);
+  put_int32(0);
+  put_int32(0);
+
+  csv_scan((intptr_t)fp, qte, esc, delim, nullstr, do_read, do_row, do_error);
+
+  /* trailer */
+  put_int16(-1);
+
+  if (csvwr_fini(&out)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+  fclose(fp);
+  free(coltype);
+
+  return 0;
+}
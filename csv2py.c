@@ -12,7 +12,8 @@
 */
 
 const char *usagestr = "\n\
-  USAGE: %s [-h] [-d delim] [-q quote] [-e esc] [-n nullstr] [FILE]\n\
+  USAGE: %s [-h] [-d delim] [-q quote] [-e esc] [-n nullstr] [-o dir] [-C]\n\
+            [FILE]\n\
                         \n\
                         \n\
   Print a csv file in a format that can be read into a \n\
@@ -28,6 +29,12 @@ const char *usagestr = "\n\
      ['1','2',None,'3'],                   \n\
      ['abcd','efg','hij','klm']            \n\
    ]                                       \n\
+                                           \n\
+  With -o dir, each column is written instead to a numpy file\n\
+  dir/colN.npy, where N counts from 0, that can be loaded with\n\
+  numpy.load(path, mmap_mode='r'). Columns of integers are written as\n\
+  int64, columns of numbers as float64 with NaN for None, and other\n\
+  columns as fixed-width bytes with b'' for None.\n\
                         \n\
   OPTIONS:              \n\
                         \n\
@@ -35,15 +42,25 @@ const char *usagestr = "\n\
       -q quote   : specify quote char; default to double-quote           \n\
       -e esc     : specify escape char; default to the quote char        \n\
       -n nullstr : specify string representing null; default to \"\"     \n\
+      -o dir     : write columns to dir/colN.npy                         \n\
+      -C         : read FILE through its parse cache FILE.csvcache       \n\
       \n\
 ";
 
 #define _GNU_SOURCE
 #include "csv.h"
+#include "csvcache.h"
+#include "csvnum.h"
+#include "csvwr.h"
 #include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 const char *pname = 0;
@@ -52,6 +69,8 @@ int qte = '"';
 int esc = '"';
 int delim = ',';
 char nullstr[20] = {0};
+const char *outdir = 0;
+int usecache = 0;
 
 #define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
 #define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
@@ -74,7 +93,7 @@ void parse_cmdline(int argc, char *const *argv) {
   int opt;
   char *q, *e, *d, *n;
   q = e = d = n = 0;
-  while ((opt = getopt(argc, argv, "d:q:e:n:h")) != -1) {
+  while ((opt = getopt(argc, argv, "d:q:e:n:o:Ch")) != -1) {
     switch (opt) {
     case 'd':
       d = optarg;
@@ -88,6 +107,12 @@ void parse_cmdline(int argc, char *const *argv) {
     case 'n':
       n = optarg;
       break;
+    case 'o':
+      outdir = optarg;
+      break;
+    case 'C':
+      usecache = 1;
+      break;
     case 'h':
       usage(0, 0);
       break;
@@ -104,6 +129,8 @@ void parse_cmdline(int argc, char *const *argv) {
     fname = argv[optind];
   else
     usage(1, "Error: please supply only one filename");
+  if (usecache && !fname)
+    usage(1, "Error: -C needs a FILE");
 
   /* qte */
   if (q) {
@@ -184,6 +211,190 @@ int do_row(intptr_t handle, int64_t rownum, char **col, int ncol) {
   return 0;
 }
 
+/*
+ * With -o dir, the values of each column are kept in memory until all
+ * rows are read, so that the type of each column is known by the time
+ * it is written out.
+ */
+typedef struct column_t column_t;
+struct column_t {
+  char *data;       /* data[] - values of this column, back to back */
+  int64_t datasz;   /* num used bytes in data[] */
+  int64_t datamax;  /* num allocated bytes in data[] */
+  int64_t *off;     /* off[r] - offset of value of row r in data[] */
+  int *len;         /* len[r] - length of value of row r; -1 for None */
+  int isint;        /* set while all values are integers */
+  int isnum;        /* set while all values are numbers */
+  int64_t nnull;    /* num None values */
+  int maxlen;       /* length of the longest value */
+};
+
+struct {
+  column_t *col;
+  int ncol;
+  int64_t nrow;   /* num rows read */
+  int64_t rowmax; /* num allocated elements in off[] and len[] */
+} tab = {0};
+
+static void *xrealloc(void *p, size_t sz) {
+  if (!(p = realloc(p, sz))) {
+    fatal("ERROR: out of memory\n");
+  }
+  return p;
+}
+
+int do_column(intptr_t handle, int64_t rownum, char **col, int ncol) {
+  (void)handle;
+  (void)rownum;
+
+  /* make room for one more row */
+  if (tab.nrow == tab.rowmax) {
+    tab.rowmax = tab.rowmax * 1.5 + 1024;
+    for (int i = 0; i < tab.ncol; i++) {
+      column_t *cp = &tab.col[i];
+      cp->off = xrealloc(cp->off, tab.rowmax * sizeof(*cp->off));
+      cp->len = xrealloc(cp->len, tab.rowmax * sizeof(*cp->len));
+    }
+  }
+
+  /* add new columns; they are None in the rows read so far */
+  if (ncol > tab.ncol) {
+    tab.col = xrealloc(tab.col, ncol * sizeof(*tab.col));
+    for (int i = tab.ncol; i < ncol; i++) {
+      column_t *cp = &tab.col[i];
+      memset(cp, 0, sizeof(*cp));
+      cp->isint = cp->isnum = 1;
+      cp->off = xrealloc(0, tab.rowmax * sizeof(*cp->off));
+      cp->len = xrealloc(0, tab.rowmax * sizeof(*cp->len));
+      for (int64_t r = 0; r < tab.nrow; r++) {
+        cp->off[r] = 0;
+        cp->len[r] = -1;
+      }
+      cp->nnull = tab.nrow;
+    }
+    tab.ncol = ncol;
+  }
+
+  const int64_t r = tab.nrow++;
+  for (int i = 0; i < tab.ncol; i++) {
+    column_t *cp = &tab.col[i];
+    const char *s = i < ncol ? col[i] : 0;
+    if (!s) {
+      cp->off[r] = 0;
+      cp->len[r] = -1;
+      cp->nnull++;
+      continue;
+    }
+
+    const int len = strlen(s);
+    int64_t ival;
+    double dval;
+    if (cp->isint && csvnum_int64(s, len, &ival)) {
+      cp->isint = 0;
+    }
+    if (cp->isnum && !cp->isint && csvnum_double(s, len, &dval)) {
+      cp->isnum = 0;
+    }
+
+    if (cp->datasz + len > cp->datamax) {
+      cp->datamax = (cp->datasz + len) * 1.5 + 4096;
+      cp->data = xrealloc(cp->data, cp->datamax);
+    }
+    memcpy(cp->data + cp->datasz, s, len);
+    cp->off[r] = cp->datasz;
+    cp->len[r] = len;
+    cp->datasz += len;
+    cp->maxlen = len > cp->maxlen ? len : cp->maxlen;
+  }
+
+  return 0;
+}
+
+/* write the .npy v1.0 header for a 1-d array */
+static void npy_header(csvwr_t *out, const char *descr, int64_t nrow) {
+  char hdr[200];
+  int n = sprintf(hdr, "{'descr': '%s', 'fortran_order': False, "
+                       "'shape': (%" PRId64 ",), }",
+                  descr, nrow);
+
+  /* pad with spaces and end with \n so the data is 64-byte aligned */
+  const int prefix = 10; /* magic, version and header length */
+  while ((prefix + n + 1) % 64) {
+    hdr[n++] = ' ';
+  }
+  hdr[n++] = '\n';
+
+  uint8_t hlen[2] = {n & 0xff, n >> 8};
+  csvwr_write(out, "\x93NUMPY\x01\x00", 8);
+  csvwr_write(out, hlen, 2);
+  csvwr_write(out, hdr, n);
+}
+
+static void write_column(column_t *cp, int fd) {
+  csvwr_t out;
+  char descr[30];
+  if (csvwr_init(&out, fd, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  if (cp->isint && cp->nnull == 0) {
+    npy_header(&out, "<i8", tab.nrow);
+    for (int64_t r = 0; r < tab.nrow; r++) {
+      int64_t v;
+      csvnum_int64(cp->data + cp->off[r], cp->len[r], &v);
+      csvwr_write(&out, &v, sizeof(v));
+    }
+  } else if (cp->isnum) {
+    npy_header(&out, "<f8", tab.nrow);
+    for (int64_t r = 0; r < tab.nrow; r++) {
+      double v = NAN;
+      if (cp->len[r] >= 0) {
+        csvnum_double(cp->data + cp->off[r], cp->len[r], &v);
+      }
+      csvwr_write(&out, &v, sizeof(v));
+    }
+  } else {
+    const int width = cp->maxlen ? cp->maxlen : 1;
+    sprintf(descr, "|S%d", width);
+    npy_header(&out, descr, tab.nrow);
+    for (int64_t r = 0; r < tab.nrow; r++) {
+      int len = cp->len[r] >= 0 ? cp->len[r] : 0;
+      csvwr_write(&out, cp->data + cp->off[r], len);
+      for (; len < width; len++) {
+        csvwr_putc(&out, 0);
+      }
+    }
+  }
+
+  if (csvwr_fini(&out)) {
+    fatal("ERROR: write - %s\n", strerror(out.err));
+  }
+}
+
+/* write each column to outdir/colN.npy */
+void write_npy(void) {
+  if (mkdir(outdir, 0777) && errno != EEXIST) {
+    fatal("ERROR: mkdir %s - %s\n", outdir, strerror(errno));
+  }
+
+  for (int i = 0; i < tab.ncol; i++) {
+    column_t *cp = &tab.col[i];
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/col%d.npy", outdir, i);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+      fatal("ERROR: open %s - %s\n", path, strerror(errno));
+    }
+    write_column(cp, fd);
+    close(fd);
+
+    free(cp->data);
+    free(cp->off);
+    free(cp->len);
+  }
+  free(tab.col);
+}
+
 void do_error(intptr_t handle, int errtype, const char *errmsg,
               csv_parse_t *cp) {
   (void)handle;
@@ -192,20 +403,43 @@ void do_error(intptr_t handle, int errtype, const char *errmsg,
   fatal("ERROR: %s\n", errmsg);
 }
 
-int main(int argc, char *argv[]) {
-  parse_cmdline(argc, argv);
-  FILE *fp = stdin;
+/* scan fname with csv_scan(), or through its parse cache with -C */
+static void scan(int (*on_row)(intptr_t handle, int64_t rownum, char **col,
+                               int ncol)) {
+  if (usecache) {
+    char errmsg[200];
+    csvcache_t *cache =
+        csvcache_open(fname, qte, esc, delim, nullstr, errmsg, sizeof(errmsg));
+    if (!cache) {
+      fatal("ERROR: %s\n", errmsg);
+    }
+    if (csvcache_scan(cache, 0, 0, 0, on_row)) {
+      fatal("ERROR: out of memory\n");
+    }
+    csvcache_close(cache);
+    return;
+  }
 
+  FILE *fp = stdin;
   if (fname && !(fp = fopen(fname, "r"))) {
     perr("ERROR: fopen %s - %s\n", fname, strerror(errno));
     exit(1);
   }
+  csv_scan((intptr_t)fp, qte, esc, delim, nullstr, do_read, on_row, do_error);
+  fclose(fp);
+}
 
-  printf("[\n");
-  csv_scan((intptr_t)fp, qte, esc, delim, nullstr, do_read, do_row, do_error);
-  printf("\n]\n\n");
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
 
-  fclose(fp);
+  if (outdir) {
+    scan(do_column);
+    write_npy();
+  } else {
+    printf("[\n");
+    scan(do_row);
+    printf("\n]\n\n");
+  }
 
   return 0;
 }
@@ -0,0 +1,314 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-x] [-s ringsz] [-b batchsz] [-d delim] [-q quote]\n\
+            [-e esc] [-n nullstr] NAME [FILE]\n\
+                        \n\
+                        \n\
+  Parse a csv file and hand the rows to a consumer process on the same\n\
+  host through a shared-memory ring called NAME. The rows are put in\n\
+  batches in the csvbin format; see csvshm.h and csvbin.h for the\n\
+  consumer side. With -x, act as the consumer and print the rows as csv.\n\
+                                           \n\
+  For example:                             \n\
+                                           \n\
+    %s /ring FILE &                        \n\
+    %s -x /ring                            \n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -x         : read the rows from the ring and print them as csv     \n\
+      -s ringsz  : specify ring size in KB; default to 65536             \n\
+      -b batchsz : specify batch size in KB; default to 1024             \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      -n nullstr : specify string representing null; default to \"\"     \n\
+      \n\
+  The -d, -q, -e and -n options apply to the csv input, or with -x, to\n\
+  the csv output.      \n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csv.h"
+#include "csvbin.h"
+#include "csvrd.h"
+#include "csvshm.h"
+#include "csvwr.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+const char *pname = 0;
+const char *fname = 0;
+const char *shmname = 0;
+int64_t ringsz = 65536 * 1024;
+int batchsz = 1024 * 1024;
+int qte = '"';
+int esc = 0;
+int delim = ',';
+char nullstr[20] = {0};
+int nullsz = 0;
+csvwr_dialect_t odialect; /* output dialect */
+int consume = 0;
+csvshm_t *pshm = 0; /* producer ring, aborted if we exit before finishing */
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname, pname, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d, *n;
+  q = e = d = n = 0;
+  while ((opt = getopt(argc, argv, "d:q:e:n:s:b:xh")) != -1) {
+    switch (opt) {
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'n':
+      n = optarg;
+      break;
+    case 's':
+      ringsz = strtoll(optarg, 0, 10) * 1024;
+      if (ringsz < 4 * 1024 || ringsz > INT32_MAX) {
+        usage(1, "Error: -s ringsz expects 4 to 2097151 KB.");
+      }
+      break;
+    case 'b':
+      batchsz = atoi(optarg) * 1024;
+      if (batchsz <= 0) {
+        usage(1, "Error: -b batchsz expects a positive number.");
+      }
+      break;
+    case 'x':
+      consume = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* name and fname */
+  if (optind == argc)
+    usage(1, "Error: please supply the ring NAME");
+  shmname = argv[optind++];
+  if (optind == argc)
+    ; /* read from stdin */
+  else if (optind + 1 == argc && !consume)
+    fname = argv[optind];
+  else
+    usage(1, "Error: please supply only one filename");
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+  esc = esc ? esc : qte;
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+
+  /* nullstr */
+  if (n) {
+    if (strlen(n) >= 20) {
+      usage(1, "Error: -n nullstr is too long. max is 19 chars");
+    }
+    strcpy(nullstr, n);
+  }
+  nullsz = strlen(nullstr);
+
+  odialect = (csvwr_dialect_t){qte, esc, delim, nullstr, nullsz};
+}
+
+/* atexit handler; wakes the consumer up if the producer has failed */
+static void abort_ring(void) {
+  if (pshm) {
+    csvshm_abort(pshm);
+  }
+}
+
+/* reserve room for a batch of n bytes in the ring */
+static char *reserve(csvshm_t *shm, int n) {
+  char *batch = csvshm_reserve(shm, n);
+  if (!batch) {
+    if (errno == EINVAL) {
+      fatal("ERROR: row is too big for the ring\n");
+    }
+    fatal("ERROR: ring - %s\n", strerror(errno));
+  }
+  return batch;
+}
+
+/* parse csv and put the rows into the ring */
+static void do_produce(int fd, csvshm_t *shm) {
+  csv_parse_t *cp = csv_open(qte, esc, delim, nullstr);
+  if (!cp) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  /* the current batch is batch[0..used) out of batch[0..cap) */
+  int cap = batchsz < csvshm_maxbatch(shm) ? batchsz : csvshm_maxbatch(shm);
+  char *batch = reserve(shm, cap);
+  int used = 0;
+
+  csvrd_t in;
+  if (csvrd_init(&in, fd, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  char *row;
+  int nb;
+  while ((nb = csvrd_line(&in, cp, &row)) > 0) {
+    int rowsz = csvbin_encode_csvrow(cp, batch + used, cap - used);
+    if (rowsz == 0) {
+      // batch is full; publish it and start a new one
+      csvshm_commit(shm, used);
+      int maxsz = csvbin_csvrow_maxsz(cp);
+      cap = maxsz > cap ? maxsz : cap;
+      batch = reserve(shm, cap);
+      used = 0;
+      rowsz = csvbin_encode_csvrow(cp, batch, cap);
+    }
+    if (rowsz < 0) {
+      fatal("ERROR: row is too big\n");
+    }
+    used += rowsz;
+  }
+  if (nb < 0) {
+    fatal("ERROR: %s\n", in.errmsg);
+  }
+
+  csvshm_commit(shm, used);
+  csvshm_finish(shm);
+  csvrd_fini(&in);
+  csv_close(cp);
+}
+
+/* take the rows out of the ring and print them as csv */
+static void do_consume(csvshm_t *shm, csvwr_t *out) {
+  const char *batch;
+  int n;
+  while ((n = csvshm_get(shm, &batch)) != 0) {
+    if (n < 0) {
+      fatal("ERROR: producer - %s\n", errno == ECANCELED
+                                          ? "failed"
+                                          : "exited without finishing");
+    }
+    while (n > 0) {
+      csvbin_row_t row;
+      int nb = csvbin_row(batch, n, &row);
+      if (nb <= 0) {
+        fatal("ERROR: malformed row in batch\n");
+      }
+      const char *val;
+      int len;
+      for (int i = 0; 0 == csvbin_next(&row, &val, &len); i++) {
+        if (i) {
+          csvwr_putc(out, delim);
+        }
+        csvwr_value(out, &odialect, len < 0 ? 0 : val, len);
+      }
+      csvwr_putc(out, '\n');
+      batch += nb;
+      n -= nb;
+    }
+    csvshm_release(shm);
+    if (out->err) {
+      fatal("ERROR: cannot write to stdout - %s\n", strerror(out->err));
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+
+  if (consume) {
+    csvwr_t out;
+    csvshm_t *shm = csvshm_attach(shmname, 10 * 1000);
+    if (!shm) {
+      fatal("ERROR: attach %s - %s\n", shmname, strerror(errno));
+    }
+    if (csvwr_init(&out, 1, 0)) {
+      fatal("ERROR: out of memory\n");
+    }
+    do_consume(shm, &out);
+    if (csvwr_fini(&out)) {
+      fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+    }
+    csvshm_close(shm);
+    return 0;
+  }
+
+  int fd = 0;
+  if (fname && (fd = open(fname, O_RDONLY)) < 0) {
+    perr("ERROR: open %s - %s\n", fname, strerror(errno));
+    exit(1);
+  }
+  csvshm_t *shm = csvshm_create(shmname, ringsz);
+  if (!shm) {
+    fatal("ERROR: create %s - %s\n", shmname, strerror(errno));
+  }
+  pshm = shm;
+  atexit(abort_ring);
+  do_produce(fd, shm);
+  pshm = 0;
+  csvshm_close(shm);
+  close(fd);
+  return 0;
+}
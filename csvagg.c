@@ -0,0 +1,1158 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-H] [-g cols] -a aggs [-d delim] [-q quote] [-e esc]\n\
+            [-n nullstr] [-j N] [FILE]\n\
+                        \n\
+                        \n\
+  Group the rows of a csv file by the values of columns cols, and print\n\
+  one row per group with the values of cols and of the aggregates aggs,\n\
+  as in SELECT cols, aggs FROM FILE GROUP BY cols. Without -g there is\n\
+  one group of all the rows. The groups are printed in the order they\n\
+  first appear.         \n\
+                        \n\
+  cols is a comma-separated list of column numbers from 1 or names in\n\
+  the header row. aggs is a comma-separated list of:\n\
+                        \n\
+      count      : num rows                    \n\
+      count:col  : num values of col that are not NULL                   \n\
+      sum:col    : sum of the values of col                              \n\
+      min:col    : min of the values of col                              \n\
+      max:col    : max of the values of col                              \n\
+      avg:col    : average of the values of col                          \n\
+                        \n\
+  NULLs and missing fields are left out, and a group with no values\n\
+  gets NULL. The values of sum, min, max and avg must be numbers; the\n\
+  result is an integer if all of them are integers.\n\
+                        \n\
+  The key bytes of each row are hashed into an open-addressing table\n\
+  that keeps short keys in the slot itself; the rows are taken in\n\
+  batches, and the values of each column in a batch are converted to\n\
+  numbers in one go. With -j, each thread aggregates its chunks into\n\
+  its own table, and the tables are merged at the end.\n\
+                        \n\
+  For example:          \n\
+                        \n\
+    %s -g region,day -a count,sum:amount,avg:amount FILE   \n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -H         : the first row is the header; print a header row       \n\
+      -g cols    : specify the key columns                               \n\
+      -a aggs    : specify the aggregates                                \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      -n nullstr : specify string representing null; default to \"\"     \n\
+      -j N       : aggregate using N threads; default to 1               \n\
+      \n\
+  If a column is given by name, the first row is the header.\n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csv.h"
+#include "csvnum.h"
+#include "csvwr.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAXCOL 1000000
+#define BATCH 1024                   /* rows aggregated at a time */
+#define CHUNKSZ (8 * 1024 * 1024)    /* bytes given to a thread at a time */
+#define KEYINL 16                    /* keys this short stay in the slot */
+#define ARENASZ (64 * 1024)          /* bytes in a block of long keys */
+
+const char *pname = 0;
+const char *fname = 0;
+int header = 0;
+int qte = '"';
+int esc = 0;
+int delim = ',';
+char nullstr[20] = {0};
+int nullsz = 0;
+csvwr_dialect_t odialect; /* output dialect */
+int njob = 1;
+
+/* a column given by number from 0, or by name until it is looked up in
+ * the header row */
+typedef struct colref_t colref_t;
+struct colref_t {
+  int col;
+  const char *name;
+};
+
+/* the key columns */
+colref_t *key = 0;
+int nkey = 0;
+
+/* the aggregates */
+enum { COUNT, COUNTCOL, SUM, MIN, MAX, AVG };
+typedef struct agg_t agg_t;
+struct agg_t {
+  int fn;
+  colref_t ref;
+  const char *text; /* as given in -a */
+};
+agg_t *agg = 0;
+int nagg = 0;
+
+/* the names of the columns in the header row */
+char **hdrname = 0;
+int nhdrname = 0;
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+/* parse a column number from 1 or a name in s */
+static colref_t parse_colref(const char *s, const char *msg) {
+  char *end;
+  long c = strtol(s, &end, 10);
+  if (!*s) {
+    usage(1, msg);
+  }
+  if (*end) {
+    header = 1;
+    return (colref_t){-1, s};
+  }
+  if (c <= 0 || c > MAXCOL) {
+    usage(1, msg);
+  }
+  return (colref_t){c - 1, 0};
+}
+
+/* parse the -g cols option */
+static void parse_keys(char *s) {
+  const char *msg = "Error: -g cols expects column numbers or names.";
+  for (char *tok = strtok(s, ","); tok; tok = strtok(0, ",")) {
+    if (!(key = realloc(key, (nkey + 1) * sizeof(*key)))) {
+      fatal("ERROR: out of memory\n");
+    }
+    key[nkey++] = parse_colref(tok, msg);
+  }
+}
+
+/* parse the -a aggs option */
+static void parse_aggs(char *s) {
+  static const char *fnname[] = {"count", "count", "sum",
+                                 "min",   "max",   "avg"};
+  const char *msg = "Error: -a aggs expects count, or sum, count, min, max "
+                    "or avg and :col.";
+  for (char *tok = strtok(s, ","); tok; tok = strtok(0, ",")) {
+    if (!(agg = realloc(agg, (nagg + 1) * sizeof(*agg)))) {
+      fatal("ERROR: out of memory\n");
+    }
+    agg_t *a = &agg[nagg++];
+    char *colon = strchr(tok, ':');
+    *a = (agg_t){-1, {-1, 0}, tok};
+    if (!colon) {
+      if (strcmp(tok, "count")) {
+        usage(1, msg);
+      }
+      a->fn = COUNT;
+      continue;
+    }
+    for (int fn = COUNTCOL; fn <= AVG; fn++) {
+      if ((int)strlen(fnname[fn]) == colon - tok &&
+          0 == memcmp(tok, fnname[fn], colon - tok)) {
+        a->fn = fn;
+      }
+    }
+    if (a->fn < 0) {
+      usage(1, msg);
+    }
+    a->ref = parse_colref(colon + 1, msg);
+  }
+  if (nagg == 0) {
+    usage(1, msg);
+  }
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d, *n, *g, *a, *j;
+  q = e = d = n = g = a = j = 0;
+  while ((opt = getopt(argc, argv, "g:a:d:q:e:n:j:Hh")) != -1) {
+    switch (opt) {
+    case 'g':
+      g = optarg;
+      break;
+    case 'a':
+      a = optarg;
+      break;
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'n':
+      n = optarg;
+      break;
+    case 'j':
+      j = optarg;
+      break;
+    case 'H':
+      header = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* cols and aggs */
+  if (g) {
+    parse_keys(g);
+  }
+  if (!a) {
+    usage(1, "Error: please supply -a aggs");
+  }
+  parse_aggs(a);
+
+  /* fname */
+  if (optind + 1 < argc) {
+    usage(1, "Error: too many args");
+  }
+  if (optind < argc && strcmp(argv[optind], "-")) {
+    fname = argv[optind];
+  }
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  esc = qte;
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+
+  /* nullstr */
+  if (n) {
+    if (strlen(n) >= 20) {
+      usage(1, "Error: -n nullstr is too long. max is 19 chars");
+    }
+    strcpy(nullstr, n);
+    nullsz = strlen(nullstr);
+  }
+
+  odialect = (csvwr_dialect_t){qte, esc, delim, nullstr, nullsz};
+
+  /* njob */
+  if (j) {
+    njob = atoi(j);
+    if (njob < 1 || njob > 256) {
+      usage(1, "Error: -j N expects a number between 1 and 256.");
+    }
+  }
+}
+
+/* ---------------------------------------------------------------- */
+/* the group table                                                  */
+
+/* the state of one aggregate of one group. For sum and avg, i is the
+ * sum while all values are integers and it does not overflow, and d + c
+ * is the sum as a double, where c makes up for the rounding in d. For
+ * min and max, the value is i if isint is set, else d. */
+typedef struct acc_t acc_t;
+struct acc_t {
+  int64_t n; /* num values, or num rows for count */
+  int64_t i;
+  double d, c;
+  int isint;
+};
+
+/* a slot of the table. The key is the encoded key columns (see
+ * encode_key()), kept in key.inl if it is short, else in an arena. */
+typedef struct slot_t slot_t;
+struct slot_t {
+  uint64_t hash; /* 0 for an empty slot */
+  uint32_t keysz;
+  uint32_t gid; /* the group is acc[gid * nagg ..] and first[gid] */
+  union {
+    char inl[KEYINL];
+    char *ptr;
+  } key;
+};
+
+typedef struct table_t table_t;
+struct table_t {
+  slot_t *slot;
+  int64_t nslot; /* a power of 2 */
+  int64_t ngroup, maxgroup;
+  acc_t *acc;
+  uint64_t *first; /* where the group first appears, for the order */
+  char **arena;    /* blocks of long keys */
+  int narena;
+  int arenatop; /* num bytes used in the last block */
+};
+
+static uint64_t hashkey(const char *s, int n) {
+  uint64_t h = 0x9e3779b97f4a7c15ULL ^ (uint64_t)n;
+  uint64_t x;
+  for (; n >= 8; s += 8, n -= 8) {
+    memcpy(&x, s, 8);
+    h = (h ^ x) * 0xff51afd7ed558ccdULL;
+    h ^= h >> 32;
+  }
+  if (n) {
+    x = 0;
+    memcpy(&x, s, n);
+    h = (h ^ x) * 0xc4ceb9fe1a85ec53ULL;
+  }
+  h ^= h >> 29;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 32;
+  return h | (1ULL << 63); /* not 0, which marks an empty slot */
+}
+
+static void table_init(table_t *t) {
+  memset(t, 0, sizeof(*t));
+  t->nslot = 1024;
+  if (posix_memalign((void **)&t->slot, 64, t->nslot * sizeof(slot_t))) {
+    fatal("ERROR: out of memory\n");
+  }
+  memset(t->slot, 0, t->nslot * sizeof(slot_t));
+}
+
+static void table_fini(table_t *t) {
+  for (int i = 0; i < t->narena; i++) {
+    free(t->arena[i]);
+  }
+  free(t->arena);
+  free(t->slot);
+  free(t->acc);
+  free(t->first);
+}
+
+static const char *slot_key(const slot_t *s) {
+  return s->keysz <= KEYINL ? s->key.inl : s->key.ptr;
+}
+
+/* double the slots, keeping the load under a half */
+static void table_grow(table_t *t) {
+  const int64_t nslot = t->nslot * 2;
+  slot_t *slot;
+  if (posix_memalign((void **)&slot, 64, nslot * sizeof(slot_t))) {
+    fatal("ERROR: out of memory\n");
+  }
+  memset(slot, 0, nslot * sizeof(slot_t));
+  for (int64_t i = 0; i < t->nslot; i++) {
+    if (t->slot[i].hash) {
+      uint64_t k = t->slot[i].hash & (nslot - 1);
+      while (slot[k].hash) {
+        k = (k + 1) & (nslot - 1);
+      }
+      slot[k] = t->slot[i];
+    }
+  }
+  free(t->slot);
+  t->slot = slot;
+  t->nslot = nslot;
+}
+
+/* copy a long key into the arena */
+static char *arena_copy(table_t *t, const char *key, int keysz) {
+  if (t->narena == 0 || t->arenatop + keysz > ARENASZ) {
+    const int sz = keysz > ARENASZ ? keysz : ARENASZ;
+    if (!(t->arena = realloc(t->arena, (t->narena + 1) * sizeof(char *))) ||
+        !(t->arena[t->narena] = malloc(sz))) {
+      fatal("ERROR: out of memory\n");
+    }
+    /* a key bigger than a block gets a block of its own, which is full */
+    t->narena++;
+    t->arenatop = keysz > ARENASZ ? ARENASZ : 0;
+    if (keysz > ARENASZ) {
+      memcpy(t->arena[t->narena - 1], key, keysz);
+      return t->arena[t->narena - 1];
+    }
+  }
+  char *p = t->arena[t->narena - 1] + t->arenatop;
+  memcpy(p, key, keysz);
+  t->arenatop += keysz;
+  return p;
+}
+
+/* find the group of key[0..keysz) with hash h, adding it if it is new.
+ * Returns its accs. */
+static acc_t *table_find(table_t *t, uint64_t h, const char *key, int keysz,
+                         uint64_t first) {
+  uint64_t k = h & (t->nslot - 1);
+  for (; t->slot[k].hash; k = (k + 1) & (t->nslot - 1)) {
+    const slot_t *s = &t->slot[k];
+    if (s->hash == h && s->keysz == (uint32_t)keysz &&
+        0 == memcmp(slot_key(s), key, keysz)) {
+      if (first < t->first[s->gid]) {
+        t->first[s->gid] = first;
+      }
+      return &t->acc[s->gid * nagg];
+    }
+  }
+
+  /* a new group */
+  if (t->ngroup == t->maxgroup) {
+    t->maxgroup = t->maxgroup ? t->maxgroup * 2 : 1024;
+    if (!(t->acc = realloc(t->acc, t->maxgroup * nagg * sizeof(acc_t))) ||
+        !(t->first = realloc(t->first, t->maxgroup * sizeof(uint64_t)))) {
+      fatal("ERROR: out of memory\n");
+    }
+  }
+  const int64_t gid = t->ngroup++;
+  slot_t *s = &t->slot[k];
+  s->hash = h;
+  s->keysz = keysz;
+  s->gid = gid;
+  if (keysz <= KEYINL) {
+    memcpy(s->key.inl, key, keysz);
+  } else {
+    s->key.ptr = arena_copy(t, key, keysz);
+  }
+  acc_t *acc = &t->acc[gid * nagg];
+  for (int i = 0; i < nagg; i++) {
+    acc[i] = (acc_t){0, 0, 0, 0, 1};
+  }
+  t->first[gid] = first;
+
+  if (t->ngroup * 2 > t->nslot) {
+    table_grow(t);
+  }
+  return acc;
+}
+
+/* ---------------------------------------------------------------- */
+/* aggregates                                                       */
+
+/* the kinds of a value */
+enum { V_NULL, V_INT, V_DOUBLE, V_BAD };
+
+/* compare x = (kind, i, d) with the min or max y */
+static int cmp(int kind, int64_t i, double d, const acc_t *y) {
+  if (kind == V_INT && y->isint) {
+    return (i > y->i) - (i < y->i);
+  }
+  return (d > y->d) - (d < y->d);
+}
+
+/* add x to the sum d + c of a, keeping the rounding error in c */
+static void add_double(acc_t *a, double x) {
+  const double t = a->d + x;
+  a->c += fabs(a->d) >= fabs(x) ? (a->d - t) + x : (x - t) + a->d;
+  a->d = t;
+}
+
+/* add a value to a; not for count */
+static void update(acc_t *a, int fn, int kind, int64_t i, double d) {
+  if (kind == V_NULL) {
+    return;
+  }
+  switch (fn) {
+  case SUM:
+  case AVG:
+    add_double(a, d);
+    if (a->isint &&
+        (kind != V_INT || __builtin_add_overflow(a->i, i, &a->i))) {
+      a->isint = 0;
+    }
+    break;
+  case MIN:
+  case MAX:
+    if (a->n == 0 || cmp(kind, i, d, a) == (fn == MIN ? -1 : 1)) {
+      a->i = i;
+      a->d = d;
+      a->isint = kind == V_INT;
+    }
+    break;
+  }
+  a->n++;
+}
+
+/* fold b into a */
+static void combine(acc_t *a, int fn, const acc_t *b) {
+  if (fn == COUNT || fn == COUNTCOL) {
+    a->n += b->n;
+    return;
+  }
+  if (b->n == 0) {
+    return;
+  }
+  if (a->n == 0) {
+    *a = *b;
+    return;
+  }
+  switch (fn) {
+  case SUM:
+  case AVG:
+    add_double(a, b->d);
+    a->c += b->c;
+    if (a->isint &&
+        (!b->isint || __builtin_add_overflow(a->i, b->i, &a->i))) {
+      a->isint = 0;
+    }
+    a->n += b->n;
+    return;
+  case MIN:
+  case MAX: {
+    const int n = a->n;
+    update(a, fn, b->isint ? V_INT : V_DOUBLE, b->i, b->d);
+    a->n = n + b->n;
+    return;
+  }
+  }
+}
+
+/* ---------------------------------------------------------------- */
+/* chunks                                                           */
+
+/*
+ * The input is cut into chunks at row boundaries, as in csvnorm. Each
+ * chunk slot is aggregated by its own thread into its own table.
+ */
+typedef struct chunk_t chunk_t;
+struct chunk_t {
+  char *buf;       /* buf[] - complete rows to aggregate */
+  int len;         /* num used bytes in buf[] */
+  int max;         /* num allocated bytes in buf[] */
+  int off;         /* rows start at buf[off]; it skips the header */
+  uint64_t seq;    /* num chunks before this one */
+  csv_parse_t *cp; /* parser for buf[] */
+  table_t tab;
+  char errmsg[100]; /* set if aggregate() failed */
+  pthread_t thread;
+
+  /* the batch: the encoded key of row r in keybuf[keyoff[r] ..
+   * keyoff[r + 1]), and the value of agg a at [a * BATCH + r] */
+  int nrow;
+  uint64_t first0; /* first of row 0 */
+  char *keybuf;
+  int keymax;
+  int keyoff[BATCH + 1];
+  uint64_t hash[BATCH];
+  const char **vptr;
+  int *vlen; /* -1 for NULL */
+  char *kind;
+  int64_t *ival;
+  double *dval;
+};
+
+/* the columns a row needs, each once, and where each key and agg finds
+ * its column in need[] */
+int *need = 0;
+int nneed = 0;
+int *keyneed = 0;
+int *aggneed = 0;
+
+static int add_need(int col) {
+  for (int i = 0; i < nneed; i++) {
+    if (need[i] == col) {
+      return i;
+    }
+  }
+  if (!(need = realloc(need, (nneed + 1) * sizeof(int)))) {
+    fatal("ERROR: out of memory\n");
+  }
+  need[nneed] = col;
+  return nneed++;
+}
+
+static void setup_need() {
+  if (!(keyneed = malloc((nkey + 1) * sizeof(int))) ||
+      !(aggneed = malloc(nagg * sizeof(int)))) {
+    fatal("ERROR: out of memory\n");
+  }
+  for (int i = 0; i < nkey; i++) {
+    keyneed[i] = add_need(key[i].col);
+  }
+  for (int i = 0; i < nagg; i++) {
+    aggneed[i] = agg[i].fn == COUNT ? -1 : add_need(agg[i].ref.col);
+  }
+}
+
+static void chunk_init(chunk_t *ck) {
+  memset(ck, 0, sizeof(*ck));
+  ck->cp = csv_open(qte, esc, delim, nullstr);
+  ck->vptr = malloc(nagg * BATCH * sizeof(*ck->vptr));
+  ck->vlen = malloc(nagg * BATCH * sizeof(*ck->vlen));
+  ck->kind = malloc(nagg * BATCH);
+  ck->ival = malloc(nagg * BATCH * sizeof(*ck->ival));
+  ck->dval = malloc(nagg * BATCH * sizeof(*ck->dval));
+  if (!ck->cp || !ck->vptr || !ck->vlen || !ck->kind || !ck->ival ||
+      !ck->dval) {
+    fatal("ERROR: out of memory\n");
+  }
+  table_init(&ck->tab);
+}
+
+static void chunk_fini(chunk_t *ck) {
+  csv_close(ck->cp);
+  table_fini(&ck->tab);
+  free(ck->buf);
+  free(ck->keybuf);
+  free(ck->vptr);
+  free(ck->vlen);
+  free(ck->kind);
+  free(ck->ival);
+  free(ck->dval);
+}
+
+/* convert the values of agg a in the batch to numbers */
+static void convert(chunk_t *ck, int a) {
+  const char **ptr = ck->vptr + a * BATCH;
+  const int *len = ck->vlen + a * BATCH;
+  char *kind = ck->kind + a * BATCH;
+  int64_t *ival = ck->ival + a * BATCH;
+  double *dval = ck->dval + a * BATCH;
+  const int n = ck->nrow;
+
+  if (agg[a].fn == COUNTCOL) {
+    for (int r = 0; r < n; r++) {
+      kind[r] = len[r] < 0 ? V_NULL : V_INT;
+    }
+    return;
+  }
+  for (int r = 0; r < n; r++) {
+    if (len[r] < 0) {
+      kind[r] = V_NULL;
+    } else if (0 == csvnum_int64(ptr[r], len[r], &ival[r])) {
+      kind[r] = V_INT;
+      dval[r] = ival[r];
+    } else if (0 == csvnum_double(ptr[r], len[r], &dval[r])) {
+      kind[r] = V_DOUBLE;
+    } else {
+      kind[r] = V_BAD;
+    }
+  }
+}
+
+/* aggregate the rows of the batch into the table */
+static int flush_batch(chunk_t *ck) {
+  table_t *t = &ck->tab;
+  const int n = ck->nrow;
+
+  for (int a = 0; a < nagg; a++) {
+    if (agg[a].fn != COUNT) {
+      convert(ck, a);
+    }
+  }
+
+  /* hash all keys first, and fetch their slots ahead of the probes */
+  for (int r = 0; r < n; r++) {
+    ck->hash[r] = hashkey(ck->keybuf + ck->keyoff[r],
+                          ck->keyoff[r + 1] - ck->keyoff[r]);
+    __builtin_prefetch(&t->slot[ck->hash[r] & (t->nslot - 1)]);
+  }
+
+  for (int r = 0; r < n; r++) {
+    acc_t *acc =
+        table_find(t, ck->hash[r], ck->keybuf + ck->keyoff[r],
+                   ck->keyoff[r + 1] - ck->keyoff[r], ck->first0 + r);
+    for (int a = 0; a < nagg; a++) {
+      const int x = a * BATCH + r;
+      if (agg[a].fn == COUNT) {
+        acc[a].n++;
+        continue;
+      }
+      if (ck->kind[x] == V_BAD) {
+        snprintf(ck->errmsg, sizeof(ck->errmsg),
+                 "%s: '%.*s' is not a number", agg[a].text,
+                 ck->vlen[x] > 20 ? 20 : ck->vlen[x], ck->vptr[x]);
+        return -1;
+      }
+      update(&acc[a], agg[a].fn, ck->kind[x], ck->ival[x], ck->dval[x]);
+    }
+  }
+  ck->nrow = 0;
+  return 0;
+}
+
+/* append the key of a row to the batch. Each key column is a varint of
+ * its length + 1, or 0 for NULL, and then its bytes. */
+static void encode_key(chunk_t *ck, const char **ptr, const int *len) {
+  int top = ck->keyoff[ck->nrow];
+  for (int i = 0; i < nkey; i++) {
+    const int k = keyneed[i];
+    const int sz = len[k] < 0 ? 0 : len[k];
+    if (top + sz + 5 > ck->keymax) {
+      ck->keymax = (top + sz + 5) * 2;
+      if (!(ck->keybuf = realloc(ck->keybuf, ck->keymax))) {
+        fatal("ERROR: out of memory\n");
+      }
+    }
+    for (uint32_t v = len[k] + 1;; v >>= 7) {
+      ck->keybuf[top++] = (v & 0x7f) | (v >= 0x80 ? 0x80 : 0);
+      if (v < 0x80) {
+        break;
+      }
+    }
+    memcpy(ck->keybuf + top, ptr[k], sz);
+    top += sz;
+  }
+  ck->keyoff[ck->nrow + 1] = top;
+}
+
+/* aggregate the rows in ck->buf[] into ck->tab */
+static void *aggregate(void *arg) {
+  chunk_t *ck = arg;
+  char *p = ck->buf + ck->off;
+  char *const q = ck->buf + ck->len;
+  const char *ptr[nneed + 1];
+  int len[nneed + 1];
+  int64_t row = 0;
+
+  ck->nrow = 0;
+  ck->first0 = ck->seq << 32;
+  ck->keyoff[0] = 0;
+  while (p < q) {
+    int nb = csv_line(ck->cp, p, q - p);
+    if (nb < 0) {
+      snprintf(ck->errmsg, sizeof(ck->errmsg), "%s", csv_errmsg(ck->cp));
+      return 0;
+    }
+    if (nb == 0) {
+      break;
+    }
+
+    /* the values the row needs; quoted ones are unquoted in place */
+    char **fld;
+    int *fldlen;
+    char *quoted;
+    const int nfld = csv_rawfields(ck->cp, &fld, &fldlen, &quoted);
+    for (int i = 0; i < nneed; i++) {
+      const int c = need[i];
+      ptr[i] = c < nfld ? fld[c] : 0;
+      len[i] = c < nfld ? fldlen[c] : -1;
+      if (len[i] == 0 ||
+          (len[i] == nullsz && 0 == memcmp(ptr[i], nullstr, nullsz))) {
+        len[i] = -1;
+      } else if (len[i] > 0 && quoted[c]) {
+        len[i] = csv_decode(ck->cp, fld[c], len[i], 1, fld[c]);
+      }
+    }
+
+    encode_key(ck, ptr, len);
+    for (int a = 0; a < nagg; a++) {
+      if (aggneed[a] >= 0) {
+        ck->vptr[a * BATCH + ck->nrow] = ptr[aggneed[a]];
+        ck->vlen[a * BATCH + ck->nrow] = len[aggneed[a]];
+      }
+    }
+    if (++ck->nrow == BATCH) {
+      if (flush_batch(ck)) {
+        return 0;
+      }
+      ck->first0 = (ck->seq << 32) + row + 1;
+      ck->keyoff[0] = 0;
+    }
+    row++;
+    p += nb;
+  }
+
+  if (ck->nrow && flush_batch(ck)) {
+    return 0;
+  }
+  if (p != q) {
+    snprintf(ck->errmsg, sizeof(ck->errmsg), "extra data after last row");
+  }
+  return 0;
+}
+
+/* make room for n bytes in buf[] of size *max */
+static char *expand(char *buf, int *max, int n) {
+  if (n <= *max) {
+    return buf;
+  }
+  if (!(buf = realloc(buf, n))) {
+    fatal("ERROR: out of memory\n");
+  }
+  *max = n;
+  return buf;
+}
+
+/* incomplete row at the end of a chunk, carried over to the next chunk */
+struct {
+  char *buf;
+  int len;
+  int max;
+} carry = {0};
+
+/*
+ * Fill ck->buf[] with the carried over row and more input, and cut it
+ * at the last complete row. sp is only used to locate row boundaries.
+ * At eof, a last row without a newline gets one. Return 1 on eof, 0
+ * otherwise.
+ */
+static int fill(chunk_t *ck, FILE *fp, csv_parse_t *sp) {
+  ck->buf = expand(ck->buf, &ck->max, CHUNKSZ);
+  if (carry.len >= ck->max) {
+    ck->buf = expand(ck->buf, &ck->max, carry.len * 2);
+  }
+  memcpy(ck->buf, carry.buf, carry.len);
+  ck->len = carry.len;
+  ck->off = 0;
+  carry.len = 0;
+
+  /* rows in buf[0 .. off) are complete */
+  int off = 0;
+  for (;;) {
+    int nb = fread(ck->buf + ck->len, 1, ck->max - ck->len, fp);
+    if (nb == 0 && ferror(fp)) {
+      fatal("ERROR: fread - %s\n", strerror(errno));
+    }
+    ck->len += nb;
+
+    while (off < ck->len) {
+      int n = csv_line(sp, ck->buf + off, ck->len - off);
+      if (n < 0) {
+        fatal("ERROR: %s\n", csv_errmsg(sp));
+      }
+      if (n == 0) {
+        break;
+      }
+      off += n;
+    }
+
+    if (nb == 0) {
+      if (ck->len && ck->buf[ck->len - 1] != '\n') {
+        ck->buf = expand(ck->buf, &ck->max, ck->len + 1);
+        ck->buf[ck->len++] = '\n';
+      }
+      return 1;
+    }
+
+    if (ck->len == ck->max) {
+      if (off > 0) {
+        break;
+      }
+      /* a single row spans the whole chunk */
+      ck->buf = expand(ck->buf, &ck->max, ck->max * 2);
+    }
+  }
+
+  /* carry the incomplete row over to the next chunk */
+  carry.buf = expand(carry.buf, &carry.max, ck->len - off);
+  carry.len = ck->len - off;
+  memcpy(carry.buf, ck->buf + off, carry.len);
+  ck->len = off;
+  return 0;
+}
+
+/* ---------------------------------------------------------------- */
+/* header and output                                                */
+
+/* take the header row off the first chunk, and look up the names */
+static void read_header(chunk_t *ck) {
+  int nb = ck->len ? csv_line(ck->cp, ck->buf, ck->len) : 0;
+  if (nb < 0) {
+    fatal("ERROR: %s\n", csv_errmsg(ck->cp));
+  }
+  ck->off = nb;
+  if (nb > 0) {
+    char **fld;
+    int *len;
+    char *quoted;
+    nhdrname = csv_rawfields(ck->cp, &fld, &len, &quoted);
+    if (!(hdrname = calloc(nhdrname, sizeof(char *)))) {
+      fatal("ERROR: out of memory\n");
+    }
+    for (int i = 0; i < nhdrname; i++) {
+      if (!(hdrname[i] = malloc(len[i] + 1))) {
+        fatal("ERROR: out of memory\n");
+      }
+      /* a NULL name is an empty one */
+      if (csv_decode(ck->cp, fld[i], len[i], quoted[i], hdrname[i]) < 0) {
+        hdrname[i][0] = 0;
+      }
+    }
+  }
+
+  colref_t *ref[nkey + nagg];
+  int nref = 0;
+  for (int i = 0; i < nkey; i++) {
+    ref[nref++] = &key[i];
+  }
+  for (int i = 0; i < nagg; i++) {
+    ref[nref++] = &agg[i].ref;
+  }
+  for (int i = 0; i < nref; i++) {
+    if (!ref[i]->name) {
+      continue;
+    }
+    for (int j = 0; j < nhdrname && ref[i]->col < 0; j++) {
+      if (0 == strcmp(hdrname[j], ref[i]->name)) {
+        ref[i]->col = j;
+      }
+    }
+    if (ref[i]->col < 0) {
+      fatal("ERROR: no column named '%s'\n", ref[i]->name);
+    }
+  }
+}
+
+static void put_double(csvwr_t *out, double d) {
+  char tmp[40];
+  snprintf(tmp, sizeof(tmp), "%.15g", d);
+  if (strtod(tmp, 0) != d) {
+    snprintf(tmp, sizeof(tmp), "%.17g", d);
+  }
+  csvwr_puts(out, tmp);
+}
+
+static void put_int(csvwr_t *out, int64_t i) {
+  char tmp[24];
+  snprintf(tmp, sizeof(tmp), "%" PRId64, i);
+  csvwr_puts(out, tmp);
+}
+
+static void put_header(csvwr_t *out) {
+  for (int i = 0; i < nkey; i++) {
+    const int c = key[i].col;
+    if (i) {
+      csvwr_putc(out, delim);
+    }
+    if (c < nhdrname) {
+      csvwr_value(out, &odialect, hdrname[c], strlen(hdrname[c]));
+    } else {
+      char tmp[20];
+      snprintf(tmp, sizeof(tmp), "c%d", c + 1);
+      csvwr_puts(out, tmp);
+    }
+  }
+  for (int i = 0; i < nagg; i++) {
+    if (nkey || i) {
+      csvwr_putc(out, delim);
+    }
+    const char *colon = strchr(agg[i].text, ':');
+    char tmp[strlen(agg[i].text) + 3];
+    if (colon) {
+      sprintf(tmp, "%.*s(%s)", (int)(colon - agg[i].text), agg[i].text,
+              colon + 1);
+    } else {
+      strcpy(tmp, agg[i].text);
+    }
+    csvwr_value(out, &odialect, tmp, strlen(tmp));
+  }
+  csvwr_putc(out, '\n');
+}
+
+static void put_group(csvwr_t *out, const slot_t *s, const acc_t *acc) {
+  const uint8_t *k = (const uint8_t *)slot_key(s);
+  for (int i = 0; i < nkey; i++) {
+    uint32_t v = 0;
+    for (int shift = 0;; shift += 7) {
+      const int b = *k++;
+      v |= (uint32_t)(b & 0x7f) << shift;
+      if (!(b & 0x80)) {
+        break;
+      }
+    }
+    if (i) {
+      csvwr_putc(out, delim);
+    }
+    if (v == 0) {
+      csvwr_write(out, nullstr, nullsz);
+    } else {
+      csvwr_value(out, &odialect, (const char *)k, v - 1);
+      k += v - 1;
+    }
+  }
+  for (int i = 0; i < nagg; i++) {
+    const acc_t *a = &acc[i];
+    if (nkey || i) {
+      csvwr_putc(out, delim);
+    }
+    if (agg[i].fn == COUNT || agg[i].fn == COUNTCOL) {
+      put_int(out, a->n);
+    } else if (a->n == 0) {
+      csvwr_write(out, nullstr, nullsz);
+    } else if (agg[i].fn == AVG) {
+      put_double(out, (a->isint ? (double)a->i : a->d + a->c) / a->n);
+    } else if (a->isint) {
+      put_int(out, a->i);
+    } else {
+      put_double(out, agg[i].fn == SUM ? a->d + a->c : a->d);
+    }
+  }
+  csvwr_putc(out, '\n');
+}
+
+/* the table whose groups are sorted by cmp_first() */
+table_t *sorttab = 0;
+
+static int cmp_first(const void *x, const void *y) {
+  const uint64_t a = sorttab->first[((const slot_t *)x)->gid];
+  const uint64_t b = sorttab->first[((const slot_t *)y)->gid];
+  return a < b ? -1 : a > b;
+}
+
+/* merge the tables into the first one, and print the groups */
+static void output(chunk_t *chunk) {
+  table_t *t = &chunk[0].tab;
+  for (int j = 1; j < njob; j++) {
+    const table_t *u = &chunk[j].tab;
+    for (int64_t k = 0; k < u->nslot; k++) {
+      const slot_t *s = &u->slot[k];
+      if (s->hash) {
+        acc_t *acc =
+            table_find(t, s->hash, slot_key(s), s->keysz, u->first[s->gid]);
+        for (int i = 0; i < nagg; i++) {
+          combine(&acc[i], agg[i].fn, &u->acc[s->gid * nagg + i]);
+        }
+      }
+    }
+  }
+
+  /* the groups in the order they first appear */
+  slot_t *group = malloc((t->ngroup + 1) * sizeof(slot_t));
+  int64_t ngroup = 0;
+  if (!group) {
+    fatal("ERROR: out of memory\n");
+  }
+  for (int64_t k = 0; k < t->nslot; k++) {
+    if (t->slot[k].hash) {
+      group[ngroup++] = t->slot[k];
+    }
+  }
+  sorttab = t;
+  qsort(group, ngroup, sizeof(slot_t), cmp_first);
+
+  csvwr_t out;
+  if (csvwr_init(&out, 1, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+  if (header) {
+    put_header(&out);
+  }
+  for (int64_t g = 0; g < ngroup; g++) {
+    put_group(&out, &group[g], &t->acc[group[g].gid * nagg]);
+    if (out.err) {
+      fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+    }
+  }
+  if (csvwr_fini(&out)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+  free(group);
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+  FILE *fp = stdin;
+  if (fname && 0 == (fp = fopen(fname, "r"))) {
+    fatal("ERROR: open %s - %s\n", fname, strerror(errno));
+  }
+
+  csv_parse_t *sp = csv_open(qte, esc, delim, nullstr);
+  chunk_t *chunk = calloc(njob, sizeof(*chunk));
+  if (!sp || !chunk) {
+    fatal("ERROR: out of memory\n");
+  }
+  for (int i = 0; i < njob; i++) {
+    chunk_init(&chunk[i]);
+  }
+
+  int eof = 0;
+  uint64_t seq = 0;
+  while (!eof) {
+    /* start a job on each chunk as soon as it is filled */
+    int n = 0;
+    while (n < njob && !eof) {
+      chunk_t *ck = &chunk[n++];
+      eof = fill(ck, fp, sp);
+      ck->seq = seq++;
+      if (ck->seq == 0) {
+        if (header) {
+          read_header(ck);
+        }
+        setup_need();
+      }
+      if (njob == 1) {
+        aggregate(ck);
+      } else if (pthread_create(&ck->thread, 0, aggregate, ck)) {
+        fatal("ERROR: pthread_create failed\n");
+      }
+    }
+
+    for (int i = 0; i < n; i++) {
+      chunk_t *ck = &chunk[i];
+      if (njob > 1) {
+        pthread_join(ck->thread, 0);
+      }
+      if (ck->errmsg[0]) {
+        fatal("ERROR: %s\n", ck->errmsg);
+      }
+    }
+  }
+
+  output(chunk);
+
+  for (int i = 0; i < njob; i++) {
+    chunk_fini(&chunk[i]);
+  }
+  for (int i = 0; i < nhdrname; i++) {
+    free(hdrname[i]);
+  }
+  free(hdrname);
+  free(chunk);
+  free(carry.buf);
+  free(key);
+  free(agg);
+  free(need);
+  free(keyneed);
+  free(aggneed);
+  csv_close(sp);
+  fclose(fp);
+  return 0;
+}
@@ -0,0 +1,154 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#include "csvbin.h"
+
+/* little-endian on any host; a single store on x86 and arm */
+static inline void put32(char *p, uint32_t v) {
+  p[0] = (char)v;
+  p[1] = (char)(v >> 8);
+  p[2] = (char)(v >> 16);
+  p[3] = (char)(v >> 24);
+}
+
+int csvbin_put_header(csvwr_t *wr) {
+  return csvwr_write(wr, CSVBIN_MAGIC, CSVBIN_MAGICSZ);
+}
+
+int csvbin_put_row(csvwr_t *wr, char *const *field, const int *len,
+                   int nfield) {
+  int64_t rowsz = 4;
+  for (int i = 0; i < nfield; i++) {
+    rowsz += 4 + (len[i] < 0 ? 0 : len[i]);
+  }
+  if (rowsz + 4 > INT32_MAX || csvwr_room(wr, rowsz + 4)) {
+    return -1;
+  }
+
+  char *p = wr->buf + wr->top;
+  put32(p, rowsz);
+  put32(p + 4, nfield);
+  p += 8;
+  for (int i = 0; i < nfield; i++) {
+    if (len[i] < 0) {
+      put32(p, CSVBIN_NULL);
+      p += 4;
+      continue;
+    }
+    put32(p, len[i]);
+    memcpy(p + 4, field[i], len[i]);
+    p += 4 + len[i];
+  }
+  wr->top = p - wr->buf;
+  return 0;
+}
+
+int csvbin_csvrow_maxsz(csv_parse_t *cp) {
+  char **fld;
+  int *len;
+  char *quoted;
+  const int nfield = csv_rawfields(cp, &fld, &len, &quoted);
+
+  /* decoded values are never longer than the raw fields. Leave room
+   * for the NUL that csv_decode() puts after the last value. */
+  int64_t maxsz = 8 + 1;
+  for (int i = 0; i < nfield; i++) {
+    maxsz += 4 + len[i];
+  }
+  return maxsz > INT32_MAX ? -1 : maxsz;
+}
+
+int csvbin_encode_csvrow(csv_parse_t *cp, char *buf, int bufsz) {
+  char **fld;
+  int *len;
+  char *quoted;
+  const int maxsz = csvbin_csvrow_maxsz(cp);
+  const int nfield = csv_rawfields(cp, &fld, &len, &quoted);
+  if (maxsz < 0) {
+    return -1;
+  }
+  if (maxsz > bufsz) {
+    return 0;
+  }
+
+  char *p = buf + 8;
+  for (int i = 0; i < nfield; i++) {
+    int n = csv_decode(cp, fld[i], len[i], quoted[i], p + 4);
+    if (n < 0) {
+      put32(p, CSVBIN_NULL);
+      p += 4;
+      continue;
+    }
+    put32(p, n);
+    p += 4 + n;
+  }
+  put32(buf, p - buf - 4);
+  put32(buf + 4, nfield);
+  return p - buf;
+}
+
+int csvbin_put_csvrow(csvwr_t *wr, csv_parse_t *cp) {
+  const int maxsz = csvbin_csvrow_maxsz(cp);
+  if (maxsz < 0 || csvwr_room(wr, maxsz)) {
+    return -1;
+  }
+  wr->top += csvbin_encode_csvrow(cp, wr->buf + wr->top, maxsz);
+  return 0;
+}
+
+int csvbin_check_header(const char *buf, int bufsz) {
+  if (bufsz < CSVBIN_MAGICSZ) {
+    return memcmp(buf, CSVBIN_MAGIC, bufsz) ? -1 : 0;
+  }
+  return memcmp(buf, CSVBIN_MAGIC, CSVBIN_MAGICSZ) ? -1 : CSVBIN_MAGICSZ;
+}
+
+int csvbin_row(const char *buf, int bufsz, csvbin_row_t *row) {
+  if (bufsz < 8) {
+    return 0;
+  }
+  const uint32_t rowsz = csvbin_get32(buf);
+  const uint32_t nfield = csvbin_get32(buf + 4);
+  if (rowsz < 4 || rowsz > INT32_MAX - 4 || nfield > (rowsz - 4) / 4) {
+    return -1;
+  }
+  if ((int64_t)rowsz + 4 > bufsz) {
+    return 0;
+  }
+
+  /* check that the fields add up to rowsz so csvbin_next() stays
+   * inside the row */
+  const char *p = buf + 8;
+  const char *const q = buf + 4 + rowsz;
+  for (uint32_t i = 0; i < nfield; i++) {
+    if (q - p < 4) {
+      return -1;
+    }
+    const uint32_t n = csvbin_get32(p);
+    p += 4;
+    if (n != CSVBIN_NULL) {
+      if (n > (uint32_t)(q - p)) {
+        return -1;
+      }
+      p += n;
+    }
+  }
+  if (p != q) {
+    return -1;
+  }
+
+  row->nfield = nfield;
+  row->next = 0;
+  row->p = buf + 8;
+  row->q = q;
+  return 4 + rowsz;
+}
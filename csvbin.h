@@ -0,0 +1,145 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#ifndef CSVBIN_H
+#define CSVBIN_H
+
+/*
+
+  A length-prefixed binary row format for passing parsed rows between
+  processes. A csv file is parsed once; later stages walk the fields
+  of each row directly, without scanning for delims and quotes.
+
+  A stream is the 8-byte magic CSVBIN_MAGIC followed by rows. All
+  integers are 32-bit little-endian. Each row is:
+
+      rowsz          : num bytes in the rest of the row
+      nfield         : num fields
+      nfield x {
+        len          : num bytes in value, or CSVBIN_NULL
+        value[len]   : the bytes of the unquoted value; absent for NULL
+      }
+
+  Values are not NUL terminated.
+
+  General usage for the writer:
+
+     csvbin_put_header()
+         csvbin_put_row() / csvbin_put_csvrow()
+         ...
+
+  and for the reader:
+
+     csvbin_check_header()
+         csvbin_row()
+             csvbin_next()
+             csvbin_next()
+             ...
+         csvbin_row()
+         ...
+
+*/
+
+#include "csv.h"
+#include "csvwr.h"
+#include <string.h>
+
+#define CSVBIN_MAGIC "CSVBIN1\n"
+#define CSVBIN_MAGICSZ 8
+#define CSVBIN_NULL 0xffffffffu
+
+typedef struct csvbin_row_t csvbin_row_t;
+struct csvbin_row_t {
+  int nfield;    /* num fields in row */
+  int next;      /* index of the field to be returned by csvbin_next() */
+  const char *p; /* start of the next field */
+  const char *q; /* end of row */
+};
+
+/**
+ * Write the stream header. Returns 0 on success, -1 on error.
+ */
+CSV_EXTERN int csvbin_put_header(csvwr_t *wr);
+
+/**
+ * Write a row of nfield values. A value is field[i][0..len[i]), or
+ * NULL if len[i] is -1. Returns 0 on success, -1 on error.
+ */
+CSV_EXTERN int csvbin_put_row(csvwr_t *wr, char *const *field, const int *len,
+                              int nfield);
+
+/**
+ * Write the row last parsed by csv_line(). Quoted fields are decoded
+ * straight into the writer's buffer. Returns 0 on success, -1 on error.
+ */
+CSV_EXTERN int csvbin_put_csvrow(csvwr_t *wr, csv_parse_t *cp);
+
+/**
+ * Get the most bytes csvbin_encode_csvrow() may need for the row last
+ * parsed by csv_line(), or -1 if the row is too big.
+ */
+CSV_EXTERN int csvbin_csvrow_maxsz(csv_parse_t *cp);
+
+/**
+ * Encode the row last parsed by csv_line() into buf[0..bufsz). Returns
+ * the #bytes in the encoded row, 0 if bufsz is less than
+ * csvbin_csvrow_maxsz(), or -1 if the row is too big.
+ */
+CSV_EXTERN int csvbin_encode_csvrow(csv_parse_t *cp, char *buf, int bufsz);
+
+/**
+ * Check the stream header at buf[0..bufsz). Returns the size of the
+ * header, 0 if buf is too short to tell, or -1 if it is not a csvbin
+ * stream.
+ */
+CSV_EXTERN int csvbin_check_header(const char *buf, int bufsz);
+
+/**
+ * Locate the next row at buf[0..bufsz). Returns
+ *    a) a positive integer indicating #bytes in the row,
+ *    b) 0 if buf does not have a complete row, or
+ *    c) -1 if the row is malformed.
+ *
+ * On success, row is set up for csvbin_next(). The row refers to buf[],
+ * which must stay put until the fields have been read.
+ */
+CSV_EXTERN int csvbin_row(const char *buf, int bufsz, csvbin_row_t *row);
+
+static inline uint32_t csvbin_get32(const char *p) {
+  const unsigned char *u = (const unsigned char *)p;
+  return u[0] | (uint32_t)u[1] << 8 | (uint32_t)u[2] << 16 |
+         (uint32_t)u[3] << 24;
+}
+
+/**
+ * Get the next field of row. Returns 0 on success, or -1 if there are
+ * no more fields. The value is returned in val[0..len) and points into
+ * the row; len is -1 for NULL.
+ */
+static inline int csvbin_next(csvbin_row_t *row, const char **val, int *len) {
+  if (row->next >= row->nfield) {
+    return -1;
+  }
+  const uint32_t n = csvbin_get32(row->p);
+  row->p += 4;
+  *val = row->p;
+  if (n == CSVBIN_NULL) {
+    *len = -1;
+  } else {
+    *len = n;
+    row->p += n;
+  }
+  row->next++;
+  return 0;
+}
+
+#endif /*CSVBIN_H*/
@@ -0,0 +1,283 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#define _GNU_SOURCE
+#include "csvbloom.h"
+#include "csvside.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define MAGIC "CSVBLM1\n"
+#define LINESZ 64 /* bytes in a cache line */
+
+/* the sidecar starts with this header; the filters follow, each
+ * nline cache lines */
+typedef struct header_t header_t;
+struct header_t {
+  csvside_id_t id;
+  /* what is indexed */
+  int32_t col;
+  int32_t unused;
+  int64_t stride;
+  /* shape */
+  int64_t nblock;
+  int64_t nline; /* num cache lines per filter */
+  char pad[16];  /* so the filters are cache line aligned */
+};
+
+struct csvbloom_t {
+  header_t *hdr;
+  int64_t hdrsz; /* num bytes in the sidecar */
+  int mapped;    /* hdr is mmap'ed, else malloc'ed */
+  const uint64_t *filter;
+  int hit;
+};
+
+static inline uint64_t fmix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+uint64_t csvbloom_hash(const char *key, int len) {
+  uint64_t h = 0x9e3779b97f4a7c15ull ^ (uint64_t)len;
+  for (; len >= 8; key += 8, len -= 8) {
+    uint64_t v;
+    memcpy(&v, key, 8);
+    h = (h ^ v) * 0x9e3779b97f4a7c15ull;
+    h ^= h >> 29;
+  }
+  uint64_t v = 0;
+  memcpy(&v, key, len);
+  return fmix(h ^ v);
+}
+
+/* the cache line of hash h in a filter; the top bits pick the line and
+ * 7 runs of 9 bits of a second hash pick the bits in it */
+static inline const uint64_t *line_of(const csvbloom_t *bloom, int64_t k,
+                                      uint64_t h) {
+  const int64_t nline = bloom->hdr->nline;
+  const uint64_t i = ((h >> 32) * (uint64_t)nline) >> 32;
+  return bloom->filter + (k * nline + i) * (LINESZ / 8);
+}
+
+static inline void add_key(csvbloom_t *bloom, int64_t k, uint64_t h) {
+  uint64_t *line = (uint64_t *)line_of(bloom, k, h);
+  uint64_t b = h * 0x9e3779b97f4a7c15ull;
+  for (int i = 0; i < CSVBLOOM_K; i++, b >>= 9) {
+    line[(b >> 6) & 7] |= 1ull << (b & 63);
+  }
+}
+
+int csvbloom_test(csvbloom_t *bloom, int64_t k, uint64_t h) {
+  const uint64_t *line = line_of(bloom, k, h);
+  uint64_t b = h * 0x9e3779b97f4a7c15ull;
+  for (int i = 0; i < CSVBLOOM_K; i++, b >>= 9) {
+    if (!(line[(b >> 6) & 7] & (1ull << (b & 63)))) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static inline int64_t sidecar_size(const header_t *hdr) {
+  return sizeof(header_t) + hdr->nblock * hdr->nline * LINESZ;
+}
+
+/* map the sidecar at path if it matches want. Returns 0 on success. */
+static int load_sidecar(csvbloom_t *bloom, const char *path,
+                        const header_t *want) {
+  int64_t size;
+  header_t *hdr = csvside_map(path, sizeof(header_t), &size);
+  if (!hdr) {
+    return -1;
+  }
+  if (!csvside_match(&hdr->id, &want->id) || hdr->col != want->col ||
+      hdr->stride != want->stride || hdr->nline != want->nline ||
+      hdr->nblock < 0 || sidecar_size(hdr) != size) {
+    munmap(hdr, size);
+    return -1;
+  }
+
+  bloom->hdr = hdr;
+  bloom->hdrsz = size;
+  bloom->mapped = 1;
+  bloom->filter = (const uint64_t *)(hdr + 1);
+  return 0;
+}
+
+/* make room for filters of blocks [0, nblock) */
+static int grow(csvbloom_t *bloom, int64_t nblock, int64_t *maxblock) {
+  if (nblock <= *maxblock) {
+    return 0;
+  }
+  const int64_t blocksz = bloom->hdr->nline * LINESZ;
+  int64_t max = *maxblock * 1.5 + 16;
+  max = max > nblock ? max : nblock;
+  char *p = realloc(bloom->hdr, sizeof(header_t) + max * blocksz);
+  if (!p) {
+    return -1;
+  }
+  memset(p + sizeof(header_t) + *maxblock * blocksz, 0,
+         (max - *maxblock) * blocksz);
+  bloom->hdr = (header_t *)p;
+  bloom->filter = (const uint64_t *)(bloom->hdr + 1);
+  *maxblock = max;
+  return 0;
+}
+
+/* scan the csv file in fd and add the keys of each row to its filter */
+static int scan_file(csvbloom_t *bloom, csv_parse_t *cp, int fd,
+                     char *errbuf, int errbufsz) {
+  const int col = bloom->hdr->col;
+  const int64_t stride = bloom->hdr->stride;
+  int64_t maxblock = 0;
+  char *scratch = 0;
+  int scratchmax = 0;
+  int ret = -1;
+
+  csvside_scan_t sc;
+  if (csvside_scan_open(&sc, fd, 0, bloom->hdr->id.fsize, errbuf,
+                        errbufsz)) {
+    return -1;
+  }
+  const char *row;
+  int nb;
+  while ((nb = csvside_scan_next(&sc, cp, &row, errbuf, errbufsz)) > 0) {
+    const int64_t k = (sc.rownum - 1) / stride;
+    if (grow(bloom, k + 1, &maxblock)) {
+      csvside_seterr(errbuf, errbufsz, "out of memory");
+      goto bail;
+    }
+    bloom->hdr->nblock = k + 1;
+
+    char **field;
+    int *len;
+    char *quoted;
+    if (col < csv_rawfields(cp, &field, &len, &quoted)) {
+      if (len[col] >= scratchmax) {
+        scratchmax = len[col] * 1.5 + 64;
+        char *p = realloc(scratch, scratchmax);
+        if (!p) {
+          csvside_seterr(errbuf, errbufsz, "out of memory");
+          goto bail;
+        }
+        scratch = p;
+      }
+      int n = csv_decode(cp, field[col], len[col], quoted[col], scratch);
+      if (n >= 0) {
+        add_key(bloom, k, csvbloom_hash(scratch, n));
+      }
+    }
+  }
+  ret = nb;
+
+bail:
+  csvside_scan_close(&sc);
+  free(scratch);
+  return ret;
+}
+
+/* scan the csv file in fd and lay out the sidecar in memory */
+static int build_sidecar(csvbloom_t *bloom, int fd, const header_t *want,
+                         char *errbuf, int errbufsz) {
+  const csvside_id_t *id = &want->id;
+  csv_parse_t *cp = csv_open(id->qte, id->esc, id->delim, id->nullstr);
+  if (!cp || !(bloom->hdr = malloc(sizeof(header_t)))) {
+    csvside_seterr(errbuf, errbufsz, "out of memory");
+    csv_close(cp);
+    return -1;
+  }
+  *bloom->hdr = *want;
+
+  int ret = scan_file(bloom, cp, fd, errbuf, errbufsz);
+  csv_close(cp);
+  bloom->hdrsz = sidecar_size(bloom->hdr);
+  bloom->filter = (const uint64_t *)(bloom->hdr + 1);
+  return ret;
+}
+
+csvbloom_t *csvbloom_open(const char *path, int qte, int esc, int delim,
+                          const char nullstr[20], int col, int64_t stride,
+                          char *errbuf, int errbufsz) {
+  csvbloom_t *bloom = calloc(1, sizeof(*bloom));
+  int fd = -1;
+  char *sidecar = 0;
+  if (!bloom || !(sidecar = malloc(strlen(path) + 10))) {
+    csvside_seterr(errbuf, errbufsz, "out of memory");
+    goto bail;
+  }
+  sprintf(sidecar, "%s.csvbloom", path);
+  if (col < 0 || stride <= 0) {
+    csvside_seterr(errbuf, errbufsz, "bad column %d or stride %" PRId64, col,
+                   stride);
+    goto bail;
+  }
+
+  header_t want;
+  memset(&want, 0, sizeof(want));
+  if ((fd = open(path, O_RDONLY)) < 0 ||
+      csvside_identity(&want.id, MAGIC, fd, qte, esc, delim, nullstr)) {
+    csvside_seterr(errbuf, errbufsz, "open %s - %s", path, strerror(errno));
+    goto bail;
+  }
+  want.col = col;
+  want.stride = stride;
+  want.nline = (stride * CSVBLOOM_BITS + LINESZ * 8 - 1) / (LINESZ * 8);
+  if (0 == load_sidecar(bloom, sidecar, &want)) {
+    bloom->hit = 1;
+  } else {
+    if (build_sidecar(bloom, fd, &want, errbuf, errbufsz)) {
+      goto bail;
+    }
+    csvside_save(sidecar, bloom->hdr, bloom->hdrsz);
+  }
+
+  close(fd);
+  free(sidecar);
+  return bloom;
+
+bail:
+  if (fd >= 0) {
+    close(fd);
+  }
+  free(sidecar);
+  csvbloom_close(bloom);
+  return 0;
+}
+
+void csvbloom_close(csvbloom_t *bloom) {
+  if (!bloom) {
+    return;
+  }
+  if (bloom->hdr) {
+    if (bloom->mapped) {
+      munmap(bloom->hdr, bloom->hdrsz);
+    } else {
+      free(bloom->hdr);
+    }
+  }
+  free(bloom);
+}
+
+int csvbloom_hit(csvbloom_t *bloom) { return bloom->hit; }
+
+int64_t csvbloom_nblock(csvbloom_t *bloom) { return bloom->hdr->nblock; }
@@ -0,0 +1,92 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#ifndef CSVBLOOM_H
+#define CSVBLOOM_H
+
+/*
+
+  Bloom filters over the values of a key column of a csv file, one per
+  block of N rows, saved in a sidecar file FILE.csvbloom. A point
+  lookup tests each block's filter and parses only the blocks that may
+  hold the key. The blocks are those of the sparse row index with the
+  same N (see csvidx.h), so a candidate block is read with
+  csvidx_read_rows().
+
+  Each filter is blocked: a key sets CSVBLOOM_K bits in a single 64-byte
+  cache line picked by its hash, so a test reads one cache line. There
+  are about CSVBLOOM_BITS bits per row, which gives a false positive
+  rate of about 1% per block.
+
+  The sidecar is used only if the size, mtime, inode and device of
+  FILE, the dialect, the column and N are unchanged. Otherwise it is
+  rebuilt.
+
+  General usage:
+
+     csvbloom_open()
+         h = csvbloom_hash()
+         csvbloom_test(k, h) for each block k
+         ...
+     csvbloom_close()
+
+*/
+
+#include "csv.h"
+
+#define CSVBLOOM_BITS 10 /* bits per row */
+#define CSVBLOOM_K 7     /* bits set per key */
+
+typedef struct csvbloom_t csvbloom_t;
+
+/**
+ * Open the filters on column col, numbered from 0, of the csv file at
+ * path, with a filter every stride rows. If there is no valid sidecar,
+ * the file is scanned and the sidecar is saved next to it; if the
+ * sidecar cannot be saved, the filters are kept in memory only.
+ *
+ * Params qte, esc, delim and nullstr are as in csv_open(); NULL
+ * values are not added. Returns NULL on error, with a message in
+ * errbuf[0..errbufsz).
+ */
+CSV_EXTERN csvbloom_t *csvbloom_open(const char *path, int qte, int esc,
+                                     int delim, const char nullstr[20],
+                                     int col, int64_t stride, char *errbuf,
+                                     int errbufsz);
+
+/**
+ * Release the filters.
+ */
+CSV_EXTERN void csvbloom_close(csvbloom_t *bloom);
+
+/**
+ * Check if the sidecar was loaded rather than built by csvbloom_open().
+ */
+CSV_EXTERN int csvbloom_hit(csvbloom_t *bloom);
+
+/**
+ * Get the num blocks, i.e. filters.
+ */
+CSV_EXTERN int64_t csvbloom_nblock(csvbloom_t *bloom);
+
+/**
+ * Hash a key for csvbloom_test().
+ */
+CSV_EXTERN uint64_t csvbloom_hash(const char *key, int len);
+
+/**
+ * Check if block k, rows k * stride + 1 to (k + 1) * stride, may have a
+ * key of hash h in the column. Returns 0 if it surely does not.
+ */
+CSV_EXTERN int csvbloom_test(csvbloom_t *bloom, int64_t k, uint64_t h);
+
+#endif /*CSVBLOOM_H*/
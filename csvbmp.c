@@ -0,0 +1,679 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#define _GNU_SOURCE
+#include "csvbmp.h"
+#include "csvside.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define MAGIC "CSVBMP1\n"
+#define CHUNK 65536 /* block numbers per container */
+#define BITMAPSZ (CHUNK / 8)
+
+/* kinds of container */
+#define ARRAY 1
+#define BITMAP 2
+#define RUN 3
+
+/* the sidecar starts with this header; then come the entries, the
+ * containers of each entry, the values, and the container data */
+typedef struct header_t header_t;
+struct header_t {
+  csvside_id_t id;
+  /* what is indexed */
+  int32_t col;
+  int32_t unused;
+  int64_t stride;
+  /* shape */
+  int64_t nblock;
+  int32_t nvalue;
+  int32_t overflow; /* too many distinct values; nothing follows */
+  int64_t size;     /* num bytes in the sidecar */
+};
+
+/* a distinct value; offsets are from the start of the sidecar */
+typedef struct entry_t entry_t;
+struct entry_t {
+  int64_t keyoff;
+  int32_t keylen; /* -1 for NULL */
+  int32_t ncont;
+  int64_t contoff; /* cont_t[ncont] sorted by hi */
+  int64_t count;   /* num blocks */
+};
+
+/* the blocks hi * CHUNK to hi * CHUNK + CHUNK - 1 of a value */
+typedef struct cont_t cont_t;
+struct cont_t {
+  int32_t hi;
+  int32_t type;
+  int32_t n; /* num items of an ARRAY, or num runs of a RUN */
+  int32_t unused;
+  int64_t off;
+};
+
+struct csvbmp_t {
+  header_t *hdr;
+  int64_t hdrsz; /* num bytes in the sidecar */
+  int mapped;    /* hdr is mmap'ed, else malloc'ed */
+  const entry_t *entry;
+  int hit;
+};
+
+static inline int64_t align8(int64_t n) { return (n + 7) & ~(int64_t)7; }
+
+/* compare a[0..alen) and b[0..blen) as bytes */
+static inline int bytecmp(const char *a, int alen, const char *b, int blen) {
+  int c = memcmp(a, b, alen < blen ? alen : blen);
+  return c ? c : (alen > blen) - (alen < blen);
+}
+
+/* num bytes of the data of a container */
+static inline int64_t cont_size(const cont_t *c) {
+  return c->type == ARRAY ? c->n * 2 : c->type == RUN ? c->n * 4 : BITMAPSZ;
+}
+
+/* check that the entries and containers lie within the sidecar */
+static int check_sidecar(const header_t *hdr) {
+  const int64_t size = hdr->size;
+  const entry_t *entry = (const entry_t *)(hdr + 1);
+  if (hdr->nvalue < 0 ||
+      (int64_t)(sizeof(*hdr) + hdr->nvalue * sizeof(*entry)) > size) {
+    return -1;
+  }
+  for (int i = 0; i < hdr->nvalue; i++) {
+    const entry_t *e = &entry[i];
+    if (e->keylen < -1 || e->keyoff < 0 ||
+        e->keyoff + (e->keylen > 0 ? e->keylen : 0) > size || e->ncont < 0 ||
+        e->contoff < 0 || (e->contoff & 7) ||
+        e->contoff + e->ncont * (int64_t)sizeof(cont_t) > size) {
+      return -1;
+    }
+    const cont_t *c = (const cont_t *)((const char *)hdr + e->contoff);
+    for (int j = 0; j < e->ncont; j++) {
+      if (c[j].type < ARRAY || c[j].type > RUN || c[j].n < 0 ||
+          c[j].n > CHUNK || c[j].hi < 0 || c[j].off < 0 || (c[j].off & 7) ||
+          c[j].off + cont_size(&c[j]) > size) {
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* map the sidecar at path if it matches want. Returns 0 on success. */
+static int load_sidecar(csvbmp_t *bmp, const char *path,
+                        const header_t *want) {
+  int64_t size;
+  header_t *hdr = csvside_map(path, sizeof(header_t), &size);
+  if (!hdr) {
+    return -1;
+  }
+  if (!csvside_match(&hdr->id, &want->id) || hdr->col != want->col ||
+      hdr->stride != want->stride || hdr->nblock < 0 || hdr->size != size ||
+      check_sidecar(hdr)) {
+    munmap(hdr, size);
+    return -1;
+  }
+
+  bmp->hdr = hdr;
+  bmp->hdrsz = size;
+  bmp->mapped = 1;
+  bmp->entry = (const entry_t *)(hdr + 1);
+  return 0;
+}
+
+/* a distinct value while scanning */
+typedef struct val_t val_t;
+struct val_t {
+  uint64_t hash;
+  int64_t keyoff; /* in pool */
+  int len;        /* -1 for NULL */
+  uint32_t *blk;  /* the blocks that hold it, ascending */
+  int64_t nblk, maxblk;
+};
+
+typedef struct build_t build_t;
+struct build_t {
+  val_t *val;
+  int nval, maxval;
+  int32_t *slot; /* hash table of index into val[] + 1; 0 if empty */
+  int nslot;
+  int nullval; /* index of the NULL value, or -1 */
+  char *pool;  /* the values */
+  int64_t poolsz, poolmax;
+  char *scratch;
+  int scratchmax;
+};
+
+static void build_free(build_t *b) {
+  for (int i = 0; i < b->nval; i++) {
+    free(b->val[i].blk);
+  }
+  free(b->val);
+  free(b->slot);
+  free(b->pool);
+  free(b->scratch);
+}
+
+static uint64_t hash_key(const char *key, int len) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (int i = 0; i < len; i++) {
+    h = (h ^ (uint8_t)key[i]) * 0x100000001b3ull;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  return h;
+}
+
+/* double the hash table */
+static int rehash(build_t *b) {
+  int nslot = b->nslot ? b->nslot * 2 : 64;
+  int32_t *slot = calloc(nslot, sizeof(*slot));
+  if (!slot) {
+    return -1;
+  }
+  for (int i = 0; i < b->nval; i++) {
+    if (i == b->nullval) {
+      continue;
+    }
+    int j = b->val[i].hash & (nslot - 1);
+    while (slot[j]) {
+      j = (j + 1) & (nslot - 1);
+    }
+    slot[j] = i + 1;
+  }
+  free(b->slot);
+  b->slot = slot;
+  b->nslot = nslot;
+  return 0;
+}
+
+/* add a new value s[0..len), or NULL if len < 0. Returns its index, or
+ * -1 if out of memory. */
+static int new_value(build_t *b, uint64_t hash, const char *s, int len) {
+  if (b->nval == b->maxval) {
+    int max = b->maxval * 2 + 16;
+    val_t *p = realloc(b->val, max * sizeof(*p));
+    if (!p) {
+      return -1;
+    }
+    b->val = p;
+    b->maxval = max;
+  }
+  if (len > 0 && b->poolsz + len > b->poolmax) {
+    int64_t max = (b->poolsz + len) * 1.5 + 64;
+    char *p = realloc(b->pool, max);
+    if (!p) {
+      return -1;
+    }
+    b->pool = p;
+    b->poolmax = max;
+  }
+  val_t *v = &b->val[b->nval];
+  memset(v, 0, sizeof(*v));
+  v->hash = hash;
+  v->len = len;
+  v->keyoff = b->poolsz;
+  if (len > 0) {
+    memcpy(b->pool + b->poolsz, s, len);
+    b->poolsz += len;
+  }
+  return b->nval++;
+}
+
+/* add block k to the set of value s[0..len), or of NULL if len < 0.
+ * Returns 0 on success, 1 if there are too many values, or -1 if out of
+ * memory. */
+static int add_value(build_t *b, uint32_t k, const char *s, int len) {
+  int i;
+  if (len < 0) {
+    if (b->nullval < 0) {
+      if (b->nval == CSVBMP_MAXVALUE) {
+        return 1;
+      }
+      if ((b->nullval = new_value(b, 0, 0, -1)) < 0) {
+        return -1;
+      }
+    }
+    i = b->nullval;
+  } else {
+    if (2 * b->nval >= b->nslot && rehash(b)) {
+      return -1;
+    }
+    const uint64_t h = hash_key(s, len);
+    int j = h & (b->nslot - 1);
+    for (; b->slot[j]; j = (j + 1) & (b->nslot - 1)) {
+      const val_t *v = &b->val[b->slot[j] - 1];
+      if (v->hash == h && v->len == len &&
+          0 == memcmp(b->pool + v->keyoff, s, len)) {
+        break;
+      }
+    }
+    if (!b->slot[j]) {
+      if (b->nval == CSVBMP_MAXVALUE) {
+        return 1;
+      }
+      int n = new_value(b, h, s, len);
+      if (n < 0) {
+        return -1;
+      }
+      b->slot[j] = n + 1;
+    }
+    i = b->slot[j] - 1;
+  }
+
+  val_t *v = &b->val[i];
+  if (v->nblk && v->blk[v->nblk - 1] == k) {
+    return 0;
+  }
+  if (v->nblk == v->maxblk) {
+    int64_t max = v->maxblk * 2 + 4;
+    uint32_t *p = realloc(v->blk, max * sizeof(*p));
+    if (!p) {
+      return -1;
+    }
+    v->blk = p;
+    v->maxblk = max;
+  }
+  v->blk[v->nblk++] = k;
+  return 0;
+}
+
+/* pick the smallest container for blk[0..n), which share their high
+ * bits, and fill it in at dst if dst is not NULL. Returns the num bytes
+ * of its data. */
+static int64_t encode(const uint32_t *blk, int n, cont_t *c, char *dst) {
+  int nrun = 1;
+  for (int i = 1; i < n; i++) {
+    nrun += (blk[i] != blk[i - 1] + 1);
+  }
+  c->hi = blk[0] / CHUNK;
+  if (4 * nrun <= 2 * n && 4 * nrun < BITMAPSZ) {
+    c->type = RUN;
+    c->n = nrun;
+  } else if (2 * n <= BITMAPSZ) {
+    c->type = ARRAY;
+    c->n = n;
+  } else {
+    c->type = BITMAP;
+    c->n = n;
+  }
+  if (!dst) {
+    return cont_size(c);
+  }
+
+  uint16_t *u16 = (uint16_t *)dst;
+  switch (c->type) {
+  case ARRAY:
+    for (int i = 0; i < n; i++) {
+      u16[i] = blk[i] % CHUNK;
+    }
+    break;
+  case RUN:
+    for (int i = 0; i < n;) {
+      int j = i + 1;
+      while (j < n && blk[j] == blk[j - 1] + 1) {
+        j++;
+      }
+      *u16++ = blk[i] % CHUNK;
+      *u16++ = j - i - 1;
+      i = j;
+    }
+    break;
+  default: {
+    uint64_t *w = (uint64_t *)dst;
+    memset(w, 0, BITMAPSZ);
+    for (int i = 0; i < n; i++) {
+      const uint32_t lo = blk[i] % CHUNK;
+      w[lo / 64] |= 1ull << (lo % 64);
+    }
+    break;
+  }
+  }
+  return cont_size(c);
+}
+
+/* the length of the run of blk[0..n) in the same chunk as blk[0] */
+static int chunk_len(const uint32_t *blk, int64_t n) {
+  int i = 1;
+  while (i < n && blk[i] / CHUNK == blk[0] / CHUNK) {
+    i++;
+  }
+  return i;
+}
+
+static const build_t *sort_build; /* for cmp_value() */
+
+/* order values by bytes, with NULL first */
+static int cmp_value(const void *a, const void *b) {
+  const val_t *x = &sort_build->val[*(const int *)a];
+  const val_t *y = &sort_build->val[*(const int *)b];
+  if (x->len < 0 || y->len < 0) {
+    return (x->len >= 0) - (y->len >= 0);
+  }
+  return bytecmp(sort_build->pool + x->keyoff, x->len,
+                 sort_build->pool + y->keyoff, y->len);
+}
+
+/* lay out the sidecar from b into bmp->hdr, which holds the header */
+static int layout(csvbmp_t *bmp, build_t *b) {
+  int order[b->nval > 0 ? b->nval : 1];
+  for (int i = 0; i < b->nval; i++) {
+    order[i] = i;
+  }
+  sort_build = b;
+  qsort(order, b->nval, sizeof(order[0]), cmp_value);
+
+  /* sizes */
+  int64_t ncont = 0;
+  int64_t datasz = 0;
+  for (int i = 0; i < b->nval; i++) {
+    const val_t *v = &b->val[i];
+    for (int64_t j = 0; j < v->nblk;) {
+      cont_t c;
+      int n = chunk_len(v->blk + j, v->nblk - j);
+      datasz += align8(encode(v->blk + j, n, &c, 0));
+      ncont++;
+      j += n;
+    }
+  }
+  const int64_t entoff = sizeof(header_t);
+  const int64_t contoff = entoff + b->nval * sizeof(entry_t);
+  const int64_t keyoff = contoff + ncont * sizeof(cont_t);
+  const int64_t dataoff = keyoff + align8(b->poolsz);
+  const int64_t size = dataoff + datasz;
+
+  header_t *hdr = realloc(bmp->hdr, size);
+  if (!hdr) {
+    return -1;
+  }
+  memset(hdr + 1, 0, size - sizeof(*hdr));
+  hdr->nvalue = b->nval;
+  hdr->size = size;
+  bmp->hdr = hdr;
+  bmp->hdrsz = size;
+  bmp->entry = (const entry_t *)(hdr + 1);
+
+  char *base = (char *)hdr;
+  memcpy(base + keyoff, b->pool, b->poolsz);
+  entry_t *entry = (entry_t *)(base + entoff);
+  cont_t *cont = (cont_t *)(base + contoff);
+  int64_t off = dataoff;
+  for (int i = 0; i < b->nval; i++) {
+    const val_t *v = &b->val[order[i]];
+    entry_t *e = &entry[i];
+    e->keyoff = v->len < 0 ? 0 : keyoff + v->keyoff;
+    e->keylen = v->len;
+    e->contoff = (char *)cont - base;
+    e->count = v->nblk;
+    for (int64_t j = 0; j < v->nblk;) {
+      int n = chunk_len(v->blk + j, v->nblk - j);
+      cont->off = off;
+      off += align8(encode(v->blk + j, n, cont, base + off));
+      cont++;
+      e->ncont++;
+      j += n;
+    }
+  }
+  return 0;
+}
+
+/* scan the csv file in fd and add the value of each row to the set of
+ * its value. Returns 0 on success, 1 if there are too many values, or
+ * -1 on error. */
+static int scan_file(build_t *b, csv_parse_t *cp, int col, int64_t stride,
+                     int fd, int64_t datasz, int64_t *nblock, char *errbuf,
+                     int errbufsz) {
+  csvside_scan_t sc;
+  if (csvside_scan_open(&sc, fd, 0, datasz, errbuf, errbufsz)) {
+    return -1;
+  }
+  const char *row;
+  int nb;
+  while ((nb = csvside_scan_next(&sc, cp, &row, errbuf, errbufsz)) > 0) {
+    const int64_t k = (sc.rownum - 1) / stride;
+    if (k > UINT32_MAX) {
+      csvside_seterr(errbuf, errbufsz, "too many blocks");
+      nb = -1;
+      break;
+    }
+    *nblock = k + 1;
+
+    char **field;
+    int *len;
+    char *quoted;
+    int n = -1;
+    if (col < csv_rawfields(cp, &field, &len, &quoted)) {
+      if (len[col] >= b->scratchmax) {
+        int max = len[col] * 1.5 + 64;
+        char *p = realloc(b->scratch, max);
+        if (!p) {
+          csvside_seterr(errbuf, errbufsz, "out of memory");
+          nb = -1;
+          break;
+        }
+        b->scratch = p;
+        b->scratchmax = max;
+      }
+      n = csv_decode(cp, field[col], len[col], quoted[col], b->scratch);
+    }
+    int err = add_value(b, k, b->scratch, n);
+    if (err) {
+      if (err < 0) {
+        csvside_seterr(errbuf, errbufsz, "out of memory");
+      }
+      nb = err;
+      break;
+    }
+  }
+
+  csvside_scan_close(&sc);
+  return nb;
+}
+
+/* scan the csv file in fd and lay out the sidecar in memory */
+static int build_sidecar(csvbmp_t *bmp, int fd, const header_t *want,
+                         char *errbuf, int errbufsz) {
+  const csvside_id_t *id = &want->id;
+  csv_parse_t *cp = csv_open(id->qte, id->esc, id->delim, id->nullstr);
+  if (!cp || !(bmp->hdr = malloc(sizeof(header_t)))) {
+    csvside_seterr(errbuf, errbufsz, "out of memory");
+    csv_close(cp);
+    return -1;
+  }
+  *bmp->hdr = *want;
+  bmp->hdrsz = sizeof(header_t);
+  bmp->hdr->size = sizeof(header_t);
+
+  build_t b;
+  memset(&b, 0, sizeof(b));
+  b.nullval = -1;
+  int64_t nblock = 0;
+  int ret = scan_file(&b, cp, want->col, want->stride, fd, id->fsize,
+                      &nblock, errbuf, errbufsz);
+  csv_close(cp);
+
+  if (ret > 0) {
+    /* too many values: keep just the header */
+    bmp->hdr->overflow = 1;
+    ret = 0;
+  } else if (ret == 0) {
+    bmp->hdr->nblock = nblock;
+    if (layout(bmp, &b)) {
+      csvside_seterr(errbuf, errbufsz, "out of memory");
+      ret = -1;
+    }
+  }
+  build_free(&b);
+  return ret;
+}
+
+csvbmp_t *csvbmp_open(const char *path, int qte, int esc, int delim,
+                      const char nullstr[20], int col, int64_t stride,
+                      char *errbuf, int errbufsz) {
+  csvbmp_t *bmp = calloc(1, sizeof(*bmp));
+  int fd = -1;
+  char *sidecar = 0;
+  if (!bmp || !(sidecar = malloc(strlen(path) + 10))) {
+    csvside_seterr(errbuf, errbufsz, "out of memory");
+    goto bail;
+  }
+  sprintf(sidecar, "%s.csvbmp", path);
+  if (col < 0 || stride <= 0) {
+    csvside_seterr(errbuf, errbufsz, "bad column %d or stride %" PRId64, col,
+                   stride);
+    goto bail;
+  }
+
+  header_t want;
+  memset(&want, 0, sizeof(want));
+  if ((fd = open(path, O_RDONLY)) < 0 ||
+      csvside_identity(&want.id, MAGIC, fd, qte, esc, delim, nullstr)) {
+    csvside_seterr(errbuf, errbufsz, "open %s - %s", path, strerror(errno));
+    goto bail;
+  }
+  want.col = col;
+  want.stride = stride;
+  if (0 == load_sidecar(bmp, sidecar, &want)) {
+    bmp->hit = 1;
+  } else {
+    if (build_sidecar(bmp, fd, &want, errbuf, errbufsz)) {
+      goto bail;
+    }
+    csvside_save(sidecar, bmp->hdr, bmp->hdrsz);
+  }
+  if (bmp->hdr->overflow) {
+    csvside_seterr(errbuf, errbufsz,
+                   "column %d has more than %d distinct values", col + 1,
+                   CSVBMP_MAXVALUE);
+    goto bail;
+  }
+
+  close(fd);
+  free(sidecar);
+  return bmp;
+
+bail:
+  if (fd >= 0) {
+    close(fd);
+  }
+  free(sidecar);
+  csvbmp_close(bmp);
+  return 0;
+}
+
+void csvbmp_close(csvbmp_t *bmp) {
+  if (!bmp) {
+    return;
+  }
+  if (bmp->hdr) {
+    if (bmp->mapped) {
+      munmap(bmp->hdr, bmp->hdrsz);
+    } else {
+      free(bmp->hdr);
+    }
+  }
+  free(bmp);
+}
+
+int csvbmp_hit(csvbmp_t *bmp) { return bmp->hit; }
+
+int64_t csvbmp_nblock(csvbmp_t *bmp) { return bmp->hdr->nblock; }
+
+int csvbmp_nvalue(csvbmp_t *bmp) { return bmp->hdr->nvalue; }
+
+int csvbmp_find(csvbmp_t *bmp, const char *key, int len) {
+  const entry_t *entry = bmp->entry;
+  const int nvalue = bmp->hdr->nvalue;
+  const int hasnull = nvalue > 0 && entry[0].keylen < 0;
+  if (!key) {
+    return hasnull ? 0 : -1;
+  }
+  /* binary search the values after NULL */
+  const char *base = (const char *)bmp->hdr;
+  int lo = hasnull, hi = nvalue;
+  while (lo < hi) {
+    const int mid = lo + (hi - lo) / 2;
+    const entry_t *e = &entry[mid];
+    const int c = bytecmp(base + e->keyoff, e->keylen, key, len);
+    if (c == 0) {
+      return mid;
+    }
+    if (c < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return -1;
+}
+
+const char *csvbmp_value(csvbmp_t *bmp, int id, int *len) {
+  const entry_t *e = &bmp->entry[id];
+  *len = e->keylen < 0 ? 0 : e->keylen;
+  return e->keylen < 0 ? 0 : (const char *)bmp->hdr + e->keyoff;
+}
+
+int64_t csvbmp_count(csvbmp_t *bmp, int id) { return bmp->entry[id].count; }
+
+/* set bits from to to inclusive */
+static void set_range(uint64_t *set, int64_t from, int64_t to) {
+  for (; from <= to && (from & 63); from++) {
+    set[from / 64] |= 1ull << (from & 63);
+  }
+  for (; from + 63 <= to; from += 64) {
+    set[from / 64] = ~0ull;
+  }
+  for (; from <= to; from++) {
+    set[from / 64] |= 1ull << (from & 63);
+  }
+}
+
+void csvbmp_or(csvbmp_t *bmp, int id, uint64_t *set) {
+  const char *base = (const char *)bmp->hdr;
+  const entry_t *e = &bmp->entry[id];
+  const cont_t *c = (const cont_t *)(base + e->contoff);
+  const int64_t nblock = bmp->hdr->nblock;
+  for (int i = 0; i < e->ncont; i++) {
+    const int64_t hi = (int64_t)c[i].hi * CHUNK;
+    const char *p = base + c[i].off;
+    if (c[i].type == BITMAP) {
+      const uint64_t *w = (const uint64_t *)p;
+      const int64_t nword = (nblock + 63) / 64 - hi / 64;
+      for (int64_t j = 0; j < nword && j < CHUNK / 64; j++) {
+        set[hi / 64 + j] |= w[j];
+      }
+      continue;
+    }
+    const uint16_t *u16 = (const uint16_t *)p;
+    for (int j = 0; j < c[i].n; j++) {
+      int64_t from, to;
+      if (c[i].type == ARRAY) {
+        from = to = hi + u16[j];
+      } else {
+        from = hi + u16[2 * j];
+        to = from + u16[2 * j + 1];
+      }
+      if (to < nblock) {
+        set_range(set, from, to);
+      }
+    }
+  }
+}
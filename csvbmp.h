@@ -0,0 +1,113 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#ifndef CSVBMP_H
+#define CSVBMP_H
+
+/*
+
+  A bitmap index on a column of a csv file with few distinct values:
+  for each value, the set of blocks of N rows that hold it. It is saved
+  in a sidecar file FILE.csvbmp. An equality lookup finds the value and
+  parses only its blocks; unlike a Bloom filter (see csvbloom.h) there
+  are no false positives, and a value that is not in the column is
+  answered without reading the file. The blocks are those of the sparse
+  row index with the same N (see csvidx.h), so a block is read with
+  csvidx_read_rows().
+
+  The sets are compressed as in Roaring bitmaps: block numbers are
+  split into chunks of 65536, and each chunk of a set is stored as
+  whichever is smallest of
+
+      array  : the sorted low 16 bits of the block numbers
+      bitmap : 65536 bits
+      run    : pairs of (start, length - 1) of runs of blocks
+
+  A column with more than CSVBMP_MAXVALUE distinct values is not
+  indexed; the sidecar records that so it is not scanned again.
+
+  The sidecar is used only if the size, mtime, inode and device of
+  FILE, the dialect, the column and N are unchanged. Otherwise it is
+  rebuilt.
+
+  General usage:
+
+     csvbmp_open()
+         id = csvbmp_find()
+         csvbmp_or(id, set)
+         ...
+     csvbmp_close()
+
+*/
+
+#include "csv.h"
+
+#define CSVBMP_MAXVALUE 4096 /* max distinct values, with NULL */
+
+typedef struct csvbmp_t csvbmp_t;
+
+/**
+ * Open the bitmap index on column col, numbered from 0, of the csv file
+ * at path, with blocks of stride rows. If there is no valid sidecar,
+ * the file is scanned and the sidecar is saved next to it; if the
+ * sidecar cannot be saved, the index is kept in memory only.
+ *
+ * Params qte, esc, delim and nullstr are as in csv_open(); NULLs and
+ * missing fields are indexed as the NULL value. Returns NULL on error,
+ * or if the column has too many distinct values, with a message in
+ * errbuf[0..errbufsz).
+ */
+CSV_EXTERN csvbmp_t *csvbmp_open(const char *path, int qte, int esc,
+                                 int delim, const char nullstr[20], int col,
+                                 int64_t stride, char *errbuf, int errbufsz);
+
+/**
+ * Release the index.
+ */
+CSV_EXTERN void csvbmp_close(csvbmp_t *bmp);
+
+/**
+ * Check if the sidecar was loaded rather than built by csvbmp_open().
+ */
+CSV_EXTERN int csvbmp_hit(csvbmp_t *bmp);
+
+/**
+ * Get the num blocks, and the num distinct values including NULL.
+ */
+CSV_EXTERN int64_t csvbmp_nblock(csvbmp_t *bmp);
+CSV_EXTERN int csvbmp_nvalue(csvbmp_t *bmp);
+
+/**
+ * Find value key[0..len), or the NULL value if key is NULL. Returns its
+ * id in [0, nvalue), or -1 if the column does not have it. Ids are in
+ * byte order of the values, with NULL first.
+ */
+CSV_EXTERN int csvbmp_find(csvbmp_t *bmp, const char *key, int len);
+
+/**
+ * Get the value of id, and its length in *len. Returns NULL for the
+ * NULL value.
+ */
+CSV_EXTERN const char *csvbmp_value(csvbmp_t *bmp, int id, int *len);
+
+/**
+ * Get the num blocks that hold the value of id.
+ */
+CSV_EXTERN int64_t csvbmp_count(csvbmp_t *bmp, int id);
+
+/**
+ * Set bit k of set[] for each block k that holds the value of id. The
+ * set has (nblock + 63) / 64 words.
+ */
+CSV_EXTERN void csvbmp_or(csvbmp_t *bmp, int id, uint64_t *set);
+
+#endif /*CSVBMP_H*/
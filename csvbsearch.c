@@ -0,0 +1,349 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-v] [-N] [-k col] [-d delim] [-q quote] [-e esc]\n\
+            [-n nullstr] FILE KEY [HIKEY]\n\
+                        \n\
+                        \n\
+  Print the rows of a csv file sorted by column col where the column\n\
+  equals KEY, or with HIKEY, is between KEY and HIKEY inclusive. The\n\
+  rows are found by a binary search on byte offsets: each probe finds\n\
+  the next row boundary with csvsync_forward() and parses one row. The\n\
+  rows are printed as they are in the file.\n\
+                        \n\
+  The file must be sorted by the bytes of the column, as by LC_ALL=C\n\
+  sort, or with -N, by its numeric value. NULLs, and with -N values that\n\
+  are not numbers, must come first.\n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -v         : print the num probes to stderr                        \n\
+      -N         : compare as numbers                                    \n\
+      -k col     : specify the key column by number from 1, or by name   \n\
+                   in the header row; default to 1                        \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      -n nullstr : specify string representing null; default to \"\"     \n\
+      \n\
+  If col is a name, the first row is the header and is not searched.\n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csv.h"
+#include "csvnum.h"
+#include "csvsync.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LINEAR 4096      /* scan ranges this small row by row */
+
+const char *pname = 0;
+const char *fname = 0;
+const char *lokey = 0;
+const char *hikey = 0;
+const char *colname = "1";
+int col = -1;
+int numeric = 0;
+int verbose = 0;
+int qte = '"';
+int esc = 0;
+int delim = ',';
+char nullstr[20] = {0};
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d, *n;
+  q = e = d = n = 0;
+  while ((opt = getopt(argc, argv, "d:q:e:n:k:Nvh")) != -1) {
+    switch (opt) {
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'n':
+      n = optarg;
+      break;
+    case 'k':
+      colname = optarg;
+      break;
+    case 'N':
+      numeric = 1;
+      break;
+    case 'v':
+      verbose = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* fname, keys */
+  if (optind + 2 != argc && optind + 3 != argc) {
+    usage(1, "Error: please supply FILE and KEY, or FILE, KEY and HIKEY");
+  }
+  fname = argv[optind];
+  lokey = argv[optind + 1];
+  hikey = argv[optind + (optind + 3 == argc ? 2 : 1)];
+
+  /* col */
+  char *end;
+  long c = strtol(colname, &end, 10);
+  if (*colname && !*end) {
+    if (c <= 0 || c > 1000000) {
+      usage(1, "Error: -k col expects a column number from 1, or a name.");
+    }
+    col = c - 1;
+  }
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  esc = qte;
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+
+  /* nullstr */
+  if (n) {
+    if (strlen(n) >= 20) {
+      usage(1, "Error: -n nullstr is too long. max is 19 chars");
+    }
+    strcpy(nullstr, n);
+  }
+}
+
+/* the file */
+const char *data = 0;
+int64_t datasz = 0;
+csv_parse_t *cp = 0;
+int64_t nprobe = 0;
+
+/* the fields of the row last parsed by parse_row() */
+char **field;
+int *len;
+char *quoted;
+int nfield;
+
+/*
+ * Parse the row at offset p. Returns its size in bytes, including the
+ * newline.
+ */
+static int64_t parse_row(int64_t p) {
+  static char *tail = 0;
+  const int64_t rem = datasz - p;
+  const int bufsz = rem < CSV_WINDOW ? rem : CSV_WINDOW;
+  int nb = csv_line(cp, data + p, bufsz);
+  if (nb == 0 && bufsz == rem) {
+    /* the last row has no newline; parse a copy with one */
+    free(tail);
+    if (!(tail = malloc(rem + 1))) {
+      fatal("ERROR: out of memory\n");
+    }
+    memcpy(tail, data + p, rem);
+    tail[rem] = '\n';
+    nb = csv_line(cp, tail, rem + 1);
+    nb = nb > rem ? rem : nb;
+  }
+  if (nb <= 0) {
+    fatal("ERROR: offset %" PRId64 ": %s\n", p,
+          nb < 0 ? csv_errmsg(cp) : "row too long");
+  }
+  nfield = csv_rawfields(cp, &field, &len, &quoted);
+  return nb;
+}
+
+/* compare the key of the row last parsed with x */
+static int compare(const char *x) {
+  static char *val = 0;
+  static int valmax = 0;
+  if (col >= nfield) {
+    return -1; /* a missing field is NULL */
+  }
+  if (len[col] >= valmax) {
+    valmax = len[col] * 1.5 + 64;
+    if (!(val = realloc(val, valmax))) {
+      fatal("ERROR: out of memory\n");
+    }
+  }
+  const int n = csv_decode(cp, field[col], len[col], quoted[col], val);
+  if (n < 0) {
+    return -1; /* NULLs come first */
+  }
+  if (numeric) {
+    double a, b;
+    if (csvnum_double(val, n, &a)) {
+      return -1;
+    }
+    if (csvnum_double(x, strlen(x), &b)) {
+      fatal("ERROR: key '%s' is not a number\n", x);
+    }
+    return a < b ? -1 : a > b;
+  }
+  const int xlen = strlen(x);
+  const int c = memcmp(val, x, n < xlen ? n : xlen);
+  return c ? c : (n > xlen) - (n < xlen);
+}
+
+/*
+ * Find the first row at or after first whose key is >= x, or > x if upper is
+ * set. Returns its offset, or datasz if there is none.
+ */
+static int64_t bound(int64_t first, const char *x, int upper, int ncol) {
+  int64_t lo = first;
+  int64_t hi = datasz;
+  /* rows before lo are below x; rows from hi on are not */
+  while (hi - lo > LINEAR) {
+    const int64_t mid = lo + (hi - lo) / 2;
+    const int64_t r = csvsync_forward(data, datasz, mid, qte, esc, delim, ncol);
+    if (r < 0) {
+      fatal("ERROR: cannot find a row boundary after offset %" PRId64 "\n",
+            mid);
+    }
+    if (r >= hi) {
+      break; /* one long row; go row by row */
+    }
+    nprobe++;
+    const int64_t n = parse_row(r);
+    const int c = compare(x);
+    if (c < 0 || (upper && c == 0)) {
+      lo = r + n;
+    } else {
+      hi = r;
+    }
+  }
+  while (lo < hi) {
+    nprobe++;
+    const int64_t n = parse_row(lo);
+    const int c = compare(x);
+    if (!(c < 0 || (upper && c == 0))) {
+      break;
+    }
+    lo += n;
+  }
+  return lo;
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+
+  int fd = open(fname, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st)) {
+    fatal("ERROR: open %s - %s\n", fname, strerror(errno));
+  }
+  datasz = st.st_size;
+  if (datasz == 0) {
+    return 0;
+  }
+  data = mmap(0, datasz, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    fatal("ERROR: mmap %s - %s\n", fname, strerror(errno));
+  }
+  close(fd);
+  madvise((void *)data, datasz, MADV_RANDOM);
+  if (!(cp = csv_open(qte, esc, delim, nullstr))) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  /* the first row gives the num columns, and the header if col is a
+   * name */
+  int64_t first = 0;
+  const int64_t hdrsz = parse_row(0);
+  const int ncol = nfield;
+  if (col < 0) {
+    for (int i = 0; i < nfield && col < 0; i++) {
+      char tmp[len[i] + 1];
+      if (csv_decode(cp, field[i], len[i], quoted[i], tmp) >= 0 &&
+          0 == strcmp(tmp, colname)) {
+        col = i;
+      }
+    }
+    if (col < 0) {
+      fatal("ERROR: no column named '%s'\n", colname);
+    }
+    first = hdrsz;
+  }
+
+  const int64_t lo = bound(first, lokey, 0, ncol);
+  const int64_t hi = lo < datasz ? bound(lo, hikey, 1, ncol) : lo;
+  if (hi > lo) {
+    fwrite(data + lo, 1, hi - lo, stdout);
+    if (data[hi - 1] != '\n') {
+      putchar('\n');
+    }
+  }
+  if (fflush(stdout)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(errno));
+  }
+  if (verbose) {
+    perr("%s: %" PRId64 " probes\n", fname, nprobe);
+  }
+
+  csv_close(cp);
+  munmap((void *)data, datasz);
+  return 0;
+}
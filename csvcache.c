@@ -0,0 +1,448 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#define _GNU_SOURCE
+#include "csvcache.h"
+#include "csvside.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define MAGIC "CSVCACH1"
+
+/* the sidecar starts with this header; the arrays follow */
+typedef struct header_t header_t;
+struct header_t {
+  csvside_id_t id;
+  /* shape */
+  int64_t nrow;
+  int32_t ncol;
+  int32_t unused;
+};
+
+struct csvcache_t {
+  csv_parse_t *cp; /* for decoding */
+  const char *data;
+  int64_t datasz;
+
+  /* the sidecar; either mmap'ed, or malloc'ed if it was just built */
+  header_t *hdr;
+  int64_t hdrsz; /* num bytes in the sidecar */
+  int mapped;
+
+  const int64_t *rowoff;
+  const int32_t *nfield;
+  const uint32_t *off; /* off[c * nrow + r] */
+  const int32_t *len;  /* len[c * nrow + r] */
+
+  /* for csvcache_scan() */
+  char *scratch;
+  int scratchmax;
+  char **fld;
+  int fldmax;
+};
+
+/* num bytes in a sidecar of nrow rows and ncol columns */
+static int64_t sidecar_size(int64_t nrow, int64_t ncol) {
+  int64_t sz = sizeof(header_t) + (nrow + 1) * 8 + nrow * 4;
+  sz = (sz + 7) & ~(int64_t)7;
+  return sz + ncol * nrow * 8;
+}
+
+/* point the arrays into the sidecar */
+static void setup_arrays(csvcache_t *cache) {
+  const int64_t nrow = cache->hdr->nrow;
+  const int64_t ncol = cache->hdr->ncol;
+  char *p = (char *)(cache->hdr + 1);
+  cache->rowoff = (const int64_t *)p;
+  p += (nrow + 1) * 8;
+  cache->nfield = (const int32_t *)p;
+  p = (char *)cache->hdr + ((p + nrow * 4 - (char *)cache->hdr + 7) & ~7);
+  cache->off = (const uint32_t *)p;
+  cache->len = (const int32_t *)(p + ncol * nrow * 4);
+}
+
+/* map the sidecar at path if it matches want. Returns 0 on success. */
+static int load_sidecar(csvcache_t *cache, const char *path,
+                        const header_t *want) {
+  int64_t size;
+  header_t *hdr = csvside_map(path, sizeof(header_t), &size);
+  if (!hdr) {
+    return -1;
+  }
+  if (!csvside_match(&hdr->id, &want->id) || hdr->nrow < 0 ||
+      hdr->ncol < 0 || sidecar_size(hdr->nrow, hdr->ncol) != size) {
+    munmap(hdr, size);
+    return -1;
+  }
+
+  cache->hdr = hdr;
+  cache->hdrsz = size;
+  cache->mapped = 1;
+  setup_arrays(cache);
+  return 0;
+}
+
+/* arrays collected while scanning the csv file */
+typedef struct build_t build_t;
+struct build_t {
+  int64_t nrow;
+  int64_t rowmax; /* num allocated rows in each array */
+  int ncol;
+  int64_t *rowoff;
+  int32_t *nfield;
+  uint32_t **off; /* off[c][r] */
+  int32_t **len;  /* len[c][r] */
+};
+
+static void build_free(build_t *b) {
+  for (int c = 0; c < b->ncol; c++) {
+    free(b->off[c]);
+    free(b->len[c]);
+  }
+  free(b->off);
+  free(b->len);
+  free(b->rowoff);
+  free(b->nfield);
+}
+
+/* add the row last parsed by csv_line() at offset rowoff */
+static int build_row(build_t *b, csv_parse_t *cp, int64_t rowoff,
+                     const char *rowstart) {
+  char **fld;
+  int *len;
+  char *quoted;
+  const int n = csv_rawfields(cp, &fld, &len, &quoted);
+
+  /* make room for one more row */
+  if (b->nrow == b->rowmax) {
+    int64_t max = b->rowmax * 1.5 + 1024;
+    void *p;
+    if (!(p = realloc(b->rowoff, (max + 1) * 8))) {
+      return -1;
+    }
+    b->rowoff = p;
+    if (!(p = realloc(b->nfield, max * 4))) {
+      return -1;
+    }
+    b->nfield = p;
+    for (int c = 0; c < b->ncol; c++) {
+      if (!(p = realloc(b->off[c], max * 4))) {
+        return -1;
+      }
+      b->off[c] = p;
+      if (!(p = realloc(b->len[c], max * 4))) {
+        return -1;
+      }
+      b->len[c] = p;
+    }
+    b->rowmax = max;
+  }
+
+  /* add new columns; they are missing in the rows seen so far */
+  if (n > b->ncol) {
+    void *p;
+    if (!(p = realloc(b->off, n * sizeof(*b->off)))) {
+      return -1;
+    }
+    b->off = p;
+    if (!(p = realloc(b->len, n * sizeof(*b->len)))) {
+      return -1;
+    }
+    b->len = p;
+    for (int c = b->ncol; c < n; c++) {
+      b->off[c] = malloc(b->rowmax * 4);
+      b->len[c] = malloc(b->rowmax * 4);
+      if (!b->off[c] || !b->len[c]) {
+        free(b->off[c]);
+        free(b->len[c]);
+        return -1;
+      }
+      for (int64_t r = 0; r < b->nrow; r++) {
+        b->off[c][r] = 0;
+        b->len[c][r] = CSVCACHE_NOFIELD;
+      }
+      b->ncol = c + 1;
+    }
+  }
+
+  const int64_t r = b->nrow++;
+  b->rowoff[r] = rowoff;
+  b->nfield[r] = n;
+  for (int c = 0; c < b->ncol; c++) {
+    if (c < n) {
+      b->off[c][r] = fld[c] - rowstart;
+      b->len[c][r] = len[c] | (quoted[c] ? CSVCACHE_QUOTED : 0);
+    } else {
+      b->off[c][r] = 0;
+      b->len[c][r] = CSVCACHE_NOFIELD;
+    }
+  }
+  return 0;
+}
+
+/* scan the csv file and collect the field positions */
+static int scan_file(csvcache_t *cache, build_t *b, char *errbuf,
+                     int errbufsz) {
+  csvside_scan_t sc;
+  csvside_scan_open(&sc, -1, cache->data, cache->datasz, errbuf, errbufsz);
+  const char *row;
+  int nb;
+  while ((nb = csvside_scan_next(&sc, cache->cp, &row, errbuf, errbufsz)) >
+         0) {
+    if (build_row(b, cache->cp, sc.off, row)) {
+      csvside_seterr(errbuf, errbufsz, "out of memory");
+      nb = -1;
+      break;
+    }
+  }
+  csvside_scan_close(&sc);
+  if (nb < 0) {
+    return -1;
+  }
+
+  if (b->rowoff || (b->rowoff = malloc(8))) {
+    b->rowoff[b->nrow] = cache->datasz;
+    return 0;
+  }
+  csvside_seterr(errbuf, errbufsz, "out of memory");
+  return -1;
+}
+
+/* scan the csv file and lay out the sidecar in memory */
+static int build_sidecar(csvcache_t *cache, const header_t *want,
+                         char *errbuf, int errbufsz) {
+  build_t b = {0};
+  if (scan_file(cache, &b, errbuf, errbufsz)) {
+    build_free(&b);
+    return -1;
+  }
+
+  const int64_t nrow = b.nrow;
+  cache->hdrsz = sidecar_size(nrow, b.ncol);
+  if (!(cache->hdr = calloc(1, cache->hdrsz))) {
+    csvside_seterr(errbuf, errbufsz, "out of memory");
+    build_free(&b);
+    return -1;
+  }
+  *cache->hdr = *want;
+  cache->hdr->nrow = nrow;
+  cache->hdr->ncol = b.ncol;
+  setup_arrays(cache);
+
+  memcpy((void *)cache->rowoff, b.rowoff, (nrow + 1) * 8);
+  memcpy((void *)cache->nfield, b.nfield, nrow * 4);
+  for (int c = 0; c < b.ncol; c++) {
+    memcpy((void *)(cache->off + c * nrow), b.off[c], nrow * 4);
+    memcpy((void *)(cache->len + c * nrow), b.len[c], nrow * 4);
+  }
+  build_free(&b);
+  return 0;
+}
+
+csvcache_t *csvcache_open(const char *path, int qte, int esc, int delim,
+                          const char nullstr[20], char *errbuf,
+                          int errbufsz) {
+  csvcache_t *cache = calloc(1, sizeof(*cache));
+  int fd = -1;
+  char *sidecar = 0;
+  if (!cache || !(sidecar = malloc(strlen(path) + 10))) {
+    csvside_seterr(errbuf, errbufsz, "out of memory");
+    goto bail;
+  }
+  sprintf(sidecar, "%s.csvcache", path);
+
+  header_t want;
+  memset(&want, 0, sizeof(want));
+  if ((fd = open(path, O_RDONLY)) < 0 ||
+      csvside_identity(&want.id, MAGIC, fd, qte, esc, delim, nullstr)) {
+    csvside_seterr(errbuf, errbufsz, "open %s - %s", path, strerror(errno));
+    goto bail;
+  }
+  const csvside_id_t *id = &want.id;
+  if (!(cache->cp = csv_open(id->qte, id->esc, id->delim, nullstr))) {
+    csvside_seterr(errbuf, errbufsz, "out of memory");
+    goto bail;
+  }
+  cache->datasz = id->fsize;
+  cache->data = "";
+  if (cache->datasz > 0) {
+    void *p = mmap(0, cache->datasz, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+      csvside_seterr(errbuf, errbufsz, "mmap %s - %s", path, strerror(errno));
+      goto bail;
+    }
+    cache->data = p;
+  }
+  close(fd);
+  fd = -1;
+
+  if (0 == load_sidecar(cache, sidecar, &want)) {
+    free(sidecar);
+    return cache;
+  }
+  if (build_sidecar(cache, &want, errbuf, errbufsz)) {
+    goto bail;
+  }
+  csvside_save(sidecar, cache->hdr, cache->hdrsz);
+  free(sidecar);
+  return cache;
+
+bail:
+  if (fd >= 0) {
+    close(fd);
+  }
+  free(sidecar);
+  csvcache_close(cache);
+  return 0;
+}
+
+void csvcache_close(csvcache_t *cache) {
+  if (!cache) {
+    return;
+  }
+  if (cache->hdr) {
+    if (cache->mapped) {
+      munmap(cache->hdr, cache->hdrsz);
+    } else {
+      free(cache->hdr);
+    }
+  }
+  if (cache->datasz > 0 && cache->data) {
+    munmap((void *)cache->data, cache->datasz);
+  }
+  if (cache->cp) {
+    csv_close(cache->cp);
+  }
+  free(cache->scratch);
+  free(cache->fld);
+  free(cache);
+}
+
+int csvcache_hit(csvcache_t *cache) { return cache->mapped; }
+
+int64_t csvcache_nrow(csvcache_t *cache) { return cache->hdr->nrow; }
+
+int csvcache_ncol(csvcache_t *cache) { return cache->hdr->ncol; }
+
+const char *csvcache_data(csvcache_t *cache, int64_t *datasz) {
+  *datasz = cache->datasz;
+  return cache->data;
+}
+
+int csvcache_row(csvcache_t *cache, int64_t r, const char **row) {
+  *row = cache->data + cache->rowoff[r];
+  return cache->rowoff[r + 1] - cache->rowoff[r];
+}
+
+int csvcache_field(csvcache_t *cache, int64_t r, int c, const char **raw,
+                   int *quoted) {
+  const int64_t nrow = cache->hdr->nrow;
+  const int32_t len = c < cache->hdr->ncol ? cache->len[c * nrow + r] : -1;
+  if (len == CSVCACHE_NOFIELD) {
+    return -1;
+  }
+  *raw = cache->data + cache->rowoff[r] + cache->off[c * nrow + r];
+  *quoted = !!(len & CSVCACHE_QUOTED);
+  return len & ~CSVCACHE_QUOTED;
+}
+
+int csvcache_value(csvcache_t *cache, int64_t r, int c, char *dst) {
+  const char *raw;
+  int quoted;
+  int len = csvcache_field(cache, r, c, &raw, &quoted);
+  return len < 0 ? -1 : csv_decode(cache->cp, raw, len, quoted, dst);
+}
+
+/* make room for n bytes in scratch[] and nfield pointers in fld[] */
+static int reserve(csvcache_t *cache, int64_t n, int nfield) {
+  if (n > cache->scratchmax) {
+    if (n > INT32_MAX) {
+      return -1;
+    }
+    free(cache->scratch);
+    cache->scratchmax = n < INT32_MAX / 2 ? n * 2 : INT32_MAX;
+    if (!(cache->scratch = malloc(cache->scratchmax))) {
+      cache->scratchmax = 0;
+      return -1;
+    }
+  }
+  if (nfield > cache->fldmax) {
+    free(cache->fld);
+    cache->fldmax = nfield * 2;
+    if (!(cache->fld = malloc(cache->fldmax * sizeof(*cache->fld)))) {
+      cache->fldmax = 0;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int csvcache_scan(csvcache_t *cache, const int *col, int ncol,
+                  intptr_t handle,
+                  int (*on_row)(intptr_t handle, int64_t rownum, char **field,
+                                int nfield)) {
+  const int64_t nrow = cache->hdr->nrow;
+
+  for (int64_t r = 0; r < nrow; r++) {
+    if (col) {
+      /* decode the chosen fields one after another into scratch[] */
+      int64_t need = 0;
+      for (int i = 0; i < ncol; i++) {
+        const int c = col[i];
+        const int32_t len = c >= 0 && c < cache->hdr->ncol
+                                ? cache->len[c * nrow + r]
+                                : CSVCACHE_NOFIELD;
+        if (len != CSVCACHE_NOFIELD) {
+          need += (len & ~CSVCACHE_QUOTED) + 1;
+        }
+      }
+      if (reserve(cache, need, ncol)) {
+        return -1;
+      }
+      char *p = cache->scratch;
+      for (int i = 0; i < ncol; i++) {
+        int n = col[i] < 0 ? -1 : csvcache_value(cache, r, col[i], p);
+        cache->fld[i] = n < 0 ? 0 : p;
+        p += n < 0 ? 0 : n + 1;
+      }
+      if (on_row(handle, r + 1, cache->fld, ncol)) {
+        return -1;
+      }
+      continue;
+    }
+
+    /* copy the row and decode each field in place, like csv_feed() */
+    const char *row;
+    const int rowsz = csvcache_row(cache, r, &row);
+    const int nfield = cache->nfield[r];
+    if (reserve(cache, (int64_t)rowsz + 1, nfield)) {
+      return -1;
+    }
+    memcpy(cache->scratch, row, rowsz);
+    for (int c = 0; c < nfield; c++) {
+      const int32_t len = cache->len[c * nrow + r];
+      char *raw = cache->scratch + cache->off[c * nrow + r];
+      int n = csv_decode(cache->cp, raw, len & ~CSVCACHE_QUOTED,
+                         !!(len & CSVCACHE_QUOTED), raw);
+      cache->fld[c] = n < 0 ? 0 : raw;
+    }
+    if (on_row(handle, r + 1, cache->fld, nfield)) {
+      return -1;
+    }
+  }
+  return 0;
+}
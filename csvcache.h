@@ -0,0 +1,116 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#ifndef CSVCACHE_H
+#define CSVCACHE_H
+
+/*
+
+  A persistent parse cache for csv files that do not change. The first
+  open of FILE scans it once and saves the position of every field in
+  a sidecar file FILE.csvcache. Later opens mmap the sidecar and go
+  straight to the fields without scanning FILE for row and field
+  boundaries.
+
+  The sidecar is used only if the size, mtime, inode and device of
+  FILE, and the quote, escape, delim and nullstr it was built with,
+  are unchanged. Otherwise it is rebuilt.
+
+  The field positions are stored by column, so reading a few columns
+  touches only the pages of those columns:
+
+      rowoff[nrow + 1]   : int64 offset of each row in FILE, and EOF
+      nfield[nrow]       : int32 num fields in each row
+      ncol x off[nrow]   : uint32 offset of each field in its row
+      ncol x len[nrow]   : int32 raw length of each field; bit 31 is set
+                           if the field has a quote char, and -1 means
+                           the row has no such field.
+
+  General usage:
+
+     csvcache_open()
+         csvcache_scan() / csvcache_field() / csvcache_value()
+         ...
+     csvcache_close()
+
+*/
+
+#include "csv.h"
+
+#define CSVCACHE_QUOTED 0x80000000u
+#define CSVCACHE_NOFIELD -1
+
+typedef struct csvcache_t csvcache_t;
+
+/**
+ * Open the csv file at path through its cache. If there is no valid
+ * sidecar, the file is scanned and the sidecar is saved next to it;
+ * if the sidecar cannot be saved, the cache is kept in memory only.
+ *
+ * Params qte, esc, delim and nullstr are as in csv_open(). Returns
+ * NULL on error, with a message in errbuf[0..errbufsz).
+ */
+CSV_EXTERN csvcache_t *csvcache_open(const char *path, int qte, int esc,
+                                     int delim, const char nullstr[20],
+                                     char *errbuf, int errbufsz);
+
+/**
+ * Release the cache.
+ */
+CSV_EXTERN void csvcache_close(csvcache_t *cache);
+
+/**
+ * Check if the sidecar was loaded rather than built by csvcache_open().
+ */
+CSV_EXTERN int csvcache_hit(csvcache_t *cache);
+
+/**
+ * Get the num rows, and the num columns of the widest row.
+ */
+CSV_EXTERN int64_t csvcache_nrow(csvcache_t *cache);
+CSV_EXTERN int csvcache_ncol(csvcache_t *cache);
+
+/**
+ * Get the bytes of the csv file and its size, and the span of row r in
+ * it, including its newline.
+ */
+CSV_EXTERN const char *csvcache_data(csvcache_t *cache, int64_t *datasz);
+CSV_EXTERN int csvcache_row(csvcache_t *cache, int64_t r, const char **row);
+
+/**
+ * Get the raw span of the field at row r, column c in the csv file.
+ * Returns the raw length, or -1 if the row has no such field. Quoted
+ * is set if the field has a quote char and must be decoded.
+ */
+CSV_EXTERN int csvcache_field(csvcache_t *cache, int64_t r, int c,
+                              const char **raw, int *quoted);
+
+/**
+ * Unquote and unescape the field at row r, column c into dst[], which
+ * must have room for the raw length + 1 bytes. Returns the length of
+ * the NUL terminated value, or -1 if the field is NULL or missing.
+ */
+CSV_EXTERN int csvcache_value(csvcache_t *cache, int64_t r, int c,
+                              char *dst);
+
+/**
+ * Call on_row for each row like csv_scan() does, with the fields taken
+ * from the cache. If col is not NULL, only columns col[0..ncol) are
+ * decoded and passed on, in that order; missing fields are passed as
+ * NULL. Returns 0 on success, or -1 if on_row failed or out of memory.
+ */
+CSV_EXTERN int csvcache_scan(csvcache_t *cache, const int *col, int ncol,
+                             intptr_t handle,
+                             int (*on_row)(intptr_t handle, int64_t rownum,
+                                           char **field, int nfield));
+
+#endif /*CSVCACHE_H*/
@@ -0,0 +1,298 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#define _GNU_SOURCE
+#include "csvcol.h"
+#include "csvnum.h"
+#include "csvrd.h"
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char *const typename[] = {"string", "int32", "int64", "float",
+                                       "double", "date",  "bool"};
+static const int typewidth[] = {0, 4, 8, 4, 8, 4, 1};
+#define NTYPE ((int)(sizeof(typename) / sizeof(typename[0])))
+
+static void seterr(char *errbuf, int errbufsz, const char *fmt, ...) {
+  if (errbufsz > 0) {
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(errbuf, errbufsz, fmt, ap);
+    va_end(ap);
+  }
+}
+
+const char *csvcol_name(csvcol_type_t type) { return typename[type]; }
+
+int csvcol_type(const char *name) {
+  for (int i = 0; i < NTYPE; i++) {
+    if (0 == strcmp(name, typename[i])) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int csvcol_width(csvcol_type_t type) { return typewidth[type]; }
+
+static int parse_bool(const char *s, int len, uint8_t *ret) {
+  static const char *const yes[] = {"t", "true", "y", "yes", "on", "1", 0};
+  static const char *const no[] = {"f", "false", "n", "no", "off", "0", 0};
+  for (int i = 0; yes[i]; i++) {
+    if ((int)strlen(yes[i]) == len && 0 == strncasecmp(s, yes[i], len)) {
+      *ret = 1;
+      return 0;
+    }
+    if ((int)strlen(no[i]) == len && 0 == strncasecmp(s, no[i], len)) {
+      *ret = 0;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+int csvcol_value(csvcol_type_t type, const char *s, int len, void *ret) {
+  int64_t i64;
+  double d;
+  int32_t i32;
+  float f;
+  uint8_t b;
+
+  switch (type) {
+  case CSVCOL_STRING:
+    return -1;
+  case CSVCOL_INT32:
+    if (csvnum_int64(s, len, &i64) || i64 != (int32_t)i64) {
+      return -1;
+    }
+    i32 = i64;
+    memcpy(ret, &i32, 4);
+    return 0;
+  case CSVCOL_INT64:
+    if (csvnum_int64(s, len, &i64)) {
+      return -1;
+    }
+    memcpy(ret, &i64, 8);
+    return 0;
+  case CSVCOL_FLOAT:
+    if (csvnum_double(s, len, &d)) {
+      return -1;
+    }
+    f = d;
+    memcpy(ret, &f, 4);
+    return 0;
+  case CSVCOL_DOUBLE:
+    if (csvnum_double(s, len, &d)) {
+      return -1;
+    }
+    memcpy(ret, &d, 8);
+    return 0;
+  case CSVCOL_DATE:
+    if (csvnum_date(s, len, &i32)) {
+      return -1;
+    }
+    memcpy(ret, &i32, 4);
+    return 0;
+  case CSVCOL_BOOL:
+    if (parse_bool(s, len, &b)) {
+      return -1;
+    }
+    memcpy(ret, &b, 1);
+    return 0;
+  }
+  return -1;
+}
+
+/* what the values of a column seen so far can be */
+typedef struct guess_t guess_t;
+struct guess_t {
+  int64_t nval;
+  int isint, isnum, isdate;
+};
+
+/* narrow guess g by the value s[0..len). A value that is not an
+ * integer widens the column to double, and one that is not a number
+ * either to string. */
+static void guess_value(guess_t *g, const char *s, int len) {
+  int64_t i64;
+  double d;
+  int32_t i32;
+
+  g->nval++;
+  if (g->isint && csvnum_int64(s, len, &i64)) {
+    g->isint = 0;
+  }
+  if (g->isnum && !g->isint && csvnum_double(s, len, &d)) {
+    g->isnum = 0;
+  }
+  if (g->isdate && csvnum_date(s, len, &i32)) {
+    g->isdate = 0;
+  }
+}
+
+static csvcol_type_t guess_type(const guess_t *g) {
+  if (g->nval == 0) {
+    return CSVCOL_STRING;
+  }
+  return g->isint    ? CSVCOL_INT64
+         : g->isnum  ? CSVCOL_DOUBLE
+         : g->isdate ? CSVCOL_DATE
+                     : CSVCOL_STRING;
+}
+
+/* write all of p[0..n) to fd */
+static int write_all(int fd, const char *p, int n) {
+  while (n > 0) {
+    int k = write(fd, p, n);
+    if (k < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    p += k;
+    n -= k;
+  }
+  return 0;
+}
+
+/* create an unlinked temp file */
+static int open_temp(void) {
+  const char *dir = getenv("TMPDIR");
+  dir = dir && *dir ? dir : "/tmp";
+  char *path = malloc(strlen(dir) + 20);
+  if (!path) {
+    errno = ENOMEM;
+    return -1;
+  }
+  sprintf(path, "%s/csvcolXXXXXX", dir);
+  int fd = mkstemp(path);
+  if (fd >= 0) {
+    unlink(path);
+  }
+  free(path);
+  return fd;
+}
+
+int csvcol_infer(int *fd, int qte, int esc, int delim, const char *nullstr,
+                 csvcol_type_t **type, int *ntype, char *errbuf,
+                 int errbufsz) {
+  csv_parse_t *cp = 0;
+  csvrd_t in;
+  guess_t *guess = 0;
+  int ncol = -1;
+  int tmpfd = -1;
+  int64_t start = -1;
+  int ret = -1;
+
+  *type = 0;
+  *ntype = 0;
+  if (csvrd_init(&in, *fd, 0)) {
+    seterr(errbuf, errbufsz, "out of memory");
+    return -1;
+  }
+  if (!(cp = csv_open(qte, esc, delim, nullstr))) {
+    seterr(errbuf, errbufsz, "out of memory");
+    goto bail;
+  }
+
+  /* reread a regular file; copy anything else */
+  struct stat st;
+  if (0 == fstat(*fd, &st) && S_ISREG(st.st_mode)) {
+    start = lseek(*fd, 0, SEEK_CUR);
+  }
+  if (start < 0 && (tmpfd = open_temp()) < 0) {
+    seterr(errbuf, errbufsz, "cannot create temp file - %s",
+           strerror(errno));
+    goto bail;
+  }
+
+  char *row;
+  int nb;
+  while ((nb = csvrd_line(&in, cp, &row)) > 0) {
+    if (tmpfd >= 0 && write_all(tmpfd, row, nb)) {
+      seterr(errbuf, errbufsz, "cannot write temp file - %s",
+             strerror(errno));
+      goto bail;
+    }
+
+    char **field;
+    int nfield;
+    csv_touchup(cp, &field, &nfield);
+    if (ncol < 0) {
+      /* the header */
+      ncol = nfield;
+      if (!(guess = malloc((ncol + 1) * sizeof(*guess)))) {
+        seterr(errbuf, errbufsz, "out of memory");
+        goto bail;
+      }
+      for (int i = 0; i < ncol; i++) {
+        guess[i] = (guess_t){0, 1, 1, 1};
+      }
+      continue;
+    }
+    for (int i = 0; i < nfield && i < ncol; i++) {
+      if (field[i]) {
+        guess_value(&guess[i], field[i], strlen(field[i]));
+      }
+    }
+  }
+  if (nb < 0) {
+    seterr(errbuf, errbufsz, "%s", in.errmsg);
+    goto bail;
+  }
+
+  if (ncol > 0) {
+    if (!(*type = malloc(ncol * sizeof(**type)))) {
+      seterr(errbuf, errbufsz, "out of memory");
+      goto bail;
+    }
+    for (int i = 0; i < ncol; i++) {
+      (*type)[i] = guess_type(&guess[i]);
+    }
+    *ntype = ncol;
+  }
+
+  /* rewind for the second read */
+  if (tmpfd >= 0) {
+    if (lseek(tmpfd, 0, SEEK_SET) < 0) {
+      seterr(errbuf, errbufsz, "lseek - %s", strerror(errno));
+      goto bail;
+    }
+    *fd = tmpfd;
+    tmpfd = -1;
+  } else if (lseek(*fd, start, SEEK_SET) < 0) {
+    seterr(errbuf, errbufsz, "lseek - %s", strerror(errno));
+    goto bail;
+  }
+  ret = 0;
+
+bail:
+  if (ret) {
+    free(*type);
+    *type = 0;
+    *ntype = 0;
+  }
+  if (tmpfd >= 0) {
+    close(tmpfd);
+  }
+  free(guess);
+  csv_close(cp);
+  csvrd_fini(&in);
+  return ret;
+}
@@ -0,0 +1,88 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#ifndef CSVCOL_H
+#define CSVCOL_H
+
+/*
+
+  Typed column values for csv2parquet and csv2arrow.
+
+  A column has one of the types of csvcol_type_t. csvcol_value()
+  converts a csv value to the binary value of a type, which is what
+  both formats store for the fixed-width types: a little-endian int,
+  an IEEE float, the days since 1970-01-01 for a date, and one byte of
+  0 or 1 for a bool. Strings are kept as they are by the caller.
+
+  csvcol_infer() reads all the rows of a csv file to pick the type of
+  each column that has no type given, so that no later value can fail
+  to fit it.
+
+*/
+
+#include "csv.h"
+
+typedef enum csvcol_type_t csvcol_type_t;
+enum csvcol_type_t {
+  CSVCOL_STRING,
+  CSVCOL_INT32,
+  CSVCOL_INT64,
+  CSVCOL_FLOAT,
+  CSVCOL_DOUBLE,
+  CSVCOL_DATE,
+  CSVCOL_BOOL
+};
+
+/**
+ * Get the name of type: string, int32, int64, float, double, date or
+ * bool.
+ */
+CSV_EXTERN const char *csvcol_name(csvcol_type_t type);
+
+/**
+ * Get the type with name, or -1 if there is none.
+ */
+CSV_EXTERN int csvcol_type(const char *name);
+
+/**
+ * Get the num bytes of a value of type, or 0 for a string.
+ */
+CSV_EXTERN int csvcol_width(csvcol_type_t type);
+
+/**
+ * Convert s[0..len) to the binary value of type, and store it in
+ * ret[0..csvcol_width(type)). Returns 0 on success, or -1 if s is not
+ * a value of type, or if type is CSVCOL_STRING.
+ */
+CSV_EXTERN int csvcol_value(csvcol_type_t type, const char *s, int len,
+                            void *ret);
+
+/**
+ * Infer the type of each column of the csv file open in *fd, read with
+ * the dialect qte, esc, delim and nullstr. The first row is the header
+ * and gives the num columns; fields past it in later rows are ignored.
+ *
+ * A column is int64 if all its non-null values are integers, double if
+ * they are all numbers, date if they are all YYYY-MM-DD, and string
+ * otherwise, or if it has no values.
+ *
+ * The types are returned in a malloc'ed (*type)[0..*ntype). The file is
+ * then read again from where it was: if *fd can seek, it is moved back
+ * there; otherwise the bytes read are copied to an unlinked temp file,
+ * whose fd is returned in *fd. Returns 0 on success, or -1 with a
+ * message in errbuf.
+ */
+CSV_EXTERN int csvcol_infer(int *fd, int qte, int esc, int delim,
+                            const char *nullstr, csvcol_type_t **type,
+                            int *ntype, char *errbuf, int errbufsz);
+
+#endif /*CSVCOL_H*/
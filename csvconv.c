@@ -0,0 +1,327 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-d delim] [-q quote] [-e esc] [-n nullstr]\n\
+            [-D delim] [-Q quote] [-E esc] [-N nullstr] [-r] [FILE]\n\
+                        \n\
+                        \n\
+  Convert a csv file from one dialect to another. Fields that need no\n\
+  rewriting are copied through as is.\n\
+                                           \n\
+  For example, to convert a pipe-delimited file with backslash escapes\n\
+  into a csv file:                         \n\
+                                           \n\
+    %s -d '|' -e '\\' -n '\\N' FILE         \n\
+                                           \n\
+  or a csv file into a tsv file:           \n\
+                                           \n\
+    %s -D '\\t' FILE                        \n\
+                        \n\
+  INPUT OPTIONS:        \n\
+                        \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      -n nullstr : specify string representing null; default to \"\"     \n\
+                        \n\
+  OUTPUT OPTIONS:       \n\
+                        \n\
+      -D delim   : specify delim char; default to comma                  \n\
+      -Q quote   : specify quote char; default to double-quote           \n\
+      -E esc     : specify escape char; default to the quote char        \n\
+      -N nullstr : specify string representing null; default to \"\"     \n\
+      -r         : end rows with CRLF instead of LF                      \n\
+                        \n\
+      -h         : print this message          \n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csv.h"
+#include "csvrd.h"
+#include "csvwr.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+const char *pname = 0;
+const char *fname = 0;
+
+/* input dialect */
+int qte = '"';
+int esc = 0;
+int delim = ',';
+char nullstr[20] = {0};
+
+/* output dialect */
+int oqte = '"';
+int oesc = 0;
+int odelim = ',';
+char onullstr[20] = {0};
+int ocrlf = 0;
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname, pname, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+/* get the char of a -x char option. \t is accepted for tab. */
+static int charopt(const char *s, const char *msg) {
+  if (0 == strcmp(s, "\\t")) {
+    return '\t';
+  }
+  if (strlen(s) != 1) {
+    usage(1, msg);
+  }
+  return s[0];
+}
+
+/* copy the -x nullstr option */
+static void nullopt(char *dst, const char *s, const char *msg) {
+  if (strlen(s) >= 20) {
+    usage(1, msg);
+  }
+  strcpy(dst, s);
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  while ((opt = getopt(argc, argv, "d:q:e:n:D:Q:E:N:rh")) != -1) {
+    switch (opt) {
+    case 'd':
+      delim = charopt(optarg, "Error: -d delim-char expects a single char.");
+      break;
+    case 'q':
+      qte = charopt(optarg, "Error: -q quote-char expects a single char.");
+      break;
+    case 'e':
+      esc = charopt(optarg, "Error: -e escape-char expects a single char.");
+      break;
+    case 'n':
+      nullopt(nullstr, optarg,
+              "Error: -n nullstr is too long. max is 19 chars");
+      break;
+    case 'D':
+      odelim = charopt(optarg, "Error: -D delim-char expects a single char.");
+      break;
+    case 'Q':
+      oqte = charopt(optarg, "Error: -Q quote-char expects a single char.");
+      break;
+    case 'E':
+      oesc = charopt(optarg, "Error: -E escape-char expects a single char.");
+      break;
+    case 'N':
+      nullopt(onullstr, optarg,
+              "Error: -N nullstr is too long. max is 19 chars");
+      break;
+    case 'r':
+      ocrlf = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* fname */
+  if (optind == argc)
+    ; /* read from stdin */
+  else if (optind + 1 == argc)
+    fname = argv[optind];
+  else
+    usage(1, "Error: please supply only one filename");
+
+  /* esc defaults to the quote char */
+  esc = esc ? esc : qte;
+  oesc = oesc ? oesc : oqte;
+
+  if (odelim == oqte || odelim == oesc || odelim == '\n' || oqte == '\n') {
+    usage(1, "Error: output delim, quote and esc chars must be distinct.");
+  }
+}
+
+/*
+ * special[ch] is set for each char that forces a value to be quoted
+ * on output. If none of them can appear in an unquoted input field,
+ * then unquoted input fields never need to be checked.
+ */
+char special[256];
+int need_check = 0;
+
+int nullsz = 0;  /* strlen(nullstr) */
+int onullsz = 0; /* strlen(onullstr) */
+csvwr_dialect_t odialect; /* output dialect */
+
+/* row buffer; also holds decoded values */
+struct {
+  char *buf;
+  int max;
+} scratch = {0};
+
+static void setup(void) {
+  nullsz = strlen(nullstr);
+  onullsz = strlen(onullstr);
+  odialect = (csvwr_dialect_t){oqte, oesc, odelim, onullstr, onullsz};
+
+  special[(uint8_t)odelim] = 1;
+  special[(uint8_t)oqte] = 1;
+  special[(uint8_t)oesc] = 1;
+  special['\n'] = 1;
+  special['\r'] = 1;
+
+  /* the input delim, quote and newline never appear in an unquoted
+   * field. A bare CR may, but is rare, so conv_row() looks for one in
+   * each row instead. */
+  for (int i = 0; i < 256; i++) {
+    if (special[i] && i != delim && i != qte && i != '\n' && i != '\r') {
+      need_check = 1;
+    }
+  }
+}
+
+/* check if raw field is NULL in the input dialect */
+static inline int is_null(const char *raw, int len) {
+  return len == 0 || (len == nullsz && 0 == memcmp(raw, nullstr, len));
+}
+
+/* convert the row parsed by csv_line() */
+static void conv_row(csv_parse_t *cp, csvwr_t *out) {
+  char **fld;
+  int *len;
+  char *quoted;
+  const int n = csv_rawfields(cp, &fld, &len, &quoted);
+
+  /* an unquoted field with a bare CR must be quoted, or the CR may read
+   * back as part of a CRLF */
+  const char *end = fld[n - 1] + len[n - 1];
+  const int check = need_check || memchr(fld[0], '\r', end - fld[0]);
+
+  /* fast path: the whole row can be copied as is */
+  if (odelim == delim && !check) {
+    int i;
+    for (i = 0; i < n; i++) {
+      if (quoted[i] || is_null(fld[i], len[i]) ||
+          (len[i] == onullsz && 0 == memcmp(fld[i], onullstr, onullsz))) {
+        break;
+      }
+    }
+    if (i == n) {
+      csvwr_write(out, fld[0], end - fld[0]);
+      goto ENDROW;
+    }
+  }
+
+  for (int i = 0; i < n; i++) {
+    const char *s = fld[i];
+    int slen = len[i];
+    if (i) {
+      csvwr_putc(out, odelim);
+    }
+    if (is_null(s, slen)) {
+      csvwr_write(out, onullstr, onullsz);
+      continue;
+    }
+    if (!quoted[i]) {
+      /* the raw bytes are the value */
+      if (!check &&
+          !(slen == onullsz && 0 == memcmp(s, onullstr, onullsz))) {
+        csvwr_write(out, s, slen);
+      } else {
+        csvwr_value(out, &odialect, s, slen);
+      }
+      continue;
+    }
+
+    /* decode into scratch and re-encode */
+    if (slen + 1 > scratch.max) {
+      scratch.max = slen * 2 + 64;
+      free(scratch.buf);
+      if (!(scratch.buf = malloc(scratch.max))) {
+        fatal("ERROR: out of memory\n");
+      }
+    }
+    slen = csv_decode(cp, s, slen, 1, scratch.buf);
+    csvwr_value(out, &odialect, scratch.buf, slen);
+  }
+
+ENDROW:
+  if (ocrlf) {
+    csvwr_write(out, "\r\n", 2);
+  } else {
+    csvwr_putc(out, '\n');
+  }
+}
+
+static void do_conv(int fd) {
+  csv_parse_t *cp = csv_open(qte, esc, delim, nullstr);
+  csvwr_t out;
+  if (!cp || csvwr_init(&out, 1, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  csvrd_t in;
+  if (csvrd_init(&in, fd, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  char *row;
+  int nb;
+  while ((nb = csvrd_line(&in, cp, &row)) > 0) {
+    conv_row(cp, &out);
+  }
+  if (nb < 0) {
+    fatal("ERROR: %s\n", in.errmsg);
+  }
+  if (csvwr_fini(&out)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+
+  csvrd_fini(&in);
+  free(scratch.buf);
+  csv_close(cp);
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+  int fd = 0;
+
+  if (fname && (fd = open(fname, O_RDONLY)) < 0) {
+    perr("ERROR: open %s - %s\n", fname, strerror(errno));
+    exit(1);
+  }
+
+  setup();
+  do_conv(fd);
+
+  close(fd);
+  return 0;
+}
@@ -0,0 +1,325 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] -f cols [-d delim] [-q quote] [-e esc] [FILE]\n\
+                        \n\
+                        \n\
+  Print the columns cols of each row of a csv file, in the order given.\n\
+  Unlike cut -d, a delim inside a quoted field does not split it. The\n\
+  fields are found with csv_rawfields() and copied as they are, without\n\
+  unquoting; columns that are next to each other are copied in one go.\n\
+  A row that is too short gets empty fields.\n\
+                        \n\
+  cols is a comma-separated list of column numbers from 1, ranges N-M,\n\
+  N- or -M, and column names, which are looked up in the header row.\n\
+  For example:          \n\
+                        \n\
+    %s -f 1,4-6,name FILE   \n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -f cols    : specify the columns                                   \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csv.h"
+#include "csvrd.h"
+#include "csvwr.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAXCOL 1000000
+
+const char *pname = 0;
+const char *fname = 0;
+int qte = '"';
+int esc = 0;
+int delim = ',';
+
+/* a range of columns lo to hi inclusive, from 0; hi is -1 for the last
+ * column of the row. A named column has name set until it is looked
+ * up in the header row. */
+typedef struct item_t item_t;
+struct item_t {
+  int lo, hi;
+  char *name;
+};
+
+item_t *item = 0;
+int nitem = 0;
+int nnamed = 0; /* num items not looked up yet */
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+/* parse a column number from 1 in s[0..len), or return -1 */
+static int colnum(const char *s, int len) {
+  int n = 0;
+  if (len == 0 || len > 7) {
+    return -1;
+  }
+  for (int i = 0; i < len; i++) {
+    if (s[i] < '0' || s[i] > '9') {
+      return -1;
+    }
+    n = n * 10 + s[i] - '0';
+  }
+  return n >= 1 && n <= MAXCOL ? n : -1;
+}
+
+/* parse the -f cols option */
+static void parse_cols(char *s) {
+  const char *msg = "Error: -f cols expects numbers, ranges or names.";
+  for (char *tok = strtok(s, ","); tok; tok = strtok(0, ",")) {
+    if (!(item = realloc(item, (nitem + 1) * sizeof(*item)))) {
+      fatal("ERROR: out of memory\n");
+    }
+    item_t *it = &item[nitem++];
+    const int len = strlen(tok);
+    const char *dash = strchr(tok, '-');
+    int lo, hi;
+    if ((lo = colnum(tok, len)) > 0) {
+      *it = (item_t){lo - 1, lo - 1, 0};
+    } else if (dash && dash == tok && (hi = colnum(dash + 1, len - 1)) > 0) {
+      *it = (item_t){0, hi - 1, 0};
+    } else if (dash && (lo = colnum(tok, dash - tok)) > 0 && !dash[1]) {
+      *it = (item_t){lo - 1, -1, 0};
+    } else if (dash && lo > 0 &&
+               (hi = colnum(dash + 1, len - (dash - tok) - 1)) > 0) {
+      if (hi < lo) {
+        usage(1, msg);
+      }
+      *it = (item_t){lo - 1, hi - 1, 0};
+    } else if (strspn(tok, "0123456789-") == (size_t)len) {
+      usage(1, msg);
+    } else {
+      *it = (item_t){-1, -1, tok};
+      nnamed++;
+    }
+  }
+  if (nitem == 0) {
+    usage(1, msg);
+  }
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d, *f;
+  q = e = d = f = 0;
+  while ((opt = getopt(argc, argv, "d:q:e:f:h")) != -1) {
+    switch (opt) {
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'f':
+      f = optarg;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* cols */
+  if (!f) {
+    usage(1, "Error: please supply -f cols");
+  }
+  parse_cols(f);
+
+  /* fname */
+  if (optind + 1 < argc) {
+    usage(1, "Error: too many args");
+  }
+  if (optind < argc && strcmp(argv[optind], "-")) {
+    fname = argv[optind];
+  }
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  esc = qte;
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+}
+
+/* look up the named columns in the header row parsed by csv_line() */
+static void find_names(csv_parse_t *cp) {
+  char **fld;
+  int *len;
+  char *quoted;
+  const int n = csv_rawfields(cp, &fld, &len, &quoted);
+  char *val = 0;
+  int valmax = 0;
+  for (int i = 0; i < nitem; i++) {
+    if (!item[i].name) {
+      continue;
+    }
+    int j;
+    for (j = 0; j < n; j++) {
+      if (len[j] + 1 > valmax) {
+        valmax = len[j] * 2 + 64;
+        free(val);
+        if (!(val = malloc(valmax))) {
+          fatal("ERROR: out of memory\n");
+        }
+      }
+      int vlen = csv_decode(cp, fld[j], len[j], quoted[j], val);
+      if (vlen >= 0 && 0 == strcmp(val, item[i].name)) {
+        break;
+      }
+    }
+    if (j == n) {
+      fatal("ERROR: no column named '%s'\n", item[i].name);
+    }
+    item[i] = (item_t){j, j, 0};
+  }
+  nnamed = 0;
+  free(val);
+}
+
+/* print the columns of the row parsed by csv_line() */
+static void cut_row(csv_parse_t *cp, csvwr_t *out) {
+  char **fld;
+  int *len;
+  char *quoted;
+  const int n = csv_rawfields(cp, &fld, &len, &quoted);
+
+  /* a run of columns a to b that are next to each other in the row is
+   * copied in one go, delims and all */
+  int a = -1, b = -1;
+  int nout = 0;
+  for (int i = 0; i < nitem; i++) {
+    const int hi = item[i].hi < 0 ? n - 1 : item[i].hi;
+    for (int j = item[i].lo; j <= hi; j++) {
+      if (a >= 0 && j == b + 1 && j < n) {
+        b = j;
+        continue;
+      }
+      if (a >= 0) {
+        csvwr_write(out, fld[a], fld[b] + len[b] - fld[a]);
+        a = -1;
+      }
+      if (nout++) {
+        csvwr_putc(out, delim);
+      }
+      if (j < n) {
+        a = b = j;
+      }
+    }
+  }
+  if (a >= 0) {
+    csvwr_write(out, fld[a], fld[b] + len[b] - fld[a]);
+  }
+  csvwr_putc(out, '\n');
+}
+
+static void do_cut(int fd) {
+  csv_parse_t *cp = csv_open(qte, esc, delim, 0);
+  csvwr_t out;
+  if (!cp || csvwr_init(&out, 1, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  csvrd_t in;
+  if (csvrd_init(&in, fd, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  char *row;
+  int nb;
+  while ((nb = csvrd_line(&in, cp, &row)) > 0) {
+    if (nnamed) {
+      find_names(cp);
+    }
+    cut_row(cp, &out);
+    if (out.err) {
+      fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+    }
+  }
+  if (nb < 0) {
+    fatal("ERROR: %s\n", in.errmsg);
+  }
+  if (csvwr_fini(&out)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+
+  csvrd_fini(&in);
+  csv_close(cp);
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+  int fd = 0;
+
+  if (fname && (fd = open(fname, O_RDONLY)) < 0) {
+    perr("ERROR: open %s - %s\n", fname, strerror(errno));
+    exit(1);
+  }
+
+  do_cut(fd);
+
+  close(fd);
+  free(item);
+  return 0;
+}
@@ -0,0 +1,333 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-v] [-b] [-k col] [-r rows] [-d delim] [-q quote] [-e esc]\n\
+            [-n nullstr] FILE KEY ...\n\
+                        \n\
+                        \n\
+  Print the rows of a csv file where column col equals one of the KEYs.\n\
+  Only the blocks of rows whose Bloom filter may hold a KEY are parsed.\n\
+  The filters are kept in FILE.csvbloom and the row index in\n\
+  FILE.csvidx; both are built first if missing or out of date. See\n\
+  csvbloom.h and csvidx.h.\n\
+                        \n\
+  With -b, a bitmap index in FILE.csvbmp is used instead, which has\n\
+  the exact blocks of each value; it is for columns with few distinct\n\
+  values, and the Bloom filters are used if the column has too many.\n\
+  See csvbmp.h.\n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -v         : print the num blocks parsed to stderr                 \n\
+      -b         : use the bitmap index                                  \n\
+      -k col     : specify the key column by number from 1, or by name   \n\
+                   in the header row; default to 1                        \n\
+      -r rows    : specify rows per block if the index is built;         \n\
+                   default to 1024                                        \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      -n nullstr : specify string representing null; default to \"\"     \n\
+      \n\
+  If col is a name, the header row is not matched.\n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csvbloom.h"
+#include "csvbmp.h"
+#include "csvidx.h"
+#include "csvwr.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+const char *pname = 0;
+const char *fname = 0;
+char *const *key = 0;
+int nkey = 0;
+const char *colname = "1";
+int col = -1;
+int verbose = 0;
+int usebmp = 0;
+int qte = '"';
+int esc = 0;
+int delim = ',';
+char nullstr[20] = {0};
+int nullsz = 0;
+csvwr_dialect_t odialect; /* output dialect */
+int64_t stride = 0;
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d, *n;
+  q = e = d = n = 0;
+  while ((opt = getopt(argc, argv, "d:q:e:n:k:r:bvh")) != -1) {
+    switch (opt) {
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'n':
+      n = optarg;
+      break;
+    case 'k':
+      colname = optarg;
+      break;
+    case 'r':
+      stride = strtoll(optarg, 0, 10);
+      if (stride <= 0) {
+        usage(1, "Error: -r rows expects a positive number.");
+      }
+      break;
+    case 'v':
+      verbose = 1;
+      break;
+    case 'b':
+      usebmp = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* fname, keys */
+  if (optind + 2 > argc) {
+    usage(1, "Error: please supply FILE and KEY");
+  }
+  fname = argv[optind];
+  key = argv + optind + 1;
+  nkey = argc - optind - 1;
+
+  /* col */
+  char *end;
+  long c = strtol(colname, &end, 10);
+  if (*colname && !*end) {
+    if (c <= 0 || c > 1000000) {
+      usage(1, "Error: -k col expects a column number from 1, or a name.");
+    }
+    col = c - 1;
+  }
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  esc = qte;
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+
+  /* nullstr */
+  if (n) {
+    if (strlen(n) >= 20) {
+      usage(1, "Error: -n nullstr is too long. max is 19 chars");
+    }
+    strcpy(nullstr, n);
+  }
+  nullsz = strlen(nullstr);
+
+  odialect = (csvwr_dialect_t){qte, esc, delim, nullstr, nullsz};
+}
+
+/* find colname in the header row */
+int do_header(intptr_t handle, int64_t rownum, char **field, int nfield) {
+  (void)handle;
+  (void)rownum;
+  for (int i = 0; i < nfield; i++) {
+    if (field[i] && 0 == strcmp(field[i], colname)) {
+      col = i;
+      return 0;
+    }
+  }
+  return 0;
+}
+
+/* print the row if it has a key */
+int do_row(intptr_t handle, int64_t rownum, char **field, int nfield) {
+  csvwr_t *out = (csvwr_t *)handle;
+  (void)rownum;
+  if (col >= nfield || !field[col]) {
+    return 0;
+  }
+  int i;
+  for (i = 0; i < nkey && strcmp(field[col], key[i]); i++)
+    ;
+  if (i == nkey) {
+    return 0;
+  }
+
+  for (int j = 0; j < nfield; j++) {
+    if (j) {
+      csvwr_putc(out, delim);
+    }
+    csvwr_value(out, &odialect, field[j], field[j] ? strlen(field[j]) : 0);
+  }
+  csvwr_putc(out, '\n');
+  return out->err ? -1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+
+  char errbuf[200];
+  csvidx_t *idx = csvidx_open(fname, qte, esc, delim, nullstr, stride, errbuf,
+                              sizeof(errbuf));
+  if (!idx) {
+    fatal("ERROR: %s\n", errbuf);
+  }
+
+  /* a named column is looked up in the header row, which is skipped */
+  int64_t first = 1;
+  if (col < 0) {
+    if (csvidx_read_rows(idx, 1, 1, 0, do_header) < 0) {
+      fatal("ERROR: %s\n", csvidx_errmsg(idx));
+    }
+    if (col < 0) {
+      fatal("ERROR: no column named '%s'\n", colname);
+    }
+    first = 2;
+  }
+
+  csvbmp_t *bmp = 0;
+  if (usebmp) {
+    bmp = csvbmp_open(fname, qte, esc, delim, nullstr, col,
+                      csvidx_stride(idx), errbuf, sizeof(errbuf));
+    if (!bmp && verbose) {
+      perr("%s: using Bloom filters - %s\n", fname, errbuf);
+    }
+  }
+
+  csvbloom_t *bloom = 0;
+  if (!bmp) {
+    bloom = csvbloom_open(fname, qte, esc, delim, nullstr, col,
+                          csvidx_stride(idx), errbuf, sizeof(errbuf));
+    if (!bloom) {
+      fatal("ERROR: %s\n", errbuf);
+    }
+  }
+
+  /* the candidate blocks: from the bitmaps of the keys, or else from
+   * the hashes of the keys */
+  const int64_t nblock = bmp ? csvbmp_nblock(bmp) : csvbloom_nblock(bloom);
+  uint64_t *set = 0;
+  uint64_t hash[nkey];
+  if (bmp) {
+    if (!(set = calloc((nblock + 63) / 64 + 1, sizeof(*set)))) {
+      fatal("ERROR: out of memory\n");
+    }
+    for (int i = 0; i < nkey; i++) {
+      int id = csvbmp_find(bmp, key[i], strlen(key[i]));
+      if (id >= 0) {
+        csvbmp_or(bmp, id, set);
+      }
+    }
+  } else {
+    for (int i = 0; i < nkey; i++) {
+      hash[i] = csvbloom_hash(key[i], strlen(key[i]));
+    }
+  }
+
+  csvwr_t out;
+  if (csvwr_init(&out, 1, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  /* parse only the blocks that may have a key */
+  const int64_t rows = csvidx_stride(idx);
+  int64_t nparsed = 0;
+  for (int64_t k = 0; k < nblock; k++) {
+    if (set) {
+      if (!(set[k / 64] & (1ull << (k % 64)))) {
+        continue;
+      }
+    } else {
+      int i;
+      for (i = 0; i < nkey && !csvbloom_test(bloom, k, hash[i]); i++)
+        ;
+      if (i == nkey) {
+        continue;
+      }
+    }
+    nparsed++;
+    int64_t start = k * rows + 1;
+    int64_t count = rows;
+    if (start < first) {
+      count -= first - start;
+      start = first;
+    }
+    if (count > 0 &&
+        csvidx_read_rows(idx, start, count, (intptr_t)&out, do_row) < 0) {
+      fatal("ERROR: %s\n", out.err ? strerror(out.err) : csvidx_errmsg(idx));
+    }
+  }
+  if (csvwr_fini(&out)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+  if (verbose) {
+    perr("%s: parsed %" PRId64 " of %" PRId64 " blocks\n", fname, nparsed,
+         nblock);
+  }
+
+  free(set);
+  csvbmp_close(bmp);
+  csvbloom_close(bloom);
+  csvidx_close(idx);
+  return 0;
+}
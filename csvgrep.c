@@ -0,0 +1,409 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-v] [-H] [-c col] {-e pattern | -r regex}\n\
+            [-d delim] [-q quote] [-E esc] [-n nullstr] [FILE]\n\
+                        \n\
+                        \n\
+  Print the rows of a csv file where the value of column col, or of any\n\
+  column, contains pattern, or matches regex as in grep -E; see csvre.h\n\
+  for the syntax. Unlike grep, a match must lie within one value, after\n\
+  unquoting, and a row is a csv row rather than a line. The rows are\n\
+  printed as they are in the file.\n\
+                        \n\
+  Each buffer of rows is first searched for pattern as bytes with SIMD\n\
+  compares of its first and last bytes; a row without a hit is passed\n\
+  over without looking at its fields. A regex is searched for by the\n\
+  longest literal that every match contains, and the values of the rows\n\
+  with a hit are run through a DFA that is built lazily from the regex.\n\
+  This assumes the usual quoting, where a quote char inside a quoted\n\
+  value is escaped: a value split by stray quotes, like a\"b\"c, may be\n\
+  missed.\n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -v         : print the rows that do not match                      \n\
+      -H         : print the header row first, and do not match it       \n\
+      -c col     : specify the column by number from 1, or by name in    \n\
+                   the header row; default to any column                 \n\
+      -e pattern : specify the text to look for                          \n\
+      -r regex   : specify the regular expression to look for            \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -E esc     : specify escape char; default to the quote char        \n\
+      -n nullstr : specify string representing null; default to \"\"     \n\
+      \n\
+  If col is a name, the first row is the header and is not matched.\n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csv.h"
+#include "csvrd.h"
+#include "csvre.h"
+#include "csvwr.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __ARM_NEON__
+#include "simde/x86/avx2.h"
+#else
+#include <x86intrin.h>
+#endif
+
+const char *pname = 0;
+const char *fname = 0;
+const char *colname = 0;
+int col = -1; /* -1 for any column */
+const char *pat = 0;
+int patsz = 0;
+csvre_t *re = 0;
+int invert = 0;
+int header = 0;
+int prefilter = 1; /* the raw bytes of a matching row have pat */
+int qte = '"';
+int esc = 0;
+int delim = ',';
+char nullstr[20] = {0};
+int nullsz = 0;
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d, *n, *r;
+  q = e = d = n = r = 0;
+  while ((opt = getopt(argc, argv, "c:e:r:d:q:E:n:vHh")) != -1) {
+    switch (opt) {
+    case 'c':
+      colname = optarg;
+      break;
+    case 'e':
+      pat = optarg;
+      break;
+    case 'r':
+      r = optarg;
+      break;
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'E':
+      e = optarg;
+      break;
+    case 'n':
+      n = optarg;
+      break;
+    case 'v':
+      invert = 1;
+      break;
+    case 'H':
+      header = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* pattern; for a regex, pat is its literal */
+  if (!pat == !r) {
+    usage(1, "Error: please supply one of -e pattern and -r regex");
+  }
+  if (r) {
+    char errbuf[100];
+    if (!(re = csvre_open(r, errbuf, sizeof(errbuf)))) {
+      usage(1, errbuf);
+    }
+    pat = csvre_literal(re, &patsz);
+  } else {
+    patsz = strlen(pat);
+  }
+
+  /* fname */
+  if (optind + 1 < argc) {
+    usage(1, "Error: too many args");
+  }
+  if (optind < argc && strcmp(argv[optind], "-")) {
+    fname = argv[optind];
+  }
+
+  /* col */
+  if (colname) {
+    char *end;
+    long c = strtol(colname, &end, 10);
+    if (*colname && !*end) {
+      if (c <= 0 || c > 1000000) {
+        usage(1, "Error: -c col expects a column number from 1, or a name.");
+      }
+      col = c - 1;
+      colname = 0;
+    } else {
+      header = header ? header : -1; /* skip the header row */
+    }
+  }
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  esc = qte;
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -E escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+
+  /* nullstr */
+  if (n) {
+    if (strlen(n) >= 20) {
+      usage(1, "Error: -n nullstr is too long. max is 19 chars");
+    }
+    strcpy(nullstr, n);
+    nullsz = strlen(nullstr);
+  }
+
+  /* a quote or escape in pat is escaped in the raw bytes, and an empty
+   * pat is everywhere, so the raw bytes tell nothing */
+  if (patsz == 0 || memchr(pat, qte, patsz) || memchr(pat, esc, patsz)) {
+    prefilter = 0;
+  }
+}
+
+/* find pat in s[0..end); returns its start or NULL. 32 positions are
+ * tried at a time by comparing the first and last bytes of pat; only
+ * where both agree are the bytes between compared. */
+static const char *find(const char *s, const char *end) {
+  const int k = patsz;
+  if (end - s < k) {
+    return 0;
+  }
+  if (k <= 1) {
+    return k ? memchr(s, pat[0], end - s) : s;
+  }
+  const __m256i first = _mm256_set1_epi8(pat[0]);
+  const __m256i last = _mm256_set1_epi8(pat[k - 1]);
+  for (; end - s >= k - 1 + 32; s += 32) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)s);
+    __m256i b = _mm256_loadu_si256((const __m256i *)(s + k - 1));
+    __m256i m = _mm256_and_si256(_mm256_cmpeq_epi8(a, first),
+                                 _mm256_cmpeq_epi8(b, last));
+    uint32_t mask = _mm256_movemask_epi8(m);
+    for (; mask; mask &= mask - 1) {
+      const int i = __builtin_ctz(mask);
+      if (0 == memcmp(s + i + 1, pat + 1, k - 2)) {
+        return s + i;
+      }
+    }
+  }
+  for (; end - s >= k; s++) {
+    if (s[0] == pat[0] && 0 == memcmp(s + 1, pat + 1, k - 1)) {
+      return s;
+    }
+  }
+  return 0;
+}
+
+/* scratch space for decoded values */
+struct {
+  char *buf;
+  int max;
+} scratch = {0};
+
+/* check if the value s[0..len) matches */
+static int match_value(const char *s, int len) {
+  if (!re) {
+    return find(s, s + len) != 0;
+  }
+  int ret = csvre_match(re, s, len);
+  if (ret < 0) {
+    fatal("ERROR: out of memory\n");
+  }
+  return ret;
+}
+
+/* check if raw field fld[0..len) has a match in its value */
+static int match_field(csv_parse_t *cp, const char *fld, int len,
+                       int quoted) {
+  if (!quoted) {
+    /* the raw bytes are the value, unless it is NULL */
+    if (len == nullsz && 0 == memcmp(fld, nullstr, len)) {
+      return 0;
+    }
+    return match_value(fld, len);
+  }
+  if (len + 1 > scratch.max) {
+    scratch.max = len * 2 + 64;
+    free(scratch.buf);
+    if (!(scratch.buf = malloc(scratch.max))) {
+      fatal("ERROR: out of memory\n");
+    }
+  }
+  int n = csv_decode(cp, fld, len, quoted, scratch.buf);
+  return n >= 0 && match_value(scratch.buf, n);
+}
+
+/* check if the row parsed by csv_line() matches */
+static int match_row(csv_parse_t *cp) {
+  char **fld;
+  int *len;
+  char *quoted;
+  const int n = csv_rawfields(cp, &fld, &len, &quoted);
+  if (col >= 0) {
+    return col < n && match_field(cp, fld[col], len[col], quoted[col]);
+  }
+  for (int i = 0; i < n; i++) {
+    if (match_field(cp, fld[i], len[i], quoted[i])) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* look up colname in the header row parsed by csv_line() */
+static void find_col(csv_parse_t *cp) {
+  char **fld;
+  int *len;
+  char *quoted;
+  const int n = csv_rawfields(cp, &fld, &len, &quoted);
+  for (int i = 0; i < n && col < 0; i++) {
+    char val[len[i] + 1];
+    if (csv_decode(cp, fld[i], len[i], quoted[i], val) >= 0 &&
+        0 == strcmp(val, colname)) {
+      col = i;
+    }
+  }
+  if (col < 0) {
+    fatal("ERROR: no column named '%s'\n", colname);
+  }
+}
+
+static void do_grep(int fd) {
+  csv_parse_t *cp = csv_open(qte, esc, delim, nullstr);
+  csvwr_t out;
+  if (!cp || csvwr_init(&out, 1, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  csvrd_t in;
+  if (csvrd_init(&in, fd, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  // hit is the input offset of the next place at or after the current
+  // row where pat is in the raw bytes, or of the end of the bytes read
+  // so far if there is none.
+  int64_t hit = -1;
+  int first = 1; /* the next row is the first */
+  char *row;
+  int nb;
+  while ((nb = csvrd_line(&in, cp, &row)) > 0) {
+    if (first) {
+      first = 0;
+      if (colname) {
+        find_col(cp);
+      }
+      if (header) {
+        if (header > 0) {
+          csvwr_write(&out, row, nb);
+        }
+        continue;
+      }
+    }
+
+    int match = 0;
+    if (prefilter) {
+      const int64_t off = in.off + (row - in.buf);
+      if (hit < off) {
+        const char *end = in.buf + in.q;
+        const char *h = find(row, end);
+        hit = in.off + ((h ? h : end) - in.buf);
+      }
+      match = hit < off + nb && match_row(cp);
+    } else {
+      match = match_row(cp);
+    }
+    if (match != invert) {
+      csvwr_write(&out, row, nb);
+    }
+    if (out.err) {
+      fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+    }
+  }
+  if (nb < 0) {
+    fatal("ERROR: %s\n", in.errmsg);
+  }
+  if (csvwr_fini(&out)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+
+  csvrd_fini(&in);
+  free(scratch.buf);
+  csv_close(cp);
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+  int fd = 0;
+
+  if (fname && (fd = open(fname, O_RDONLY)) < 0) {
+    perr("ERROR: open %s - %s\n", fname, strerror(errno));
+    exit(1);
+  }
+
+  do_grep(fd);
+
+  close(fd);
+  csvre_close(re);
+  return 0;
+}
@@ -0,0 +1,403 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#define _GNU_SOURCE
+#include "csvidx.h"
+#include "csvside.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define MAGIC "CSVIDX2\n"
+
+/* the sidecar starts with this header; the varints follow */
+typedef struct header_t header_t;
+struct header_t {
+  csvside_id_t id;
+  /* shape */
+  int64_t stride;
+  int64_t nrow;
+  int64_t nentry;
+  int64_t varintsz; /* num bytes of varints after the header */
+};
+
+struct csvidx_t {
+  header_t hdr;
+  int64_t *off; /* off[nentry] */
+  int hit;
+
+  /* for reading rows */
+  int fd;
+  csv_parse_t *cp;
+  char *buf;      /* bytes of the file from bufoff */
+  int64_t bufoff; /* file offset of buf[0] */
+  int bufsz;      /* num bytes in buf[] */
+  int bufmax;     /* num allocated bytes in buf[] */
+  int pos;        /* the cursor: buf[pos] is the start of row currow */
+  int64_t currow; /* 0 if there is no cursor */
+  char errmsg[200];
+};
+
+/* load the sidecar at path if it matches want. Returns 0 on success. */
+static int load_sidecar(csvidx_t *idx, const char *path,
+                        const header_t *want) {
+  int64_t sz;
+  char *buf = csvside_map(path, sizeof(header_t), &sz);
+  if (!buf) {
+    return -1;
+  }
+
+  header_t hdr;
+  memcpy(&hdr, buf, sizeof(hdr));
+  /* the stride only matters if one was asked for */
+  if (!csvside_match(&hdr.id, &want->id) ||
+      (want->stride && hdr.stride != want->stride) || hdr.stride <= 0 ||
+      hdr.nrow < 0 || hdr.nentry != (hdr.nrow + hdr.stride - 1) / hdr.stride ||
+      hdr.varintsz != sz - (int64_t)sizeof(hdr)) {
+    goto bail;
+  }
+
+  /* decode the deltas */
+  if (!(idx->off = malloc((hdr.nentry + 1) * sizeof(*idx->off)))) {
+    goto bail;
+  }
+  const uint8_t *p = (const uint8_t *)buf + sizeof(hdr);
+  const uint8_t *const q = (const uint8_t *)buf + sz;
+  int64_t off = 0;
+  for (int64_t k = 0; k < hdr.nentry; k++) {
+    uint64_t v = 0;
+    int shift = 0;
+    do {
+      if (p == q || shift > 63) {
+        goto bail;
+      }
+      v |= (uint64_t)(*p & 0x7f) << shift;
+      shift += 7;
+    } while (*p++ & 0x80);
+    off += v;
+    if (off >= hdr.id.fsize) {
+      goto bail;
+    }
+    idx->off[k] = off;
+  }
+  if (p != q) {
+    goto bail;
+  }
+
+  idx->hdr = hdr;
+  munmap(buf, sz);
+  return 0;
+
+bail:
+  free(idx->off);
+  idx->off = 0;
+  munmap(buf, sz);
+  return -1;
+}
+
+/* scan the csv file in fd and note the offset of every stride-th row */
+static int scan_file(csvidx_t *idx, int fd, char *errbuf, int errbufsz) {
+  header_t *hdr = &idx->hdr;
+  int64_t max = 0;
+
+  csvside_scan_t sc;
+  if (csvside_scan_open(&sc, fd, 0, hdr->id.fsize, errbuf, errbufsz)) {
+    return -1;
+  }
+  const char *row;
+  int nb;
+  while ((nb = csvside_scan_next(&sc, idx->cp, &row, errbuf, errbufsz)) > 0) {
+    if ((sc.rownum - 1) % hdr->stride == 0) {
+      if (hdr->nentry == max) {
+        max = max * 1.5 + 1024;
+        int64_t *p = realloc(idx->off, max * sizeof(*p));
+        if (!p) {
+          csvside_seterr(errbuf, errbufsz, "out of memory");
+          nb = -1;
+          break;
+        }
+        idx->off = p;
+      }
+      idx->off[hdr->nentry++] = sc.off;
+    }
+  }
+  hdr->nrow = sc.rownum;
+
+  csvside_scan_close(&sc);
+  return nb;
+}
+
+/* put v as a varint at p; returns the num bytes */
+static int put_varint(uint8_t *p, uint64_t v) {
+  int n = 0;
+  for (; v >= 0x80; v >>= 7) {
+    p[n++] = (v & 0x7f) | 0x80;
+  }
+  p[n++] = v;
+  return n;
+}
+
+/* write the sidecar into path atomically; failure is not an error */
+static void save_sidecar(csvidx_t *idx, const char *path) {
+  header_t *hdr = &idx->hdr;
+  uint8_t *buf = malloc(sizeof(*hdr) + hdr->nentry * 10);
+  if (!buf) {
+    return;
+  }
+  uint8_t *p = buf + sizeof(*hdr);
+  for (int64_t k = 0, prev = 0; k < hdr->nentry; k++) {
+    p += put_varint(p, idx->off[k] - prev);
+    prev = idx->off[k];
+  }
+  hdr->varintsz = p - buf - sizeof(*hdr);
+  memcpy(buf, hdr, sizeof(*hdr));
+  csvside_save(path, buf, p - buf);
+  free(buf);
+}
+
+csvidx_t *csvidx_open(const char *path, int qte, int esc, int delim,
+                      const char nullstr[20], int64_t stride, char *errbuf,
+                      int errbufsz) {
+  csvidx_t *idx = calloc(1, sizeof(*idx));
+  int fd = -1;
+  char *sidecar = 0;
+  if (!idx || !(sidecar = malloc(strlen(path) + 10))) {
+    csvside_seterr(errbuf, errbufsz, "out of memory");
+    goto bail;
+  }
+  idx->fd = -1;
+  sprintf(sidecar, "%s.csvidx", path);
+  if (stride < 0) {
+    csvside_seterr(errbuf, errbufsz, "bad stride %" PRId64, stride);
+    goto bail;
+  }
+
+  /* the nullstr is not recorded, as it does not change the rows */
+  header_t want;
+  memset(&want, 0, sizeof(want));
+  if ((fd = open(path, O_RDONLY)) < 0 ||
+      csvside_identity(&want.id, MAGIC, fd, qte, esc, delim, 0)) {
+    csvside_seterr(errbuf, errbufsz, "open %s - %s", path, strerror(errno));
+    goto bail;
+  }
+  const csvside_id_t *id = &want.id;
+  if (!(idx->cp = csv_open(id->qte, id->esc, id->delim, nullstr))) {
+    csvside_seterr(errbuf, errbufsz, "out of memory");
+    goto bail;
+  }
+  want.stride = stride;
+  if (0 == load_sidecar(idx, sidecar, &want)) {
+    idx->hit = 1;
+  } else {
+    idx->hdr = want;
+    idx->hdr.stride = stride ? stride : CSVIDX_STRIDE;
+    if (scan_file(idx, fd, errbuf, errbufsz)) {
+      goto bail;
+    }
+    save_sidecar(idx, sidecar);
+  }
+
+  idx->fd = fd;
+  free(sidecar);
+  return idx;
+
+bail:
+  if (fd >= 0) {
+    close(fd);
+  }
+  free(sidecar);
+  csvidx_close(idx);
+  return 0;
+}
+
+void csvidx_close(csvidx_t *idx) {
+  if (idx) {
+    if (idx->fd >= 0) {
+      close(idx->fd);
+    }
+    if (idx->cp) {
+      csv_close(idx->cp);
+    }
+    free(idx->buf);
+    free(idx->off);
+    free(idx);
+  }
+}
+
+int csvidx_hit(csvidx_t *idx) { return idx->hit; }
+
+int64_t csvidx_nrow(csvidx_t *idx) { return idx->hdr.nrow; }
+
+int64_t csvidx_fsize(csvidx_t *idx) { return idx->hdr.id.fsize; }
+
+int64_t csvidx_stride(csvidx_t *idx) { return idx->hdr.stride; }
+
+int64_t csvidx_nentry(csvidx_t *idx) { return idx->hdr.nentry; }
+
+int64_t csvidx_offset(csvidx_t *idx, int64_t k) { return idx->off[k]; }
+
+/* put the cursor at off, the start of row rownum */
+static void set_cursor(csvidx_t *idx, int64_t off, int64_t rownum) {
+  /* keep buf[] if off is in it; rows before the cursor may have been
+   * decoded in place, so only the part after the cursor can be used */
+  if (off >= idx->bufoff + idx->pos && off <= idx->bufoff + idx->bufsz) {
+    idx->pos = off - idx->bufoff;
+  } else {
+    idx->bufoff = off;
+    idx->bufsz = idx->pos = 0;
+  }
+  idx->currow = rownum;
+}
+
+/* read more of the file after buf[], keeping the cursor */
+static int fill(csvidx_t *idx) {
+  /* move the rest of buf[] from the cursor to the front */
+  memmove(idx->buf, idx->buf + idx->pos, idx->bufsz - idx->pos);
+  idx->bufoff += idx->pos;
+  idx->bufsz -= idx->pos;
+  idx->pos = 0;
+
+  /* keep a spare byte to put a newline after the last row */
+  if (idx->bufsz + 1 >= idx->bufmax) {
+    if (idx->bufmax >= CSV_WINDOW) {
+      csvside_seterr(idx->errmsg, sizeof(idx->errmsg), "row too long");
+      return -1;
+    }
+    int max = idx->bufmax ? idx->bufmax * 2 : 1024 * 1024;
+    char *p = realloc(idx->buf, max);
+    if (!p) {
+      csvside_seterr(idx->errmsg, sizeof(idx->errmsg), "out of memory");
+      return -1;
+    }
+    idx->buf = p;
+    idx->bufmax = max;
+  }
+
+  const int64_t off = idx->bufoff + idx->bufsz;
+  int64_t want = idx->hdr.id.fsize - off;
+  want = want < idx->bufmax - 1 - idx->bufsz ? want
+                                             : idx->bufmax - 1 - idx->bufsz;
+  ssize_t nb;
+  while ((nb = pread(idx->fd, idx->buf + idx->bufsz, want, off)) < 0 &&
+         errno == EINTR)
+    ;
+  if (nb <= 0) {
+    csvside_seterr(idx->errmsg, sizeof(idx->errmsg), "pread - %s",
+                   nb < 0 ? strerror(errno) : "file was truncated");
+    return -1;
+  }
+  idx->bufsz += nb;
+  return 0;
+}
+
+/* parse the row at the cursor with csv_line(). Returns its size, or 0
+ * at the end of the file, or -1 on error. */
+static int next_row(csvidx_t *idx) {
+  for (;;) {
+    char *const p = idx->buf + idx->pos;
+    const int n = idx->bufsz - idx->pos;
+    const int eof = (idx->bufoff + idx->bufsz >= idx->hdr.id.fsize);
+    int nb = n > 0 ? csv_line(idx->cp, p, n) : 0;
+    if (nb == 0 && n > 0 && eof) {
+      /* the last row has no newline; parse it with one */
+      p[n] = '\n';
+      nb = csv_line(idx->cp, p, n + 1);
+      if (nb == 0) {
+        csvside_seterr(idx->errmsg, sizeof(idx->errmsg),
+                       "unterminated quote at end of file");
+        return -1;
+      }
+      nb = nb > n ? n : nb;
+    }
+    if (nb < 0) {
+      csvside_seterr(idx->errmsg, sizeof(idx->errmsg), "%s",
+                     csv_errmsg(idx->cp));
+      return -1;
+    }
+    if (nb > 0 || eof) {
+      return nb;
+    }
+    if (fill(idx)) {
+      return -1;
+    }
+  }
+}
+
+int64_t csvidx_seek_row(csvidx_t *idx, int64_t rownum) {
+  const header_t *hdr = &idx->hdr;
+  if (rownum < 1 || rownum > hdr->nrow + 1) {
+    csvside_seterr(idx->errmsg, sizeof(idx->errmsg),
+                   "row %" PRId64 " is out of range", rownum);
+    return -1;
+  }
+  if (rownum == hdr->nrow + 1) {
+    set_cursor(idx, hdr->id.fsize, rownum);
+    return hdr->id.fsize;
+  }
+
+  /* go from the cursor if it is between the index entry and rownum */
+  const int64_t k = (rownum - 1) / hdr->stride;
+  const int64_t first = k * hdr->stride + 1;
+  if (!(first <= idx->currow && idx->currow <= rownum)) {
+    set_cursor(idx, idx->off[k], first);
+  }
+  while (idx->currow < rownum) {
+    int nb = next_row(idx);
+    if (nb <= 0) {
+      if (nb == 0) {
+        csvside_seterr(idx->errmsg, sizeof(idx->errmsg), "file was truncated");
+      }
+      idx->currow = 0;
+      return -1;
+    }
+    idx->pos += nb;
+    idx->currow++;
+  }
+  return idx->bufoff + idx->pos;
+}
+
+int64_t csvidx_read_rows(csvidx_t *idx, int64_t start, int64_t count,
+                         intptr_t handle,
+                         int (*on_row)(intptr_t handle, int64_t rownum,
+                                       char **field, int nfield)) {
+  if (csvidx_seek_row(idx, start) < 0) {
+    return -1;
+  }
+
+  int64_t n;
+  for (n = 0; n < count && idx->currow <= idx->hdr.nrow; n++) {
+    int nb = next_row(idx);
+    if (nb <= 0) {
+      if (nb == 0) {
+        csvside_seterr(idx->errmsg, sizeof(idx->errmsg), "file was truncated");
+      }
+      idx->currow = 0;
+      return -1;
+    }
+    char **field;
+    int nfield;
+    csv_touchup(idx->cp, &field, &nfield);
+    idx->pos += nb;
+    if (on_row((intptr_t)handle, idx->currow++, field, nfield)) {
+      csvside_seterr(idx->errmsg, sizeof(idx->errmsg), "on_row failed");
+      return -1;
+    }
+  }
+  return n;
+}
+
+const char *csvidx_errmsg(csvidx_t *idx) { return idx->errmsg; }
@@ -0,0 +1,118 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#ifndef CSVIDX_H
+#define CSVIDX_H
+
+/*
+
+  A sparse row index for csv files. The index holds the byte offset of
+  every Nth row, so a reader can start at any row, or split the file
+  into parts at row boundaries, without scanning from the beginning;
+  a plain search for a newline would land inside quoted fields.
+
+  The index is built with csv_line(), which finds row boundaries
+  without looking at fields, and is saved in a small sidecar file
+  FILE.csvidx:
+
+      header             : identity of FILE, dialect, N, num rows
+      varint[nentry]     : offset of row 1, then the distance in bytes
+                           from each indexed row to the next
+
+  The sidecar is used only if the size, mtime, inode and device of
+  FILE, and the quote, escape and delim it was built with, are
+  unchanged. Otherwise it is rebuilt.
+
+  Rows are numbered from 1 as in csv_scan(); entry k is the offset of
+  row k * N + 1. To get to row R, csvidx_seek_row() starts at the entry
+  before R and parses forward at most N - 1 rows with csv_line(),
+  reading the file with pread(). A read that starts where the previous
+  one stopped carries on from there, so paging forward through a file
+  does not go back to the index.
+
+  General usage:
+
+     csvidx_open()
+         csvidx_read_rows() / csvidx_seek_row() / csvidx_offset()
+         ...
+     csvidx_close()
+
+*/
+
+#include "csv.h"
+
+#define CSVIDX_STRIDE 1024 /* default N */
+
+typedef struct csvidx_t csvidx_t;
+
+/**
+ * Open the index of the csv file at path. If there is no valid sidecar,
+ * the file is scanned and the sidecar is saved next to it; if the
+ * sidecar cannot be saved, the index is kept in memory only.
+ *
+ * The index has an entry every stride rows. If stride is 0, a sidecar
+ * of any stride is accepted, and CSVIDX_STRIDE is used to build a new
+ * one. Params qte, esc, delim and nullstr are as in csv_open(); the
+ * nullstr only matters to csvidx_read_rows(). Returns NULL on error,
+ * with a message in errbuf[0..errbufsz).
+ */
+CSV_EXTERN csvidx_t *csvidx_open(const char *path, int qte, int esc,
+                                 int delim, const char nullstr[20],
+                                 int64_t stride, char *errbuf, int errbufsz);
+
+/**
+ * Release the index.
+ */
+CSV_EXTERN void csvidx_close(csvidx_t *idx);
+
+/**
+ * Check if the sidecar was loaded rather than built by csvidx_open().
+ */
+CSV_EXTERN int csvidx_hit(csvidx_t *idx);
+
+/**
+ * Get the num rows in the csv file, its size in bytes, the stride of
+ * the index, and the num entries in it.
+ */
+CSV_EXTERN int64_t csvidx_nrow(csvidx_t *idx);
+CSV_EXTERN int64_t csvidx_fsize(csvidx_t *idx);
+CSV_EXTERN int64_t csvidx_stride(csvidx_t *idx);
+CSV_EXTERN int64_t csvidx_nentry(csvidx_t *idx);
+
+/**
+ * Get the offset of row k * stride + 1, for k in [0, nentry).
+ */
+CSV_EXTERN int64_t csvidx_offset(csvidx_t *idx, int64_t k);
+
+/**
+ * Get the offset of row rownum, or the file size if rownum is one past
+ * the last row. Returns -1 on error; see csvidx_errmsg().
+ */
+CSV_EXTERN int64_t csvidx_seek_row(csvidx_t *idx, int64_t rownum);
+
+/**
+ * Call on_row for rows start to start + count - 1, or to the last row,
+ * like csv_scan() does. Returns the num rows read, or -1 if on_row
+ * failed or on error; see csvidx_errmsg().
+ */
+CSV_EXTERN int64_t csvidx_read_rows(
+    csvidx_t *idx, int64_t start, int64_t count, intptr_t handle,
+    int (*on_row)(intptr_t handle, int64_t rownum, char **field,
+                  int nfield));
+
+/**
+ * Get a message for the last error of csvidx_seek_row() or
+ * csvidx_read_rows().
+ */
+CSV_EXTERN const char *csvidx_errmsg(csvidx_t *idx);
+
+#endif /*CSVIDX_H*/
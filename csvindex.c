@@ -0,0 +1,200 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-l] [-p parts] [-r rows] [-d delim] [-q quote] [-e esc]\n\
+            FILE\n\
+                        \n\
+                        \n\
+  Build the sparse row index FILE.csvidx of a csv file if it is missing\n\
+  or out of date, and print a summary of it. The index holds the offset\n\
+  of every Nth row; see csvidx.h.\n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -l         : list the row number and offset of each entry           \n\
+      -p parts   : split the file into parts of about equal size at      \n\
+                   indexed rows, and print the first row, offset and      \n\
+                   size of each part                                      \n\
+      -r rows    : index every Nth row; default to 1024                   \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csvidx.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+const char *pname = 0;
+const char *fname = 0;
+int qte = '"';
+int esc = 0;
+int delim = ',';
+int64_t stride = 0;
+int list = 0;
+int64_t nparts = 0;
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d;
+  q = e = d = 0;
+  while ((opt = getopt(argc, argv, "d:q:e:r:p:lh")) != -1) {
+    switch (opt) {
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'r':
+      stride = strtoll(optarg, 0, 10);
+      if (stride <= 0) {
+        usage(1, "Error: -r rows expects a positive number.");
+      }
+      break;
+    case 'p':
+      nparts = strtoll(optarg, 0, 10);
+      if (nparts <= 0) {
+        usage(1, "Error: -p parts expects a positive number.");
+      }
+      break;
+    case 'l':
+      list = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* fname */
+  if (optind + 1 == argc)
+    fname = argv[optind];
+  else
+    usage(1, "Error: please supply one filename");
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+}
+
+/* find the first entry at or after offset off */
+static int64_t find_entry(csvidx_t *idx, int64_t off) {
+  int64_t lo = 0, hi = csvidx_nentry(idx);
+  while (lo < hi) {
+    int64_t mid = lo + (hi - lo) / 2;
+    if (csvidx_offset(idx, mid) < off) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/* print parts of about fsize / nparts bytes that start at indexed rows */
+static void print_parts(csvidx_t *idx) {
+  const int64_t fsize = csvidx_fsize(idx);
+  const int64_t nentry = csvidx_nentry(idx);
+  int64_t k = 0;
+  for (int64_t i = 0; i < nparts && k < nentry; i++) {
+    int64_t next = find_entry(idx, fsize / nparts * (i + 1));
+    next = next > k ? next : k + 1;
+    next = i + 1 < nparts ? next : nentry;
+    const int64_t start = csvidx_offset(idx, k);
+    const int64_t end = next < nentry ? csvidx_offset(idx, next) : fsize;
+    pout("part %" PRId64 ": row %" PRId64 " offset %" PRId64 " size %" PRId64
+         "\n",
+         i + 1, k * csvidx_stride(idx) + 1, start, end - start);
+    k = next;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+
+  char errbuf[200];
+  csvidx_t *idx =
+      csvidx_open(fname, qte, esc, delim, 0, stride, errbuf, sizeof(errbuf));
+  if (!idx) {
+    fatal("ERROR: %s\n", errbuf);
+  }
+
+  pout("%s: %" PRId64 " rows, %" PRId64 " bytes, every %" PRId64
+       " rows, %" PRId64 " entries (%s)\n",
+       fname, csvidx_nrow(idx), csvidx_fsize(idx), csvidx_stride(idx),
+       csvidx_nentry(idx), csvidx_hit(idx) ? "loaded" : "built");
+
+  if (list) {
+    for (int64_t k = 0; k < csvidx_nentry(idx); k++) {
+      pout("%" PRId64 " %" PRId64 "\n", k * csvidx_stride(idx) + 1,
+           csvidx_offset(idx, k));
+    }
+  }
+  if (nparts) {
+    print_parts(idx);
+  }
+
+  csvidx_close(idx);
+  return 0;
+}
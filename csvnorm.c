@@ -12,7 +12,9 @@
 */
 #define _GNU_SOURCE
 #include "csv.h"
+#include "csvwr.h"
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -25,6 +27,10 @@ int qte = '"';
 int esc = '"';
 int delim = ',';
 char nullstr[20] = {0};
+int njob = 1;
+
+/* each job normalizes a chunk of about this many bytes at a time */
+#define CHUNKSZ (8 * 1024 * 1024)
 
 #define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
 #define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
@@ -41,7 +47,8 @@ void usage(int exitcode, const char *msg) {
   perr("  - escape quote inside quoted columns\n");
   perr("  - NULL for null\n");
   perr("\n");
-  perr("Usage: %s [-h] [-d delim] [-q quote] [-e esc] [-n nullstr] [FILE]\n",
+  perr("Usage: %s [-h] [-d delim] [-q quote] [-e esc] [-n nullstr] [-j N] "
+       "[FILE]\n",
        pname);
   perr("%s", "\n\
   OPTIONS:              \n\
@@ -50,6 +57,7 @@ void usage(int exitcode, const char *msg) {
       -q quote   : specify quote char; default to double-quote           \n\
       -e esc     : specify escape char; default to the quote char        \n\
       -n nullstr : specify string representing null;                     \n\
+      -j N       : normalize using N threads; default to 1               \n\
       \n\
     ");
   if (msg) {
@@ -61,9 +69,9 @@ void usage(int exitcode, const char *msg) {
 void parse_cmdline(int argc, char *const *argv) {
   pname = argv[0];
   int opt;
-  char *q, *e, *d, *n;
-  q = e = d = n = 0;
-  while ((opt = getopt(argc, argv, "d:q:e:n:h")) != -1) {
+  char *q, *e, *d, *n, *j;
+  q = e = d = n = j = 0;
+  while ((opt = getopt(argc, argv, "d:q:e:n:j:h")) != -1) {
     switch (opt) {
     case 'd':
       d = optarg;
@@ -77,6 +85,9 @@ void parse_cmdline(int argc, char *const *argv) {
     case 'n':
       n = optarg;
       break;
+    case 'j':
+      j = optarg;
+      break;
     case 'h':
       usage(0, 0);
       break;
@@ -125,52 +136,218 @@ void parse_cmdline(int argc, char *const *argv) {
     }
     strcpy(nullstr, n);
   }
-}
 
-void print_special(char *s) {
-  putchar('"');
-  for (; *s; s++) {
-    if (*s == '"') {
-      putchar('"');
+  /* njob */
+  if (j) {
+    njob = atoi(j);
+    if (njob < 1 || njob > 256) {
+      usage(1, "Error: -j N expects a number between 1 and 256.");
     }
-    putchar(*s);
   }
-  putchar('"');
 }
 
-int do_read(intptr_t handle, char *buf, int bufsz) {
-  FILE *fp = (FILE *)handle;
-  return fread(buf, 1, bufsz, fp);
+/*
+ * The input is cut into chunks at row boundaries. Each chunk is
+ * normalized into its own output buffer, possibly by its own thread,
+ * and the output buffers are written out in input order.
+ */
+typedef struct chunk_t chunk_t;
+struct chunk_t {
+  char *buf;          /* buf[] - complete rows to normalize */
+  int len;            /* num used bytes in buf[] */
+  int max;            /* num allocated bytes in buf[] */
+  int last;           /* set if buf[] holds the end of input */
+  csv_parse_t *cp;    /* parser for buf[] */
+  csvwr_t out;        /* normalized output of buf[] */
+  const char *errmsg; /* set if normalize() failed */
+  pthread_t thread;
+};
+
+/*
+ * Set if rows in the input may already be in normalized form and can
+ * be copied to output as is. That needs comma delim and dquote quote.
+ */
+int passthru = 0;
+
+/* incomplete row at the end of a chunk, carried over to the next chunk */
+struct {
+  char *buf;
+  int len;
+  int max;
+} carry = {0};
+
+static void print_special(csvwr_t *out, const char *s) {
+  csvwr_putc(out, '"');
+  for (const char *p; (p = strchr(s, '"')); s = p + 1) {
+    csvwr_write(out, s, p + 1 - s);
+    csvwr_putc(out, '"');
+  }
+  csvwr_puts(out, s);
+  csvwr_putc(out, '"');
 }
 
-int do_row(intptr_t handle, int64_t rownum, char **col, int ncol) {
-  (void)handle;
-  (void)rownum;
+static void print_row(csvwr_t *out, char **col, int ncol) {
   for (int i = 0; i < ncol; i++) {
     char *s = col[i];
-    printf("%s", i ? "," : "");
+    if (i) {
+      csvwr_putc(out, ',');
+    }
     if (s) {
       /* search for dquote, comma, newline, or empty string */
       if (strpbrk(s, "\",\r\n") || *s == 0) {
-        print_special(s);
+        print_special(out, s);
       } else {
-        printf("%s", s);
+        csvwr_puts(out, s);
       }
     } else {
-      printf("NULL");
+      csvwr_write(out, "NULL", 4);
+    }
+  }
+
+  csvwr_write(out, "\r\n", 2);
+}
+
+/* check if the row parsed by csv_line() is already in normalized form */
+static int is_normal(csv_parse_t *cp, const char *row, int rowsz) {
+  char **fld;
+  int *len;
+  char *quoted;
+  const int nullstrsz = strlen(nullstr);
+  const int n = csv_rawfields(cp, &fld, &len, &quoted);
+  for (int i = 0; i < n; i++) {
+    /* quoted, empty and null fields all need rewriting */
+    if (quoted[i] || len[i] == 0) {
+      return 0;
+    }
+    if (len[i] == nullstrsz && 0 == memcmp(fld[i], nullstr, nullstrsz)) {
+      return 0;
     }
   }
 
-  printf("\r\n");
+  /* a CR inside a field must be quoted */
+  const char *cr = memchr(row, '\r', rowsz);
+  return !cr || cr == row + rowsz - 2;
+}
+
+/* normalize the rows in ck->buf[] into ck->out */
+static void *normalize(void *arg) {
+  chunk_t *ck = arg;
+  char *p = ck->buf;
+  char *const q = ck->buf + ck->len;
+  char **field;
+  int nfield;
+  int nb;
+
+  while (p < q) {
+    nb = csv_line(ck->cp, p, q - p);
+    if (nb <= 0) {
+      if (nb < 0) {
+        ck->errmsg = csv_errmsg(ck->cp);
+        return 0;
+      }
+      break;
+    }
+    if (passthru && is_normal(ck->cp, p, nb)) {
+      /* copy the raw row, and end it with CRLF */
+      int crlf = (nb >= 2 && p[nb - 2] == '\r');
+      csvwr_write(&ck->out, p, crlf ? nb : nb - 1);
+      if (!crlf) {
+        csvwr_write(&ck->out, "\r\n", 2);
+      }
+    } else {
+      csv_touchup(ck->cp, &field, &nfield);
+      print_row(&ck->out, field, nfield);
+    }
+    p += nb;
+  }
+
+  // one last row might remain in buf[]
+  if (p < q && ck->last) {
+    nb = csv_feed_last(ck->cp, p, q - p, &field, &nfield);
+    if (nb < 0) {
+      ck->errmsg = csv_errmsg(ck->cp);
+      return 0;
+    }
+    print_row(&ck->out, field, nfield);
+    p += nb;
+  }
+
+  if (p != q) {
+    ck->errmsg = "extra data after last row";
+  } else if (ck->out.err) {
+    ck->errmsg = "out of memory";
+  }
   return 0;
 }
 
-void do_error(intptr_t handle, int errtype, const char *errmsg,
-              csv_parse_t *cp) {
-  (void)handle;
-  (void)errtype;
-  errmsg = cp ? csv_errmsg(cp) : errmsg;
-  fatal("ERROR: %s\n", errmsg);
+/* make room for n bytes in buf[] of size *max */
+static char *expand(char *buf, int *max, int n) {
+  if (n <= *max) {
+    return buf;
+  }
+  if (!(buf = realloc(buf, n))) {
+    fatal("ERROR: out of memory\n");
+  }
+  *max = n;
+  return buf;
+}
+
+/*
+ * Fill ck->buf[] with the carried over row and more input, and cut it
+ * at the last complete row. sp is only used to locate row boundaries.
+ * Return 1 on eof, 0 otherwise.
+ */
+static int fill(chunk_t *ck, FILE *fp, csv_parse_t *sp) {
+  ck->buf = expand(ck->buf, &ck->max, CHUNKSZ);
+  if (carry.len >= ck->max) {
+    ck->buf = expand(ck->buf, &ck->max, carry.len * 2);
+  }
+  memcpy(ck->buf, carry.buf, carry.len);
+  ck->len = carry.len;
+  ck->last = 0;
+  carry.len = 0;
+
+  /* rows in buf[0 .. off) are complete */
+  int off = 0;
+  for (;;) {
+    int nb = fread(ck->buf + ck->len, 1, ck->max - ck->len, fp);
+    if (nb == 0 && ferror(fp)) {
+      fatal("ERROR: fread - %s\n", strerror(errno));
+    }
+    ck->len += nb;
+
+    while (off < ck->len) {
+      int n = csv_line(sp, ck->buf + off, ck->len - off);
+      if (n < 0) {
+        fatal("ERROR: %s\n", csv_errmsg(sp));
+      }
+      if (n == 0) {
+        break;
+      }
+      off += n;
+    }
+
+    if (nb == 0) {
+      /* the incomplete row, if any, is the last row */
+      ck->last = 1;
+      return 1;
+    }
+
+    if (ck->len == ck->max) {
+      if (off > 0) {
+        break;
+      }
+      /* a single row spans the whole chunk */
+      ck->buf = expand(ck->buf, &ck->max, ck->max * 2);
+    }
+  }
+
+  /* carry the incomplete row over to the next chunk */
+  carry.buf = expand(carry.buf, &carry.max, ck->len - off);
+  carry.len = ck->len - off;
+  memcpy(carry.buf, ck->buf + off, carry.len);
+  ck->len = off;
+  return 0;
 }
 
 int main(int argc, char *argv[]) {
@@ -183,8 +360,59 @@ int main(int argc, char *argv[]) {
     }
   }
 
-  csv_scan((intptr_t)fp, qte, esc, delim, nullstr, do_read, do_row, do_error);
+  passthru = (delim == ',' && qte == '"');
+
+  csv_parse_t *sp = csv_open(qte, esc, delim, nullstr);
+  chunk_t *chunk = calloc(njob, sizeof(*chunk));
+  if (!sp || !chunk) {
+    fatal("ERROR: out of memory\n");
+  }
+  for (int i = 0; i < njob; i++) {
+    chunk[i].cp = csv_open(qte, esc, delim, nullstr);
+    if (!chunk[i].cp || csvwr_init(&chunk[i].out, -1, 0)) {
+      fatal("ERROR: out of memory\n");
+    }
+  }
+
+  int eof = 0;
+  while (!eof) {
+    /* start a job on each chunk as soon as it is filled */
+    int n = 0;
+    while (n < njob && !eof) {
+      chunk_t *ck = &chunk[n++];
+      eof = fill(ck, fp, sp);
+      if (njob == 1) {
+        normalize(ck);
+      } else if (pthread_create(&ck->thread, 0, normalize, ck)) {
+        fatal("ERROR: pthread_create failed\n");
+      }
+    }
+
+    /* write out the chunks in input order */
+    for (int i = 0; i < n; i++) {
+      chunk_t *ck = &chunk[i];
+      if (njob > 1) {
+        pthread_join(ck->thread, 0);
+      }
+      if (ck->errmsg) {
+        fatal("ERROR: %s\n", ck->errmsg);
+      }
+      if (ck->out.top &&
+          1 != fwrite(ck->out.buf, ck->out.top, 1, stdout)) {
+        fatal("ERROR: cannot write to stdout\n");
+      }
+      csvwr_reset(&ck->out);
+    }
+  }
 
+  for (int i = 0; i < njob; i++) {
+    csv_close(chunk[i].cp);
+    csvwr_fini(&chunk[i].out);
+    free(chunk[i].buf);
+  }
+  free(chunk);
+  free(carry.buf);
+  csv_close(sp);
   fclose(fp);
 
   return 0;
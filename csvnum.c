@@ -0,0 +1,183 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#include "csvnum.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define likely(x) __builtin_expect((x), 1)
+#define unlikely(x) __builtin_expect((x), 0)
+
+/* powers of 10 that are exact in a double */
+static const double pow10tab[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+int csvnum_int64(const char *s, int len, int64_t *ret) {
+  const char *p = s;
+  const char *const q = s + len;
+  int neg = 0;
+
+  if (p < q && (*p == '-' || *p == '+')) {
+    neg = (*p++ == '-');
+  }
+  if (unlikely(p == q)) {
+    return -1;
+  }
+
+  /* accumulate as a negative number to reach INT64_MIN */
+  int64_t v = 0;
+  for (; p < q; p++) {
+    int d = *p - '0';
+    if (unlikely((unsigned)d > 9)) {
+      return -1;
+    }
+    if (unlikely(v < (INT64_MIN + d) / 10)) {
+      return -1; /* overflow */
+    }
+    v = v * 10 - d;
+  }
+
+  if (!neg) {
+    if (unlikely(v == INT64_MIN)) {
+      return -1; /* overflow */
+    }
+    v = -v;
+  }
+  *ret = v;
+  return 0;
+}
+
+int csvnum_double(const char *s, int len, double *ret) {
+  const char *p = s;
+  const char *const q = s + len;
+  int neg = 0;
+
+  if (p < q && (*p == '-' || *p == '+')) {
+    neg = (*p++ == '-');
+  }
+
+  /* mantissa: at most 19 digits are accumulated in m */
+  uint64_t m = 0;
+  int ndigit = 0; /* num significant digits seen */
+  int nskip = 0;  /* num integer digits not accumulated */
+  int nfrac = 0;  /* num fraction digits accumulated */
+  int seen = 0;   /* num digits seen, including leading zeroes */
+
+  for (; p < q && (unsigned)(*p - '0') <= 9; p++, seen++) {
+    if (m == 0 && *p == '0') {
+      continue;
+    }
+    if (ndigit < 19) {
+      m = m * 10 + (*p - '0');
+    } else {
+      nskip++;
+    }
+    ndigit++;
+  }
+  if (p < q && *p == '.') {
+    for (p++; p < q && (unsigned)(*p - '0') <= 9; p++, seen++) {
+      if (m == 0 && *p == '0') {
+        nfrac++;
+        continue;
+      }
+      if (ndigit < 19) {
+        m = m * 10 + (*p - '0');
+        nfrac++;
+      }
+      ndigit++;
+    }
+  }
+  if (unlikely(seen == 0)) {
+    return -1;
+  }
+
+  /* exponent */
+  int e = 0;
+  if (p < q && (*p == 'e' || *p == 'E')) {
+    int eneg = 0;
+    p++;
+    if (p < q && (*p == '-' || *p == '+')) {
+      eneg = (*p++ == '-');
+    }
+    if (p == q) {
+      return -1;
+    }
+    for (; p < q && (unsigned)(*p - '0') <= 9; p++) {
+      e = e < 100000 ? e * 10 + (*p - '0') : e;
+    }
+    e = eneg ? -e : e;
+  }
+  if (unlikely(p != q)) {
+    return -1;
+  }
+
+  /* fast path: m and 10^e are both exact in a double */
+  e += nskip - nfrac;
+  if (likely(ndigit <= 15 && -22 <= e && e <= 22)) {
+    double d = (double)m;
+    d = e < 0 ? d / pow10tab[-e] : d * pow10tab[e];
+    *ret = neg ? -d : d;
+    return 0;
+  }
+
+  /* slow path: let strtod() do the rounding */
+  char tmp[64];
+  char *buf = len < (int)sizeof(tmp) ? tmp : malloc(len + 1);
+  if (!buf) {
+    return -1;
+  }
+  memcpy(buf, s, len);
+  buf[len] = 0;
+  *ret = strtod(buf, 0);
+  if (buf != tmp) {
+    free(buf);
+  }
+  return 0;
+}
+
+/* parse n digits at s */
+static inline int digits(const char *s, int n, int *ret) {
+  int v = 0;
+  for (int i = 0; i < n; i++) {
+    int d = s[i] - '0';
+    if ((unsigned)d > 9) {
+      return -1;
+    }
+    v = v * 10 + d;
+  }
+  *ret = v;
+  return 0;
+}
+
+int csvnum_date(const char *s, int len, int32_t *ret) {
+  int y, m, d;
+  if (len != 10 || s[4] != '-' || s[7] != '-' || digits(s, 4, &y) ||
+      digits(s + 5, 2, &m) || digits(s + 8, 2, &d)) {
+    return -1;
+  }
+
+  static const int mdays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  int leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+  if (m < 1 || m > 12 || d < 1 || d > mdays[m - 1] + (m == 2 && leap)) {
+    return -1;
+  }
+
+  /* days from civil; see http://howardhinnant.github.io/date_algorithms.html */
+  y -= m <= 2;
+  const int era = (y >= 0 ? y : y - 399) / 400; /* floor, for 0000-0x-xx */
+  const int yoe = y - era * 400;
+  const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  *ret = era * 146097 + doe - 719468;
+  return 0;
+}
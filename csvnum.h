@@ -0,0 +1,47 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#ifndef CSVNUM_H
+#define CSVNUM_H
+
+/*
+
+  Fast converters from field values to numbers. The value s[0..len)
+  need not be NUL terminated, and must not have leading or trailing
+  spaces.
+
+  Each converter returns 0 on success, or -1 if s[0..len) is not a
+  valid number of the requested type.
+
+*/
+
+#include "csv.h"
+
+/**
+ * Convert [+-]digits to an int64. Fails on overflow.
+ */
+CSV_EXTERN int csvnum_int64(const char *s, int len, int64_t *ret);
+
+/**
+ * Convert [+-]digits[.digits][e[+-]digits] to a double. Values with up
+ * to 15 significant digits and a small exponent are converted exactly
+ * without calling strtod().
+ */
+CSV_EXTERN int csvnum_double(const char *s, int len, double *ret);
+
+/**
+ * Convert YYYY-MM-DD, from 0000-01-01 on, to the number of days since
+ * 1970-01-01, in the proleptic Gregorian calendar.
+ */
+CSV_EXTERN int csvnum_date(const char *s, int len, int32_t *ret);
+
+#endif /*CSVNUM_H*/
@@ -0,0 +1,103 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#define _GNU_SOURCE
+#include "csvrd.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int csvrd_init(csvrd_t *rd, int fd, int bufsz) {
+  bufsz = bufsz > 0 ? bufsz : 1024 * 1024;
+  memset(rd, 0, sizeof(*rd));
+  if (!(rd->buf = malloc(bufsz))) {
+    return -1;
+  }
+  rd->max = bufsz;
+  rd->fd = fd;
+  return 0;
+}
+
+void csvrd_fini(csvrd_t *rd) {
+  free(rd->buf);
+  rd->buf = 0;
+  rd->max = rd->p = rd->q = 0;
+}
+
+/* move the unread rows to the front of buf[] and read more. buf[] is
+ * expanded if it is full. Leaves room for one more byte. */
+static int fill(csvrd_t *rd) {
+  if (rd->p) {
+    memmove(rd->buf, rd->buf + rd->p, rd->q - rd->p);
+    rd->off += rd->p;
+    rd->q -= rd->p;
+    rd->p = 0;
+  }
+  if (rd->q >= rd->max - 1) {
+    char *xp = rd->max <= INT32_MAX / 2 ? realloc(rd->buf, rd->max * 2) : 0;
+    if (!xp) {
+      snprintf(rd->errmsg, sizeof(rd->errmsg), "out of memory");
+      return -1;
+    }
+    rd->buf = xp;
+    rd->max *= 2;
+  }
+
+  for (;;) {
+    int nb = read(rd->fd, rd->buf + rd->q, rd->max - 1 - rd->q);
+    if (nb < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      snprintf(rd->errmsg, sizeof(rd->errmsg), "read - %s", strerror(errno));
+      return -1;
+    }
+    rd->q += nb;
+    if (nb == 0) {
+      rd->eof = 1;
+      /* terminate a last row that has no newline */
+      if (rd->q > 0 && rd->buf[rd->q - 1] != '\n') {
+        rd->buf[rd->q++] = '\n';
+      }
+    }
+    return 0;
+  }
+}
+
+int csvrd_line(csvrd_t *rd, csv_parse_t *cp, char **row) {
+  for (;;) {
+    if (rd->p < rd->q) {
+      int nb = csv_line(cp, rd->buf + rd->p, rd->q - rd->p);
+      if (nb < 0) {
+        snprintf(rd->errmsg, sizeof(rd->errmsg), "%s", csv_errmsg(cp));
+        return -1;
+      }
+      if (nb > 0) {
+        *row = rd->buf + rd->p;
+        rd->p += nb;
+        return nb;
+      }
+    }
+    if (rd->eof) {
+      if (rd->p < rd->q) {
+        snprintf(rd->errmsg, sizeof(rd->errmsg), "extra data after last row");
+        return -1;
+      }
+      return 0;
+    }
+    if (fill(rd)) {
+      return -1;
+    }
+  }
+}
@@ -0,0 +1,67 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#ifndef CSVRD_H
+#define CSVRD_H
+
+/*
+
+  A buffered row reader for the csv tools. Bytes are read from fd into
+  buf[], and the complete rows in it are handed out one at a time, as
+  found by csv_line(), so the caller can look at the fields with
+  csv_rawfields() or csv_touchup(). buf[] grows to hold a row of any
+  size, and a last row without a newline is given one.
+
+  The rows not yet handed out are in buf[p..q). A row stays put until
+  the next call to csvrd_line(), which may move buf[].
+
+  General usage:
+
+     csvrd_init()
+         csvrd_line()
+         ...
+     csvrd_fini()
+
+*/
+
+#include "csv.h"
+
+typedef struct csvrd_t csvrd_t;
+struct csvrd_t {
+  char *buf;        /* buf[] - input buffer */
+  int max;          /* num allocated bytes in buf[] */
+  int p, q;         /* unread rows are in buf[p..q) */
+  int64_t off;      /* offset of buf[0] in the input */
+  int fd;           /* input file descriptor */
+  int eof;          /* read() returned 0 */
+  char errmsg[200]; /* message of the last error */
+};
+
+/**
+ * Initialize a reader. Returns 0 on success, -1 on out-of-memory error.
+ * For bufsz that is 0, it assumes a default of 1MB.
+ */
+CSV_EXTERN int csvrd_init(csvrd_t *rd, int fd, int bufsz);
+
+/**
+ * Release the reader. The fd is not closed.
+ */
+CSV_EXTERN void csvrd_fini(csvrd_t *rd);
+
+/**
+ * Parse the next row with cp. Returns the #bytes in the row, whose
+ * start is returned in row, 0 at the end of the input, or -1 on error,
+ * with a message in errmsg[].
+ */
+CSV_EXTERN int csvrd_line(csvrd_t *rd, csv_parse_t *cp, char **row);
+
+#endif /*CSVRD_H*/
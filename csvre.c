@@ -0,0 +1,829 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#include "csvre.h"
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXINST 20000     /* max instructions in the program */
+#define MAXREP 1000       /* max m and n in x{m,n} */
+#define MAXLIT 64         /* max length of the literal */
+#define CACHESZ (1 << 21) /* bytes of transitions kept in the DFA cache */
+
+/* a set of bytes */
+typedef struct byteset_t byteset_t;
+struct byteset_t {
+  uint32_t w[8];
+};
+
+#define HAS(s, c) ((s)->w[(c) >> 5] >> ((c)&31) & 1)
+#define ADD(s, c) ((s)->w[(c) >> 5] |= 1u << ((c)&31))
+
+/* a node of the parse tree */
+enum { N_SET, N_EMPTY, N_CAT, N_ALT, N_REP, N_BOL, N_EOL };
+typedef struct node_t node_t;
+struct node_t {
+  int type;
+  int a, b;     /* children of N_CAT and N_ALT; a is the child of N_REP */
+  int min, max; /* of N_REP; max is -1 for no limit */
+  int set;      /* of N_SET, an index into set[] */
+};
+
+/* an instruction of the NFA program. Each one but I_JMP and I_SPLIT
+ * goes on to the next. */
+enum { I_SET, I_SPLIT, I_JMP, I_BOL, I_EOL, I_MATCH };
+typedef struct inst_t inst_t;
+struct inst_t {
+  int op;
+  int x, y; /* I_SET: set index in x; I_JMP: target x; I_SPLIT: x and y */
+};
+
+/* a DFA state: the sorted pcs pool[off..off+n) of the I_SET, I_EOL and
+ * I_MATCH instructions the NFA may be at */
+typedef struct dstate_t dstate_t;
+struct dstate_t {
+  int off, n;
+  int flag;
+};
+
+#define F_MATCH 1 /* a match ends here */
+#define F_ATEND 2 /* a match ends here if it is the end of the value */
+#define F_DEAD 4  /* no match can follow */
+
+struct csvre_t {
+  /* parser */
+  const char *pat; /* the rest of the pattern */
+  const char *err;
+  node_t *node;
+  int nnode, maxnode;
+  byteset_t *set;
+  int nset, maxset;
+
+  /* program */
+  inst_t *inst;
+  int ninst, maxinst;
+
+  char lit[MAXLIT + 1];
+  int litsz;
+
+  /* bytes are mapped to classes of bytes that no set tells apart */
+  uint8_t cls[256];
+  int ncls;
+
+  /* DFA cache; trans[s * ncls + cls[c]] is the state after state s on
+   * byte c, or -1 if not computed yet */
+  dstate_t *st;
+  int nst, maxst;
+  int *trans;
+  int *pool;
+  int npool, maxpool;
+  int *hash; /* state + 1, or 0 for none */
+  int hashsz;
+  int start;
+  int empty; /* the empty value matches */
+
+  /* scratch for closures */
+  int *mark;
+  int gen;
+  int *stack;
+  int *pcs;
+};
+
+static void seterr(char *errbuf, int errbufsz, const char *fmt, ...) {
+  if (errbufsz > 0) {
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(errbuf, errbufsz, fmt, ap);
+    va_end(ap);
+  }
+}
+
+/* grow *ptr to hold at least n items of size sz */
+static int grow(void *ptr, int *max, int n, size_t sz) {
+  if (n <= *max) {
+    return 0;
+  }
+  int newmax = *max ? *max : 16;
+  while (newmax < n) {
+    newmax *= 2;
+  }
+  void *p = realloc(*(void **)ptr, newmax * sz);
+  if (!p) {
+    return -1;
+  }
+  *(void **)ptr = p;
+  *max = newmax;
+  return 0;
+}
+
+/* ---------------------------------------------------------------- */
+/* parser                                                           */
+
+static int new_node(csvre_t *re, int type, int a, int b) {
+  if (grow(&re->node, &re->maxnode, re->nnode + 1, sizeof(node_t))) {
+    re->err = "out of memory";
+    return -1;
+  }
+  re->node[re->nnode] = (node_t){type, a, b, 0, 0, -1};
+  return re->nnode++;
+}
+
+static int new_set(csvre_t *re, const byteset_t *s) {
+  int k = new_node(re, N_SET, -1, -1);
+  if (k < 0) {
+    return -1;
+  }
+  if (grow(&re->set, &re->maxset, re->nset + 1, sizeof(byteset_t))) {
+    re->err = "out of memory";
+    return -1;
+  }
+  re->set[re->nset] = *s;
+  re->node[k].set = re->nset++;
+  return k;
+}
+
+static void add_range(byteset_t *s, int lo, int hi) {
+  for (int c = lo; c <= hi; c++) {
+    ADD(s, c);
+  }
+}
+
+static void invert(byteset_t *s) {
+  for (int i = 0; i < 8; i++) {
+    s->w[i] = ~s->w[i];
+  }
+}
+
+/* if escape \c is a class, add it to s and return -1; else return the
+ * byte it stands for */
+static int add_escape(byteset_t *s, int c) {
+  byteset_t t = {{0}};
+  switch (c) {
+  case 'd':
+  case 'D':
+    add_range(&t, '0', '9');
+    break;
+  case 'w':
+  case 'W':
+    add_range(&t, '0', '9');
+    add_range(&t, 'A', 'Z');
+    add_range(&t, 'a', 'z');
+    ADD(&t, '_');
+    break;
+  case 's':
+  case 'S':
+    add_range(&t, '\t', '\r');
+    ADD(&t, ' ');
+    break;
+  case 'n':
+    return '\n';
+  case 't':
+    return '\t';
+  case 'r':
+    return '\r';
+  default:
+    return c;
+  }
+  if (c == 'D' || c == 'W' || c == 'S') {
+    invert(&t);
+  }
+  for (int i = 0; i < 8; i++) {
+    s->w[i] |= t.w[i];
+  }
+  return -1;
+}
+
+static int is_alnum(int c) {
+  return ('0' <= c && c <= '9') || ('A' <= c && c <= 'Z') ||
+         ('a' <= c && c <= 'z');
+}
+
+/* parse the escape after a backslash into s; returns -1 if it is a
+ * class, or else the byte */
+static int parse_escape(csvre_t *re, byteset_t *s) {
+  int c = (uint8_t)*re->pat++;
+  if (!c) {
+    re->err = "trailing backslash";
+    return -2;
+  }
+  if (is_alnum(c) && !strchr("dDwWsSntr", c)) {
+    re->err = "bad escape";
+    return -2;
+  }
+  return add_escape(s, c);
+}
+
+/* parse [...]; the [ has been read */
+static int parse_class(csvre_t *re) {
+  byteset_t s = {{0}};
+  int neg = 0;
+  if (*re->pat == '^') {
+    neg = 1;
+    re->pat++;
+  }
+  for (int first = 1; first || *re->pat != ']'; first = 0) {
+    int lo = (uint8_t)*re->pat++;
+    if (!lo) {
+      re->err = "missing ]";
+      return -1;
+    }
+    if (lo == '\\' && (lo = parse_escape(re, &s)) < 0) {
+      if (lo == -2) {
+        return -1;
+      }
+      continue;
+    }
+    int hi = lo;
+    if (re->pat[0] == '-' && re->pat[1] && re->pat[1] != ']') {
+      re->pat++;
+      hi = (uint8_t)*re->pat++;
+      if (hi == '\\') {
+        byteset_t t = {{0}};
+        if ((hi = parse_escape(re, &t)) < 0) {
+          re->err = re->err ? re->err : "bad range";
+          return -1;
+        }
+      }
+      if (hi < lo) {
+        re->err = "bad range";
+        return -1;
+      }
+    }
+    add_range(&s, lo, hi);
+  }
+  re->pat++;
+  if (neg) {
+    invert(&s);
+  }
+  return new_set(re, &s);
+}
+
+static int parse_alt(csvre_t *re);
+
+/* parse a number of a repeat; returns -1 if there is none */
+static int parse_count(csvre_t *re) {
+  int n = -1;
+  while ('0' <= *re->pat && *re->pat <= '9') {
+    n = (n < 0 ? 0 : n * 10) + (*re->pat++ - '0');
+    n = n > MAXREP ? MAXREP + 1 : n;
+  }
+  return n;
+}
+
+/* parse {m}, {m,} or {m,n} into min and max; the { has been read.
+ * Returns 0 if this is not a repeat, and the { is a literal. */
+static int parse_braces(csvre_t *re, int *min, int *max) {
+  const char *save = re->pat;
+  *min = parse_count(re);
+  *max = *min;
+  if (*re->pat == ',') {
+    re->pat++;
+    *max = parse_count(re);
+  }
+  if (*min < 0 || *re->pat != '}') {
+    re->pat = save;
+    return 0;
+  }
+  re->pat++;
+  if (*min > MAXREP || *max > MAXREP || (*max >= 0 && *max < *min)) {
+    re->err = "bad repeat";
+    return -1;
+  }
+  return 1;
+}
+
+/* parse an atom and its repeats */
+static int parse_rep(csvre_t *re) {
+  int k = -1;
+  byteset_t s = {{0}};
+  int c = (uint8_t)*re->pat++;
+  switch (c) {
+  case '(':
+    if (re->pat[0] == '?' && re->pat[1] == ':') {
+      re->pat += 2;
+    }
+    if ((k = parse_alt(re)) < 0) {
+      return -1;
+    }
+    if (*re->pat++ != ')') {
+      re->err = "missing )";
+      return -1;
+    }
+    break;
+  case '[':
+    k = parse_class(re);
+    break;
+  case '.':
+    add_range(&s, 0, 255);
+    s.w['\n' >> 5] &= ~(1u << ('\n' & 31));
+    k = new_set(re, &s);
+    break;
+  case '^':
+    k = new_node(re, N_BOL, -1, -1);
+    break;
+  case '$':
+    k = new_node(re, N_EOL, -1, -1);
+    break;
+  case '*':
+  case '+':
+  case '?':
+    re->err = "nothing to repeat";
+    return -1;
+  case '\\':
+    if ((c = parse_escape(re, &s)) == -2) {
+      return -1;
+    }
+    if (c >= 0) {
+      ADD(&s, c);
+    }
+    k = new_set(re, &s);
+    break;
+  default:
+    ADD(&s, c);
+    k = new_set(re, &s);
+    break;
+  }
+
+  for (;;) {
+    int min, max, r;
+    c = *re->pat;
+    if (c == '*' || c == '+' || c == '?') {
+      re->pat++;
+      min = c == '+';
+      max = c == '?' ? 1 : -1;
+    } else if (c == '{' && (re->pat++, r = parse_braces(re, &min, &max))) {
+      if (r < 0) {
+        return -1;
+      }
+    } else {
+      if (c == '{') {
+        re->pat--;
+      }
+      break;
+    }
+    if (*re->pat == '?') {
+      re->pat++; /* lazy; makes no difference to a yes or no match */
+    }
+    if (k < 0 || (k = new_node(re, N_REP, k, -1)) < 0) {
+      return -1;
+    }
+    re->node[k].min = min;
+    re->node[k].max = max;
+  }
+  return k;
+}
+
+/* parse a concatenation */
+static int parse_cat(csvre_t *re) {
+  int k = new_node(re, N_EMPTY, -1, -1);
+  while (k >= 0 && *re->pat && *re->pat != '|' && *re->pat != ')') {
+    int x = parse_rep(re);
+    k = x < 0 ? -1 : new_node(re, N_CAT, k, x);
+  }
+  return k;
+}
+
+static int parse_alt(csvre_t *re) {
+  int k = parse_cat(re);
+  while (k >= 0 && *re->pat == '|') {
+    re->pat++;
+    int x = parse_cat(re);
+    k = x < 0 ? -1 : new_node(re, N_ALT, k, x);
+  }
+  return k;
+}
+
+/* ---------------------------------------------------------------- */
+/* the literal                                                      */
+
+/* the byte of a set of one byte, or -1 */
+static int single(csvre_t *re, int k) {
+  if (re->node[k].type != N_SET) {
+    return -1;
+  }
+  const byteset_t *s = &re->set[re->node[k].set];
+  int c = -1;
+  for (int i = 0; i < 8; i++) {
+    if (s->w[i]) {
+      if (c >= 0 || (s->w[i] & (s->w[i] - 1))) {
+        return -1;
+      }
+      c = i * 32 + __builtin_ctz(s->w[i]);
+    }
+  }
+  return c;
+}
+
+/* keep the longer of run[0..runsz) and re->lit in re->lit */
+static void keep_literal(csvre_t *re, const char *run, int runsz) {
+  if (runsz > re->litsz) {
+    memcpy(re->lit, run, runsz);
+    re->litsz = runsz;
+  }
+}
+
+/* walk the concatenation under node k, keeping in run[0..*runsz) the
+ * literal bytes that the nodes so far require one after another */
+static void find_literal(csvre_t *re, int k, char *run, int *runsz) {
+  const node_t *n = &re->node[k];
+  int c;
+  switch (n->type) {
+  case N_CAT:
+    find_literal(re, n->a, run, runsz);
+    find_literal(re, n->b, run, runsz);
+    break;
+  case N_EMPTY:
+  case N_BOL:
+  case N_EOL:
+    break;
+  case N_SET:
+    if ((c = single(re, k)) >= 0 && *runsz < MAXLIT) {
+      run[(*runsz)++] = c;
+    }
+    if (c < 0) {
+      *runsz = 0;
+    }
+    break;
+  case N_REP:
+    /* x{m,n} requires m x's; the run goes on after it only if m == n */
+    if ((c = single(re, n->a)) >= 0) {
+      for (int i = 0; i < n->min && *runsz < MAXLIT; i++) {
+        run[(*runsz)++] = c;
+      }
+      keep_literal(re, run, *runsz);
+    }
+    if (c < 0 || n->min != n->max) {
+      *runsz = 0;
+    }
+    break;
+  default:
+    *runsz = 0;
+    break;
+  }
+  keep_literal(re, run, *runsz);
+}
+
+/* ---------------------------------------------------------------- */
+/* compiler                                                         */
+
+static int emit(csvre_t *re, int op, int x, int y) {
+  if (re->ninst >= MAXINST) {
+    re->err = "pattern too big";
+    return -1;
+  }
+  if (grow(&re->inst, &re->maxinst, re->ninst + 1, sizeof(inst_t))) {
+    re->err = "out of memory";
+    return -1;
+  }
+  re->inst[re->ninst] = (inst_t){op, x, y};
+  return re->ninst++;
+}
+
+static int compile(csvre_t *re, int k) {
+  const node_t n = re->node[k];
+  int pc, j;
+  switch (n.type) {
+  case N_SET:
+    return emit(re, I_SET, n.set, 0) < 0 ? -1 : 0;
+  case N_EMPTY:
+    return 0;
+  case N_BOL:
+    return emit(re, I_BOL, 0, 0) < 0 ? -1 : 0;
+  case N_EOL:
+    return emit(re, I_EOL, 0, 0) < 0 ? -1 : 0;
+  case N_CAT:
+    return compile(re, n.a) || compile(re, n.b) ? -1 : 0;
+  case N_ALT:
+    if ((pc = emit(re, I_SPLIT, 0, 0)) < 0) {
+      return -1;
+    }
+    re->inst[pc].x = re->ninst;
+    if (compile(re, n.a) || (j = emit(re, I_JMP, 0, 0)) < 0) {
+      return -1;
+    }
+    re->inst[pc].y = re->ninst;
+    if (compile(re, n.b)) {
+      return -1;
+    }
+    re->inst[j].x = re->ninst;
+    return 0;
+  case N_REP:
+    for (int i = 0; i < n.min; i++) {
+      if (compile(re, n.a)) {
+        return -1;
+      }
+    }
+    if (n.max < 0) {
+      /* L: split body, out; body; jmp L */
+      if ((pc = emit(re, I_SPLIT, 0, 0)) < 0) {
+        return -1;
+      }
+      re->inst[pc].x = re->ninst;
+      if (compile(re, n.a) || emit(re, I_JMP, pc, 0) < 0) {
+        return -1;
+      }
+      re->inst[pc].y = re->ninst;
+      return 0;
+    }
+    /* each optional copy may skip to the end; the splits are chained
+     * through y until the end is known */
+    j = -1;
+    for (int i = n.min; i < n.max; i++) {
+      if ((pc = emit(re, I_SPLIT, 0, j)) < 0) {
+        return -1;
+      }
+      re->inst[pc].x = re->ninst;
+      if (compile(re, n.a)) {
+        return -1;
+      }
+      j = pc;
+    }
+    while (j >= 0) {
+      pc = re->inst[j].y;
+      re->inst[j].y = re->ninst;
+      j = pc;
+    }
+    return 0;
+  }
+  return -1;
+}
+
+/* map the bytes to classes: two bytes are in one class if every set
+ * has both or neither */
+static void make_classes(csvre_t *re) {
+  memset(re->cls, 0, sizeof(re->cls));
+  re->ncls = 1;
+  for (int i = 0; i < re->nset && re->ncls < 256; i++) {
+    int map[256][2];
+    int n = 0;
+    memset(map, -1, sizeof(map));
+    for (int c = 0; c < 256; c++) {
+      int *p = &map[re->cls[c]][HAS(&re->set[i], c)];
+      if (*p < 0) {
+        *p = n++;
+      }
+      re->cls[c] = *p;
+    }
+    re->ncls = n;
+  }
+}
+
+/* ---------------------------------------------------------------- */
+/* DFA                                                              */
+
+/* add to pcs[0..*n) the instructions reachable from pc without reading
+ * a byte, given whether this is the start or the end of the value */
+static void closure(csvre_t *re, int pc, int bol, int eol, int *n) {
+  int top = 0;
+  re->stack[top++] = pc;
+  while (top) {
+    pc = re->stack[--top];
+    if (re->mark[pc] == re->gen) {
+      continue;
+    }
+    re->mark[pc] = re->gen;
+    const inst_t *ip = &re->inst[pc];
+    switch (ip->op) {
+    case I_SET:
+    case I_MATCH:
+      re->pcs[(*n)++] = pc;
+      break;
+    case I_BOL:
+      if (bol) {
+        re->stack[top++] = pc + 1;
+      }
+      break;
+    case I_EOL:
+      if (eol) {
+        re->stack[top++] = pc + 1;
+      } else {
+        re->pcs[(*n)++] = pc;
+      }
+      break;
+    case I_JMP:
+      re->stack[top++] = ip->x;
+      break;
+    case I_SPLIT:
+      re->stack[top++] = ip->y;
+      re->stack[top++] = ip->x;
+      break;
+    }
+  }
+}
+
+static int cmpint(const void *a, const void *b) {
+  return *(const int *)a - *(const int *)b;
+}
+
+static unsigned hashpcs(const int *pcs, int n) {
+  unsigned h = 2166136261u;
+  for (int i = 0; i < n; i++) {
+    h = (h ^ (unsigned)pcs[i]) * 16777619u;
+  }
+  return h;
+}
+
+/* drop all states */
+static void flush(csvre_t *re) {
+  re->nst = 0;
+  re->npool = 0;
+  memset(re->hash, 0, re->hashsz * sizeof(int));
+}
+
+/* find or add the state of pcs[0..n); returns it, or -1 if out of
+ * memory or the cache is full */
+static int add_state(csvre_t *re, int n) {
+  qsort(re->pcs, n, sizeof(int), cmpint);
+  unsigned h = hashpcs(re->pcs, n) & (re->hashsz - 1);
+  for (; re->hash[h]; h = (h + 1) & (re->hashsz - 1)) {
+    const dstate_t *d = &re->st[re->hash[h] - 1];
+    if (d->n == n && 0 == memcmp(re->pool + d->off, re->pcs, n * sizeof(int))) {
+      return re->hash[h] - 1;
+    }
+  }
+  if (re->nst == re->maxst ||
+      grow(&re->pool, &re->maxpool, re->npool + n, sizeof(int))) {
+    return -1;
+  }
+
+  /* flags; F_ATEND follows the I_EOL instructions */
+  int flag = n ? 0 : F_DEAD;
+  int m = n;
+  re->gen++;
+  for (int i = 0; i < n; i++) {
+    const int op = re->inst[re->pcs[i]].op;
+    if (op == I_MATCH) {
+      flag |= F_MATCH | F_ATEND;
+    } else if (op == I_EOL && !(flag & F_ATEND)) {
+      closure(re, re->pcs[i] + 1, 0, 1, &m);
+      for (int j = n; j < m; j++) {
+        if (re->inst[re->pcs[j]].op == I_MATCH) {
+          flag |= F_ATEND;
+        }
+      }
+      m = n;
+    }
+  }
+
+  const int s = re->nst++;
+  re->st[s] = (dstate_t){re->npool, n, flag};
+  memcpy(re->pool + re->npool, re->pcs, n * sizeof(int));
+  re->npool += n;
+  for (int i = 0; i < re->ncls; i++) {
+    re->trans[s * re->ncls + i] = -1;
+  }
+  re->hash[h] = s + 1;
+  return s;
+}
+
+/* add the start state; the value has no start between its bytes */
+static int add_start(csvre_t *re, int bol) {
+  int n = 0;
+  re->gen++;
+  closure(re, 0, bol, 0, &n);
+  return add_state(re, n);
+}
+
+/* compute the state after state s on byte c */
+static int step(csvre_t *re, int s, int c) {
+  const dstate_t d = re->st[s];
+  int n = 0;
+  re->gen++;
+  for (int i = 0; i < d.n; i++) {
+    const inst_t *ip = &re->inst[re->pool[d.off + i]];
+    if (ip->op == I_SET && HAS(&re->set[ip->x], c)) {
+      closure(re, re->pool[d.off + i] + 1, 0, 0, &n);
+    }
+  }
+  /* a match may also start after this byte */
+  closure(re, 0, 0, 0, &n);
+
+  int t = add_state(re, n);
+  if (t >= 0) {
+    re->trans[s * re->ncls + re->cls[c]] = t;
+    return t;
+  }
+
+  /* the cache is full: start over with the new state */
+  flush(re);
+  if ((t = add_state(re, n)) < 0 || (re->start = add_start(re, 1)) < 0) {
+    return -1;
+  }
+  return t;
+}
+
+/* ---------------------------------------------------------------- */
+
+csvre_t *csvre_open(const char *pattern, char *errbuf, int errbufsz) {
+  csvre_t *re = calloc(1, sizeof(*re));
+  if (!re) {
+    seterr(errbuf, errbufsz, "out of memory");
+    return 0;
+  }
+
+  re->pat = pattern;
+  int k = parse_alt(re);
+  if (k >= 0 && *re->pat) {
+    re->err = "unmatched )";
+  }
+  if (re->err || compile(re, k) || emit(re, I_MATCH, 0, 0) < 0) {
+    seterr(errbuf, errbufsz, "regex: %s", re->err ? re->err : "error");
+    csvre_close(re);
+    return 0;
+  }
+
+  /* the empty value is at once the start and the end */
+  re->mark = calloc(re->ninst, sizeof(int));
+  re->stack = malloc((3 * re->ninst + 1) * sizeof(int));
+  re->pcs = malloc((2 * re->ninst + 1) * sizeof(int));
+  if (!re->mark || !re->stack || !re->pcs) {
+    seterr(errbuf, errbufsz, "out of memory");
+    csvre_close(re);
+    return 0;
+  }
+  int n = 0;
+  re->gen++;
+  closure(re, 0, 1, 1, &n);
+  for (int i = 0; i < n; i++) {
+    re->empty |= re->inst[re->pcs[i]].op == I_MATCH;
+  }
+
+  char run[MAXLIT];
+  int runsz = 0;
+  find_literal(re, k, run, &runsz);
+  re->lit[re->litsz] = 0;
+  make_classes(re);
+
+  /* the cache */
+  re->maxst = CACHESZ / (re->ncls * sizeof(int));
+  re->maxst = re->maxst > 10000 ? 10000 : re->maxst;
+  for (re->hashsz = 1; re->hashsz < re->maxst * 2; re->hashsz *= 2)
+    ;
+  re->st = malloc(re->maxst * sizeof(dstate_t));
+  re->trans = malloc(re->maxst * re->ncls * sizeof(int));
+  re->hash = calloc(re->hashsz, sizeof(int));
+  if (!re->st || !re->trans || !re->hash ||
+      (re->start = add_start(re, 1)) < 0) {
+    seterr(errbuf, errbufsz, "out of memory");
+    csvre_close(re);
+    return 0;
+  }
+
+  /* the parse tree is not needed any more */
+  free(re->node);
+  re->node = 0;
+  return re;
+}
+
+void csvre_close(csvre_t *re) {
+  if (re) {
+    free(re->node);
+    free(re->set);
+    free(re->inst);
+    free(re->st);
+    free(re->trans);
+    free(re->pool);
+    free(re->hash);
+    free(re->mark);
+    free(re->stack);
+    free(re->pcs);
+    free(re);
+  }
+}
+
+int csvre_match(csvre_t *re, const char *s, int len) {
+  const uint8_t *p = (const uint8_t *)s;
+  const uint8_t *end = p + len;
+  int st = re->start;
+  if (len == 0) {
+    return re->empty;
+  }
+  for (; p < end; p++) {
+    if (re->st[st].flag & (F_MATCH | F_DEAD)) {
+      return re->st[st].flag & F_MATCH ? 1 : 0;
+    }
+    int t = re->trans[st * re->ncls + re->cls[*p]];
+    if (t < 0 && (t = step(re, st, *p)) < 0) {
+      return -1;
+    }
+    st = t;
+  }
+  return re->st[st].flag & F_ATEND ? 1 : 0;
+}
+
+const char *csvre_literal(csvre_t *re, int *len) {
+  *len = re->litsz;
+  return re->litsz ? re->lit : 0;
+}
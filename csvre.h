@@ -0,0 +1,78 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#ifndef CSVRE_H
+#define CSVRE_H
+
+/*
+
+  A regular expression matcher for field values. The pattern is
+  compiled to an NFA, and the DFA states are built from it lazily, as
+  the input first needs them, so a match is one table lookup per byte
+  with no backtracking. The states are kept in a cache of bounded size
+  that is flushed when it fills up.
+
+  The syntax is that of POSIX extended regular expressions, on bytes:
+
+     .           any byte but \n
+     [abc] [^a-z] a set of bytes, which may use \d \w \s \n \t \r
+     \d \w \s    digit, word and space bytes; \D \W \S the others
+     \c          the char c, if it is not a letter or digit
+     ^ $         the start and the end of the value
+     x* x+ x?    repeats, also x{m} x{m,} x{m,n}; a trailing ? is
+                 accepted and has no effect
+     x|y (x)     alternation and grouping; (?:x) is the same as (x)
+
+  A value matches if the pattern matches any part of it, as in grep.
+
+  General usage:
+
+     csvre_open()
+         csvre_match() for each value
+         ...
+     csvre_close()
+
+  A csvre_t updates its cache in csvre_match(), so it must not be used
+  by two threads at once.
+
+*/
+
+#include "csv.h"
+
+typedef struct csvre_t csvre_t;
+
+/**
+ * Compile pattern. Returns NULL on error, with a message in
+ * errbuf[0..errbufsz).
+ */
+CSV_EXTERN csvre_t *csvre_open(const char *pattern, char *errbuf,
+                               int errbufsz);
+
+/**
+ * Release the matcher.
+ */
+CSV_EXTERN void csvre_close(csvre_t *re);
+
+/**
+ * Check if the value s[0..len) matches. Returns 1 if it does, 0 if it
+ * does not, or -1 if out of memory.
+ */
+CSV_EXTERN int csvre_match(csvre_t *re, const char *s, int len);
+
+/**
+ * Get a string that every matching value contains, the longest run of
+ * literal bytes the pattern requires, so that a buffer can be searched
+ * for it before any value is matched. Returns NULL if there is none.
+ */
+CSV_EXTERN const char *csvre_literal(csvre_t *re, int *len);
+
+#endif /*CSVRE_H*/
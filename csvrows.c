@@ -0,0 +1,196 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-r rows] [-d delim] [-q quote] [-e esc] [-n nullstr]\n\
+            FILE START [COUNT]\n\
+                        \n\
+                        \n\
+  Print COUNT rows of a csv file from row START, numbered from 1. The\n\
+  rows are found through the sparse row index FILE.csvidx, which is\n\
+  built first if it is missing or out of date; see csvidx.h. COUNT\n\
+  defaults to 1.\n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -r rows    : index every Nth row if the index is built; default   \n\
+                   to 1024                                               \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      -n nullstr : specify string representing null; default to \"\"     \n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csvidx.h"
+#include "csvwr.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+const char *pname = 0;
+const char *fname = 0;
+int64_t start = 0;
+int64_t count = 1;
+int qte = '"';
+int esc = 0;
+int delim = ',';
+char nullstr[20] = {0};
+int nullsz = 0;
+csvwr_dialect_t odialect; /* output dialect */
+int64_t stride = 0;
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d, *n;
+  q = e = d = n = 0;
+  while ((opt = getopt(argc, argv, "d:q:e:n:r:h")) != -1) {
+    switch (opt) {
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'n':
+      n = optarg;
+      break;
+    case 'r':
+      stride = strtoll(optarg, 0, 10);
+      if (stride <= 0) {
+        usage(1, "Error: -r rows expects a positive number.");
+      }
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* fname, start, count */
+  if (optind + 2 != argc && optind + 3 != argc) {
+    usage(1, "Error: please supply FILE and START");
+  }
+  fname = argv[optind];
+  start = strtoll(argv[optind + 1], 0, 10);
+  if (start <= 0) {
+    usage(1, "Error: START expects a positive number.");
+  }
+  if (optind + 3 == argc) {
+    count = strtoll(argv[optind + 2], 0, 10);
+    if (count < 0) {
+      usage(1, "Error: COUNT expects a non-negative number.");
+    }
+  }
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  esc = qte;
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+
+  /* nullstr */
+  if (n) {
+    if (strlen(n) >= 20) {
+      usage(1, "Error: -n nullstr is too long. max is 19 chars");
+    }
+    strcpy(nullstr, n);
+  }
+  nullsz = strlen(nullstr);
+
+  odialect = (csvwr_dialect_t){qte, esc, delim, nullstr, nullsz};
+}
+
+int do_row(intptr_t handle, int64_t rownum, char **field, int nfield) {
+  csvwr_t *out = (csvwr_t *)handle;
+  (void)rownum;
+  for (int i = 0; i < nfield; i++) {
+    if (i) {
+      csvwr_putc(out, delim);
+    }
+    csvwr_value(out, &odialect, field[i], field[i] ? strlen(field[i]) : 0);
+  }
+  csvwr_putc(out, '\n');
+  return out->err ? -1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+
+  char errbuf[200];
+  csvidx_t *idx = csvidx_open(fname, qte, esc, delim, nullstr, stride, errbuf,
+                              sizeof(errbuf));
+  if (!idx) {
+    fatal("ERROR: %s\n", errbuf);
+  }
+
+  csvwr_t out;
+  if (csvwr_init(&out, 1, 0)) {
+    fatal("ERROR: out of memory\n");
+  }
+  if (csvidx_read_rows(idx, start, count, (intptr_t)&out, do_row) < 0) {
+    fatal("ERROR: %s\n", out.err ? strerror(out.err) : csvidx_errmsg(idx));
+  }
+  if (csvwr_fini(&out)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(out.err));
+  }
+
+  csvidx_close(idx);
+  return 0;
+}
@@ -0,0 +1,470 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-v] [-H] [-S] [-n rows] [-s seed] [-d delim] [-q quote]\n\
+            [-e esc] [FILE]\n\
+                        \n\
+                        \n\
+  Print a uniform random sample of the rows of a csv file, in the order\n\
+  they are in the file, as they are in the file.\n\
+                        \n\
+  A FILE that can be mapped is sampled by random draws: a byte offset\n\
+  is picked at random, and the row that starts there is taken, if one\n\
+  does, which is checked with csvsync_forward(). Every row starts at\n\
+  one byte, so each is drawn with the same probability whatever its\n\
+  length. Draws are made until there are enough rows; only a small part\n\
+  of a large file is read. A file that would need many draws, or one\n\
+  whose quotes cannot be told, is read whole.\n\
+                        \n\
+  Otherwise, and with -S, the rows are read in a stream from FILE or\n\
+  stdin and kept by reservoir sampling.\n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -v         : print the num bytes read to stderr                    \n\
+      -H         : print the header row first, and do not sample it      \n\
+      -S         : read in a stream                                      \n\
+      -n rows    : specify num rows; default to 10                       \n\
+      -s seed    : specify the seed of the random numbers                \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csv.h"
+#include "csvsync.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PAGESZ 4096 /* bytes read by a random access */
+#define MAXROW (128 * 1024 * 1024) /* max row size in a stream */
+
+const char *pname = 0;
+const char *fname = 0;
+int64_t nrow = 10;
+uint64_t seed = 0;
+int verbose = 0;
+int header = 0;
+int stream = 0;
+int qte = '"';
+int esc = 0;
+int delim = ',';
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d;
+  q = e = d = 0;
+  seed = time(0) ^ ((uint64_t)getpid() << 32);
+  while ((opt = getopt(argc, argv, "d:q:e:n:s:vHSh")) != -1) {
+    switch (opt) {
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'n': {
+      char *end;
+      nrow = strtoll(optarg, &end, 10);
+      if (*end || nrow < 0) {
+        usage(1, "Error: -n rows expects a number.");
+      }
+      break;
+    }
+    case 's': {
+      char *end;
+      seed = strtoull(optarg, &end, 10);
+      if (*end) {
+        usage(1, "Error: -s seed expects a number.");
+      }
+      break;
+    }
+    case 'v':
+      verbose = 1;
+      break;
+    case 'H':
+      header = 1;
+      break;
+    case 'S':
+      stream = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* fname */
+  if (optind + 1 < argc) {
+    usage(1, "Error: too many args");
+  }
+  if (optind < argc && strcmp(argv[optind], "-")) {
+    fname = argv[optind];
+  }
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  esc = qte;
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+}
+
+/* splitmix64 */
+static uint64_t next_rand(void) {
+  uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+/* a random number in [0, n) */
+static inline int64_t uniform(int64_t n) { return next_rand() % n; }
+
+/* a sampled row */
+typedef struct row_t row_t;
+struct row_t {
+  int64_t key; /* row num or offset; the rows are printed in its order */
+  const char *p;
+  int len;
+  char *copy; /* p, if it had to be copied */
+};
+
+row_t *row = 0; /* row[nrow] */
+int64_t nkept = 0;
+int64_t nseen = 0;
+int64_t nread = 0; /* num bytes read */
+
+static int cmp_key(const void *a, const void *b) {
+  const row_t *x = a;
+  const row_t *y = b;
+  return (x->key > y->key) - (x->key < y->key);
+}
+
+/* write p[0..len), and a newline if it does not end with one */
+static void put_row(const char *p, int64_t len) {
+  if (len > 0 && (fwrite(p, 1, len, stdout) != (size_t)len ||
+                  (p[len - 1] != '\n' && EOF == putchar('\n')))) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(errno));
+  }
+}
+
+/* print row[0..n) in the order of their keys */
+static void put_sample(int64_t n) {
+  qsort(row, n, sizeof(*row), cmp_key);
+  for (int64_t i = 0; i < n; i++) {
+    put_row(row[i].p, row[i].len);
+  }
+}
+
+/* offer p[0..len) to the reservoir */
+static void reservoir_add(const char *p, int len) {
+  int64_t i = nseen++;
+  if (i >= nrow && (i = uniform(nseen)) >= nrow) {
+    return;
+  }
+  char *copy = malloc(len ? len : 1);
+  if (!copy) {
+    fatal("ERROR: out of memory\n");
+  }
+  memcpy(copy, p, len);
+  if (i < nkept) {
+    free(row[i].copy);
+  } else {
+    nkept++;
+  }
+  row[i] = (row_t){nseen, copy, len, copy};
+}
+
+/* sample the rows of the stream fp by reservoir sampling */
+static void sample_stream(FILE *fp, csv_parse_t *cp) {
+  int bufsz = 1024 * 1024;
+  char *buf = malloc(bufsz);
+  if (!buf) {
+    fatal("ERROR: out of memory\n");
+  }
+  char *p = buf;
+  char *q = buf;
+  int first = header;
+  for (;;) {
+    /* shift the partial row to the front, and expand if full */
+    if (p != buf) {
+      memmove(buf, p, q - p);
+      q = buf + (q - p);
+      p = buf;
+    }
+    if (q - p == bufsz) {
+      if (bufsz >= MAXROW) {
+        fatal("ERROR: row bigger than 128MB\n");
+      }
+      char *tmp = realloc(buf, bufsz * 2);
+      if (!tmp) {
+        fatal("ERROR: out of memory\n");
+      }
+      q = tmp + (q - buf);
+      p = buf = tmp;
+      bufsz *= 2;
+    }
+
+    int n = fread(q, 1, bufsz - (q - p), fp);
+    if (n <= 0) {
+      if (ferror(fp)) {
+        fatal("ERROR: fread - %s\n", strerror(errno));
+      }
+      break;
+    }
+    q += n;
+    nread += n;
+
+    while (p < q) {
+      n = csv_line(cp, p, q - p);
+      if (n < 0) {
+        fatal("ERROR: %s\n", csv_errmsg(cp));
+      }
+      if (n == 0) {
+        break;
+      }
+      if (first) {
+        put_row(p, n);
+        first = 0;
+      } else {
+        reservoir_add(p, n);
+      }
+      p += n;
+    }
+  }
+  if (p < q) {
+    /* the last row has no newline */
+    if (first) {
+      put_row(p, q - p);
+    } else {
+      reservoir_add(p, q - p);
+    }
+  }
+  free(buf);
+}
+
+/* the size of the row at data[pos..datasz) */
+static int64_t row_size(csv_parse_t *cp, const char *data, int64_t datasz,
+                        int64_t pos) {
+  const int64_t rem = datasz - pos;
+  int nb = csv_line(cp, data + pos, rem < CSV_WINDOW ? rem : CSV_WINDOW);
+  if (nb < 0) {
+    fatal("ERROR: %s\n", csv_errmsg(cp));
+  }
+  if (nb == 0) {
+    if (rem >= CSV_WINDOW) {
+      fatal("ERROR: row too long\n");
+    }
+    nb = rem; /* the last row has no newline */
+  }
+  return nb;
+}
+
+/* sample the rows of data[from..datasz) by reservoir sampling */
+static void sample_all(csv_parse_t *cp, const char *data, int64_t datasz,
+                       int64_t from) {
+  for (int64_t pos = from; pos < datasz;) {
+    int64_t nb = row_size(cp, data, datasz, pos);
+    reservoir_add(data + pos, nb);
+    pos += nb;
+  }
+  nread = datasz;
+}
+
+typedef struct pool_t pool_t;
+struct pool_t {
+  row_t *row;
+  int64_t n, max;
+};
+
+/* drop the rows drawn more than once */
+static void unique(pool_t *pool) {
+  qsort(pool->row, pool->n, sizeof(*pool->row), cmp_key);
+  int64_t n = 0;
+  for (int64_t i = 0; i < pool->n; i++) {
+    if (n == 0 || pool->row[i].key != pool->row[n - 1].key) {
+      pool->row[n++] = pool->row[i];
+    }
+  }
+  pool->n = n;
+}
+
+/* sample the rows of data[from..datasz) by draws at random offsets.
+ * Returns -1 if the whole file should be read instead. */
+static int sample_windows(csv_parse_t *cp, const char *data, int64_t datasz,
+                          int64_t from) {
+  const int64_t bodysz = datasz - from;
+  pool_t pool = {0, 0, 0};
+  int ret = -1;
+
+  /* each draw picks a random byte, and takes the row that starts there,
+   * if one does. Every row starts at exactly one byte, so every row is
+   * drawn with the same probability 1 / bodysz whatever its length. A
+   * row starts after a newline, so most draws end without a look at
+   * more than one byte; the rest are checked with csvsync_forward().
+   * Draws are made until there are nrow different rows. */
+  while (pool.n < nrow) {
+    if (nread > bodysz / 4) {
+      goto bail; /* reading the whole file is about as cheap */
+    }
+    const int64_t pos = from + uniform(bodysz);
+    nread += PAGESZ; /* a random access reads a page */
+    if (pos > from && data[pos - 1] != '\n') {
+      continue;
+    }
+    const int64_t r = csvsync_forward(data, datasz, pos, qte, esc, delim, 0);
+    if (r < 0) {
+      goto bail;
+    }
+    if (r != pos) {
+      continue; /* the newline is in a quoted field */
+    }
+    const int64_t nb = row_size(cp, data, datasz, pos);
+    /* csvsync_forward() looked at a few rows from pos */
+    nread += nb * (CSVSYNC_CONFIRM + 1);
+
+    if (pool.n == pool.max) {
+      int64_t max = pool.max * 2 + 64;
+      row_t *p = realloc(pool.row, max * sizeof(*p));
+      if (!p) {
+        fatal("ERROR: out of memory\n");
+      }
+      pool.row = p;
+      pool.max = max;
+    }
+    pool.row[pool.n++] = (row_t){pos, data + pos, nb, 0};
+    if (pool.n == nrow) {
+      unique(&pool);
+    }
+  }
+
+  memcpy(row, pool.row, nrow * sizeof(*row));
+  nkept = nrow;
+  ret = 0;
+
+bail:
+  free(pool.row);
+  return ret;
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+
+  csv_parse_t *cp = csv_open(qte, esc, delim, 0);
+  if (!cp || !(row = calloc(nrow ? nrow : 1, sizeof(*row)))) {
+    fatal("ERROR: out of memory\n");
+  }
+
+  FILE *fp = stdin;
+  if (fname && !(fp = fopen(fname, "r"))) {
+    fatal("ERROR: fopen %s - %s\n", fname, strerror(errno));
+  }
+
+  struct stat st;
+  const char *data = MAP_FAILED;
+  int64_t datasz = 0;
+  if (!stream && 0 == fstat(fileno(fp), &st) && S_ISREG(st.st_mode) &&
+      st.st_size > 0) {
+    datasz = st.st_size;
+    data = mmap(0, datasz, PROT_READ, MAP_SHARED, fileno(fp), 0);
+  }
+
+  if (data == MAP_FAILED) {
+    sample_stream(fp, cp);
+  } else {
+    madvise((void *)data, datasz, MADV_RANDOM);
+    int64_t from = 0;
+    if (header) {
+      from = row_size(cp, data, datasz, 0);
+      put_row(data, from);
+    }
+    if (nrow > 0 && sample_windows(cp, data, datasz, from)) {
+      nread = 0;
+      sample_all(cp, data, datasz, from);
+    }
+  }
+
+  put_sample(nkept);
+  if (fflush(stdout)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(errno));
+  }
+  if (verbose) {
+    perr("%s: read %" PRId64 " of %" PRId64 " bytes\n",
+         fname ? fname : "stdin", nread, data == MAP_FAILED ? nread : datasz);
+  }
+
+  for (int64_t i = 0; i < nkept; i++) {
+    free(row[i].copy);
+  }
+  free(row);
+  if (data != MAP_FAILED) {
+    munmap((void *)data, datasz);
+  }
+  fclose(fp);
+  csv_close(cp);
+  return 0;
+}
@@ -0,0 +1,862 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-v] [-b] [-k col] [-r rows] [-d delim] [-q quote]\n\
+            [-e esc] [-n nullstr] SOCKET FILE\n\
+         %s -c SOCKET rows START [COUNT]\n\
+         %s -c SOCKET find KEY ...\n\
+                        \n\
+                        \n\
+  Serve the rows of a csv file over a Unix domain socket, so processes\n\
+  on a host share one copy of the file in the page cache instead of\n\
+  loading it each. The file is mmap'ed with its row index FILE.csvidx,\n\
+  and its Bloom filters FILE.csvbloom or with -b its bitmap index\n\
+  FILE.csvbmp on column col; they are built first if missing or out of\n\
+  date. See csvidx.h, csvbloom.h and csvbmp.h.\n\
+                        \n\
+  A request asks for rows START to START + COUNT - 1, or for the rows\n\
+  where column col equals a key. The rows are sent as they are in the\n\
+  file, straight from the mapping. The server runs until it gets SIGINT\n\
+  or SIGTERM. The protocol is described in csvserve.c.\n\
+                        \n\
+  With -c, send one request per KEY, or one rows request, to the server\n\
+  at SOCKET and print the rows.\n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -v         : print what is served to stderr                        \n\
+      -b         : use the bitmap index                                  \n\
+      -c         : run as a client                                       \n\
+      -k col     : specify the key column by number from 1, or by name   \n\
+                   in the header row; default to 1                        \n\
+      -r rows    : specify rows per block if the index is built;         \n\
+                   default to 1024                                        \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      -n nullstr : specify string representing null; default to \"\"     \n\
+      \n\
+  If col is a name, the header row is not matched.\n\
+      \n\
+";
+
+/*
+  The protocol. Numbers are in host byte order, as the socket is local.
+  A request is
+
+      uint32 len     : num bytes of the request after this field
+      uint32 op      : OP_ROWS or OP_FIND
+      payload        : for OP_ROWS, int64 start and int64 count;
+                       for OP_FIND, the key
+
+  and its response is
+
+      uint32 status  : ST_OK, ST_BADREQ or ST_ERROR
+      uint32 unused  : zero
+      uint64 nrow    : num rows
+      uint64 len     : num bytes that follow
+      data           : the rows as they are in the file, each ending
+                       with a newline; or an error message
+
+  A connection may send many requests; they are answered in order.
+*/
+
+#define _GNU_SOURCE
+#include "csv.h"
+#include "csvbloom.h"
+#include "csvbmp.h"
+#include "csvidx.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define MAXREQ (64 * 1024) /* max bytes in a request */
+#define MAXEVENT 64
+
+#define OP_ROWS 1
+#define OP_FIND 2
+
+#define ST_OK 0
+#define ST_BADREQ 1
+#define ST_ERROR 2
+
+typedef struct reqhdr_t reqhdr_t;
+struct reqhdr_t {
+  uint32_t len;
+  uint32_t op;
+};
+
+typedef struct resphdr_t resphdr_t;
+struct resphdr_t {
+  uint32_t status;
+  uint32_t unused;
+  uint64_t nrow;
+  uint64_t len;
+};
+
+const char *pname = 0;
+const char *sockpath = 0;
+const char *fname = 0;
+char *const *cmd = 0; /* client: the request */
+int ncmd = 0;
+const char *colname = "1";
+int col = -1;
+int verbose = 0;
+int usebmp = 0;
+int client = 0;
+int qte = '"';
+int esc = 0;
+int delim = ',';
+char nullstr[20] = {0};
+int64_t stride = 0;
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname, pname, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d, *n;
+  q = e = d = n = 0;
+  while ((opt = getopt(argc, argv, "d:q:e:n:k:r:bcvh")) != -1) {
+    switch (opt) {
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'n':
+      n = optarg;
+      break;
+    case 'k':
+      colname = optarg;
+      break;
+    case 'r':
+      stride = strtoll(optarg, 0, 10);
+      if (stride <= 0) {
+        usage(1, "Error: -r rows expects a positive number.");
+      }
+      break;
+    case 'b':
+      usebmp = 1;
+      break;
+    case 'c':
+      client = 1;
+      break;
+    case 'v':
+      verbose = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  if (client) {
+    /* SOCKET rows START [COUNT] | SOCKET find KEY ... */
+    if (optind + 3 > argc) {
+      usage(1, "Error: please supply SOCKET and a request");
+    }
+    sockpath = argv[optind];
+    cmd = argv + optind + 1;
+    ncmd = argc - optind - 1;
+    if (!(0 == strcmp(cmd[0], "rows") && ncmd <= 3) &&
+        0 != strcmp(cmd[0], "find")) {
+      usage(1, "Error: bad request");
+    }
+    return;
+  }
+
+  /* sockpath, fname */
+  if (optind + 2 != argc) {
+    usage(1, "Error: please supply SOCKET and FILE");
+  }
+  sockpath = argv[optind];
+  fname = argv[optind + 1];
+
+  /* col */
+  char *end;
+  long c = strtol(colname, &end, 10);
+  if (*colname && !*end) {
+    if (c <= 0 || c > 1000000) {
+      usage(1, "Error: -k col expects a column number from 1, or a name.");
+    }
+    col = c - 1;
+  }
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  esc = qte;
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+
+  /* nullstr */
+  if (n) {
+    if (strlen(n) >= 20) {
+      usage(1, "Error: -n nullstr is too long. max is 19 chars");
+    }
+    strcpy(nullstr, n);
+  }
+}
+
+/* fill in the address of the socket at sockpath */
+static void make_addr(struct sockaddr_un *addr) {
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  if (strlen(sockpath) >= sizeof(addr->sun_path)) {
+    fatal("ERROR: socket path %s is too long\n", sockpath);
+  }
+  strcpy(addr->sun_path, sockpath);
+}
+
+/* --------------------------------------------------------------------
+ * The client
+ */
+
+/* read or write exactly n bytes */
+static int read_all(int fd, void *buf, int64_t n) {
+  char *p = buf;
+  while (n > 0) {
+    ssize_t nb = read(fd, p, n);
+    if (nb < 0 && errno == EINTR) {
+      continue;
+    }
+    if (nb <= 0) {
+      return -1;
+    }
+    p += nb;
+    n -= nb;
+  }
+  return 0;
+}
+
+static int write_all(int fd, const void *buf, int64_t n) {
+  const char *p = buf;
+  while (n > 0) {
+    ssize_t nb = write(fd, p, n);
+    if (nb < 0 && errno == EINTR) {
+      continue;
+    }
+    if (nb <= 0) {
+      return -1;
+    }
+    p += nb;
+    n -= nb;
+  }
+  return 0;
+}
+
+/* send a request and print its response */
+static void request(int fd, uint32_t op, const void *payload, int len) {
+  reqhdr_t req = {sizeof(uint32_t) + len, op};
+  if (write_all(fd, &req, sizeof(req)) || write_all(fd, payload, len)) {
+    fatal("ERROR: cannot send request - %s\n", strerror(errno));
+  }
+  resphdr_t resp;
+  if (read_all(fd, &resp, sizeof(resp))) {
+    fatal("ERROR: cannot read response\n");
+  }
+  char buf[64 * 1024];
+  FILE *out = resp.status == ST_OK ? stdout : stderr;
+  if (out == stderr) {
+    perr("ERROR: ");
+  }
+  for (uint64_t n = resp.len; n > 0;) {
+    int nb = n < sizeof(buf) ? n : sizeof(buf);
+    if (read_all(fd, buf, nb)) {
+      fatal("ERROR: cannot read response\n");
+    }
+    fwrite(buf, 1, nb, out);
+    n -= nb;
+  }
+  if (resp.status != ST_OK) {
+    fatal("\n");
+  }
+}
+
+static int run_client(void) {
+  struct sockaddr_un addr;
+  make_addr(&addr);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+    fatal("ERROR: connect %s - %s\n", sockpath, strerror(errno));
+  }
+
+  if (0 == strcmp(cmd[0], "rows")) {
+    char *end;
+    int64_t arg[2] = {strtoll(cmd[1], &end, 10), INT64_MAX};
+    if (*end || (ncmd == 3 && (arg[1] = strtoll(cmd[2], &end, 10), *end))) {
+      usage(1, "Error: rows expects START [COUNT]");
+    }
+    request(fd, OP_ROWS, arg, sizeof(arg));
+  } else {
+    for (int i = 1; i < ncmd; i++) {
+      request(fd, OP_FIND, cmd[i], strlen(cmd[i]));
+    }
+  }
+
+  if (fflush(stdout)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(errno));
+  }
+  close(fd);
+  return 0;
+}
+
+/* --------------------------------------------------------------------
+ * The server
+ */
+
+/* a client connection */
+typedef struct conn_t conn_t;
+struct conn_t {
+  int fd;
+  int wantout; /* waiting for EPOLLOUT */
+  char in[MAXREQ];
+  int inlen;
+  /* the response being sent: hdr from hdrsent, then iov[iovpos..niov) */
+  int busy;
+  resphdr_t hdr;
+  int hdrsent;
+  struct iovec *iov;
+  int niov, maxiov, iovpos;
+  char *msg; /* error message in the response */
+};
+
+csvidx_t *idx = 0;
+csvbloom_t *bloom = 0;
+csvbmp_t *bmp = 0;
+csv_parse_t *cp = 0;
+const char *data = 0;
+int64_t datasz = 0;
+int64_t nrow = 0;
+int64_t first = 1; /* first row to match */
+/* the last row if it has no newline, with one */
+int64_t lastpos = -1;
+char *tail = 0;
+uint64_t *set = 0; /* candidate blocks from the bitmap index */
+char *scratch = 0;
+int scratchmax = 0;
+volatile sig_atomic_t stopping = 0;
+
+static void on_signal(int sig) {
+  (void)sig;
+  stopping = 1;
+}
+
+/* parse the row at data[pos]. Returns its size, or -1 on error. */
+static int64_t parse_row(int64_t pos) {
+  if (pos == lastpos) {
+    return csv_line(cp, tail, datasz - pos + 1) > 0 ? datasz - pos : -1;
+  }
+  const int64_t rem = datasz - pos;
+  int nb = csv_line(cp, data + pos, rem < CSV_WINDOW ? rem : CSV_WINDOW);
+  return nb > 0 ? nb : -1;
+}
+
+/* the offset of row rownum, or datasz if it is past the last row */
+static int64_t seek_row(int64_t rownum) {
+  if (rownum > nrow) {
+    return datasz;
+  }
+  const int64_t k = (rownum - 1) / csvidx_stride(idx);
+  int64_t pos = csvidx_offset(idx, k);
+  for (int64_t r = k * csvidx_stride(idx) + 1; r < rownum; r++) {
+    int64_t nb = parse_row(pos);
+    if (nb < 0) {
+      return -1;
+    }
+    pos += nb;
+  }
+  return pos;
+}
+
+/* add p[0..len) to the response */
+static int add_iov(conn_t *c, const char *p, int64_t len) {
+  if (c->niov == c->maxiov) {
+    int max = c->maxiov * 2 + 16;
+    struct iovec *v = realloc(c->iov, max * sizeof(*v));
+    if (!v) {
+      return -1;
+    }
+    c->iov = v;
+    c->maxiov = max;
+  }
+  c->iov[c->niov++] = (struct iovec){(void *)p, len};
+  c->hdr.len += len;
+  return 0;
+}
+
+/* add data[pos..pos+len) to the response, after the span before it if
+ * they touch */
+static int add_span(conn_t *c, int64_t pos, int64_t len) {
+  if (c->niov) {
+    struct iovec *v = &c->iov[c->niov - 1];
+    if ((const char *)v->iov_base + v->iov_len == data + pos) {
+      v->iov_len += len;
+      c->hdr.len += len;
+      return 0;
+    }
+  }
+  return add_iov(c, data + pos, len);
+}
+
+/* end the rows with a newline if the last row of the file has none */
+static int end_rows(conn_t *c) {
+  if (c->niov && lastpos >= 0) {
+    const struct iovec *v = &c->iov[c->niov - 1];
+    if ((const char *)v->iov_base + v->iov_len == data + datasz) {
+      return add_iov(c, "\n", 1);
+    }
+  }
+  return 0;
+}
+
+/* make the response an error */
+static int set_error(conn_t *c, int status, const char *msg) {
+  c->niov = 0;
+  c->hdr = (resphdr_t){status, 0, 0, 0};
+  free(c->msg);
+  if (!(c->msg = strdup(msg))) {
+    return -1;
+  }
+  return add_iov(c, c->msg, strlen(msg));
+}
+
+/* rows start to start + count - 1 */
+static int do_rows(conn_t *c, int64_t start, int64_t count) {
+  if (start <= 0 || count < 0) {
+    return set_error(c, ST_BADREQ, "bad START or COUNT");
+  }
+  if (start > nrow) {
+    return 0;
+  }
+  count = count < nrow - start + 1 ? count : nrow - start + 1;
+  const int64_t lo = seek_row(start);
+  const int64_t hi = seek_row(start + count);
+  if (lo < 0 || hi < 0) {
+    return set_error(c, ST_ERROR, csv_errmsg(cp));
+  }
+  c->hdr.nrow = count;
+  return add_span(c, lo, hi - lo) || end_rows(c);
+}
+
+/* check if block k may have the key */
+static inline int candidate(int64_t k, uint64_t hash) {
+  return set ? (int)((set[k / 64] >> (k % 64)) & 1)
+             : csvbloom_test(bloom, k, hash);
+}
+
+/* the rows where column col is key[0..len) */
+static int do_find(conn_t *c, const char *key, int len) {
+  const int64_t rows = csvidx_stride(idx);
+  const int64_t nblock = csvidx_nentry(idx);
+  uint64_t hash = 0;
+  if (bmp) {
+    memset(set, 0, (nblock + 63) / 64 * sizeof(*set));
+    int id = csvbmp_find(bmp, key, len);
+    if (id < 0) {
+      return 0;
+    }
+    csvbmp_or(bmp, id, set);
+  } else {
+    hash = csvbloom_hash(key, len);
+  }
+
+  for (int64_t k = 0; k < nblock; k++) {
+    if (!candidate(k, hash)) {
+      continue;
+    }
+    int64_t pos = csvidx_offset(idx, k);
+    for (int64_t r = k * rows + 1; r <= (k + 1) * rows && r <= nrow; r++) {
+      const int64_t nb = parse_row(pos);
+      if (nb < 0) {
+        return set_error(c, ST_ERROR, csv_errmsg(cp));
+      }
+      char **field;
+      int *flen;
+      char *quoted;
+      if (r >= first && col < csv_rawfields(cp, &field, &flen, &quoted)) {
+        if (flen[col] >= scratchmax) {
+          scratchmax = flen[col] * 1.5 + 64;
+          if (!(scratch = realloc(scratch, scratchmax))) {
+            return -1;
+          }
+        }
+        int n = csv_decode(cp, field[col], flen[col], quoted[col], scratch);
+        if (n == len && 0 == memcmp(scratch, key, len)) {
+          c->hdr.nrow++;
+          if (add_span(c, pos, nb)) {
+            return -1;
+          }
+        }
+      }
+      pos += nb;
+    }
+  }
+  return end_rows(c);
+}
+
+/* answer the request in in[0..reqsz). Returns -1 if out of memory. */
+static int handle(conn_t *c, const char *req, int reqsz) {
+  reqhdr_t h;
+  memcpy(&h, req, sizeof(h));
+  const char *payload = req + sizeof(h);
+  const int len = reqsz - sizeof(h);
+  c->hdr = (resphdr_t){ST_OK, 0, 0, 0};
+  c->niov = c->iovpos = c->hdrsent = 0;
+  c->busy = 1;
+
+  if (h.op == OP_ROWS && len == 2 * sizeof(int64_t)) {
+    int64_t arg[2];
+    memcpy(arg, payload, sizeof(arg));
+    if (verbose) {
+      perr("%s: rows %" PRId64 " %" PRId64 "\n", fname, arg[0], arg[1]);
+    }
+    return do_rows(c, arg[0], arg[1]);
+  }
+  if (h.op == OP_FIND) {
+    if (verbose) {
+      perr("%s: find %.*s\n", fname, len, payload);
+    }
+    return do_find(c, payload, len);
+  }
+  return set_error(c, ST_BADREQ, "bad request");
+}
+
+static void drop(int ep, conn_t *c) {
+  epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, 0);
+  close(c->fd);
+  free(c->iov);
+  free(c->msg);
+  free(c);
+}
+
+/* watch c for input, or for room to write if wantout */
+static int watch(int ep, conn_t *c, int wantout) {
+  if (c->wantout == wantout) {
+    return 0;
+  }
+  struct epoll_event ev = {wantout ? EPOLLOUT : EPOLLIN, {.ptr = c}};
+  c->wantout = wantout;
+  return epoll_ctl(ep, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+/* send what the socket takes of the response. Returns 1 if it is all
+ * sent, 0 if the socket is full, or -1 on error. */
+static int flush(conn_t *c) {
+  const int hdrsz = sizeof(c->hdr);
+  while (c->hdrsent < hdrsz || c->iovpos < c->niov) {
+    struct iovec iov[IOV_MAX];
+    int n = 0;
+    if (c->hdrsent < hdrsz) {
+      iov[n++] = (struct iovec){(char *)&c->hdr + c->hdrsent,
+                                hdrsz - c->hdrsent};
+    }
+    for (int i = c->iovpos; i < c->niov && n < IOV_MAX; i++) {
+      iov[n++] = c->iov[i];
+    }
+    ssize_t nb = writev(c->fd, iov, n);
+    if (nb < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    }
+    if (c->hdrsent < hdrsz) {
+      int m = nb < hdrsz - c->hdrsent ? nb : hdrsz - c->hdrsent;
+      c->hdrsent += m;
+      nb -= m;
+    }
+    for (; c->iovpos < c->niov; c->iovpos++) {
+      struct iovec *v = &c->iov[c->iovpos];
+      if ((size_t)nb < v->iov_len) {
+        v->iov_base = (char *)v->iov_base + nb;
+        v->iov_len -= nb;
+        break;
+      }
+      nb -= v->iov_len;
+    }
+  }
+  c->busy = 0;
+  return 1;
+}
+
+/* read and answer the requests of c. Returns -1 to drop c. */
+static int serve(int ep, conn_t *c) {
+  for (;;) {
+    if (c->busy) {
+      int ret = flush(c);
+      if (ret <= 0) {
+        return ret < 0 ? -1 : watch(ep, c, 1);
+      }
+      if (watch(ep, c, 0)) {
+        return -1;
+      }
+    }
+
+    /* answer a whole request in in[] */
+    uint32_t len;
+    if (c->inlen >= (int)sizeof(len)) {
+      memcpy(&len, c->in, sizeof(len));
+      if (len < sizeof(uint32_t) || len > MAXREQ - sizeof(len)) {
+        return -1;
+      }
+      const int reqsz = sizeof(len) + len;
+      if (c->inlen >= reqsz) {
+        if (handle(c, c->in, reqsz)) {
+          return -1;
+        }
+        memmove(c->in, c->in + reqsz, c->inlen - reqsz);
+        c->inlen -= reqsz;
+        continue;
+      }
+    }
+
+    ssize_t nb = read(c->fd, c->in + c->inlen, sizeof(c->in) - c->inlen);
+    if (nb < 0 && errno == EINTR) {
+      continue;
+    }
+    if (nb < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    }
+    if (nb == 0) {
+      return -1; /* closed */
+    }
+    c->inlen += nb;
+  }
+}
+
+/* take the new connections on sock */
+static void accept_all(int ep, int sock) {
+  for (;;) {
+    int fd = accept4(sock, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        perr("%s: accept - %s\n", pname, strerror(errno));
+      }
+      return;
+    }
+    conn_t *c = calloc(1, sizeof(*c));
+    if (!c) {
+      close(fd);
+      continue;
+    }
+    c->fd = fd;
+    struct epoll_event ev = {EPOLLIN, {.ptr = c}};
+    if (epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev)) {
+      close(fd);
+      free(c);
+    }
+  }
+}
+
+/* find colname in the header row */
+int do_header(intptr_t handle, int64_t rownum, char **field, int nfield) {
+  (void)handle;
+  (void)rownum;
+  for (int i = 0; i < nfield; i++) {
+    if (field[i] && 0 == strcmp(field[i], colname)) {
+      col = i;
+      return 0;
+    }
+  }
+  return 0;
+}
+
+/* map the file and open its indexes */
+static void open_file(void) {
+  char errbuf[200];
+  idx = csvidx_open(fname, qte, esc, delim, nullstr, stride, errbuf,
+                    sizeof(errbuf));
+  if (!idx) {
+    fatal("ERROR: %s\n", errbuf);
+  }
+  nrow = csvidx_nrow(idx);
+  datasz = csvidx_fsize(idx);
+
+  /* a named column is looked up in the header row, which is skipped */
+  if (col < 0) {
+    if (csvidx_read_rows(idx, 1, 1, 0, do_header) < 0) {
+      fatal("ERROR: %s\n", csvidx_errmsg(idx));
+    }
+    if (col < 0) {
+      fatal("ERROR: no column named '%s'\n", colname);
+    }
+    first = 2;
+  }
+
+  if (usebmp) {
+    bmp = csvbmp_open(fname, qte, esc, delim, nullstr, col,
+                      csvidx_stride(idx), errbuf, sizeof(errbuf));
+    if (!bmp && verbose) {
+      perr("%s: using Bloom filters - %s\n", fname, errbuf);
+    }
+  }
+  if (bmp) {
+    if (!(set = calloc((csvidx_nentry(idx) + 63) / 64 + 1, sizeof(*set)))) {
+      fatal("ERROR: out of memory\n");
+    }
+  } else {
+    bloom = csvbloom_open(fname, qte, esc, delim, nullstr, col,
+                          csvidx_stride(idx), errbuf, sizeof(errbuf));
+    if (!bloom) {
+      fatal("ERROR: %s\n", errbuf);
+    }
+  }
+
+  if (!(cp = csv_open(qte, esc, delim, nullstr))) {
+    fatal("ERROR: out of memory\n");
+  }
+  if (datasz > 0) {
+    int fd = open(fname, O_RDONLY);
+    if (fd < 0) {
+      fatal("ERROR: open %s - %s\n", fname, strerror(errno));
+    }
+    data = mmap(0, datasz, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      fatal("ERROR: mmap %s - %s\n", fname, strerror(errno));
+    }
+    close(fd);
+
+    if (data[datasz - 1] != '\n') {
+      /* keep a copy of the last row with a newline for csv_line() */
+      if ((lastpos = csvidx_seek_row(idx, nrow)) < 0) {
+        fatal("ERROR: %s\n", csvidx_errmsg(idx));
+      }
+      if (!(tail = malloc(datasz - lastpos + 1))) {
+        fatal("ERROR: out of memory\n");
+      }
+      memcpy(tail, data + lastpos, datasz - lastpos);
+      tail[datasz - lastpos] = '\n';
+    }
+  }
+}
+
+static int run_server(void) {
+  open_file();
+
+  struct sockaddr_un addr;
+  make_addr(&addr);
+  int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (sock < 0) {
+    fatal("ERROR: socket - %s\n", strerror(errno));
+  }
+  /* take over the socket path unless a server is listening on it */
+  if (0 == connect(sock, (struct sockaddr *)&addr, sizeof(addr))) {
+    fatal("ERROR: a server is running on %s\n", sockpath);
+  }
+  unlink(sockpath);
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) ||
+      listen(sock, SOMAXCONN)) {
+    fatal("ERROR: bind %s - %s\n", sockpath, strerror(errno));
+  }
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_signal;
+  sigaction(SIGINT, &sa, 0);
+  sigaction(SIGTERM, &sa, 0);
+  signal(SIGPIPE, SIG_IGN);
+
+  int ep = epoll_create1(EPOLL_CLOEXEC);
+  struct epoll_event ev = {EPOLLIN, {.ptr = 0}};
+  if (ep < 0 || epoll_ctl(ep, EPOLL_CTL_ADD, sock, &ev)) {
+    fatal("ERROR: epoll - %s\n", strerror(errno));
+  }
+  if (verbose) {
+    perr("%s: serving %" PRId64 " rows on %s\n", fname, nrow, sockpath);
+  }
+
+  while (!stopping) {
+    struct epoll_event evs[MAXEVENT];
+    int n = epoll_wait(ep, evs, MAXEVENT, -1);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      fatal("ERROR: epoll_wait - %s\n", strerror(errno));
+    }
+    for (int i = 0; i < n; i++) {
+      conn_t *c = evs[i].data.ptr;
+      if (!c) {
+        accept_all(ep, sock);
+      } else if (serve(ep, c)) {
+        drop(ep, c);
+      }
+    }
+  }
+
+  /* connections are left to exit() */
+  unlink(sockpath);
+  close(sock);
+  close(ep);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+  return client ? run_client() : run_server();
+}
@@ -0,0 +1,339 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#define _GNU_SOURCE
+#include "csvshm.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAGIC 0x0a314d4853565343ull /* "CSVSHM1\n" */
+#define PAD 0xffffffffu             /* batch len that marks a wrap */
+#define DONE 1                      /* ring->done: all batches are in */
+#define ABORT 2                     /* ring->done: producer failed */
+#define ALIGN8(x) (((int64_t)(x) + 7) & ~(int64_t)7)
+#define POLLMS 100                  /* how often a waiter checks its peer */
+
+/*
+ * The ring header is followed by data[size]. A batch in data[] is a
+ * 32-bit len, the bytes, and padding to 8 bytes. A batch never wraps
+ * around; if it does not fit at the end of data[], a PAD len is put
+ * there and the batch goes to the start.
+ *
+ * head and tail count the bytes ever published and released, so the
+ * ring is empty when head == tail, and head % size is the write
+ * position. The producer and the consumer each own one cache line.
+ *
+ * A side that waits on a futex wakes up every POLLMS to check that
+ * the process on the other side, as given by ppid and cpid, is still
+ * there, so that it does not sleep forever if its peer is killed.
+ */
+typedef struct ring_t ring_t;
+struct ring_t {
+  uint64_t magic; /* set last by the producer */
+  int64_t size;   /* num bytes in data[] */
+  uint32_t done;  /* producer has finished; DONE or ABORT */
+  int32_t ppid;   /* producer process */
+  int32_t cpid;   /* consumer process, or 0 until it attaches */
+
+  int64_t head __attribute__((aligned(64))); /* written by producer */
+  uint32_t headseq; /* futex; bumped when head moves or on done */
+  uint32_t cwait;   /* consumer is asleep on headseq */
+
+  int64_t tail __attribute__((aligned(64))); /* written by consumer */
+  uint32_t tailseq; /* futex; bumped when tail moves */
+  uint32_t pwait;   /* producer is asleep on tailseq */
+} __attribute__((aligned(64)));
+
+struct csvshm_t {
+  ring_t *ring;
+  char *data;    /* data[] after the ring header */
+  int64_t mapsz; /* num bytes mapped */
+  int fd;
+  char *name;   /* producer: name of the shm object, or NULL */
+  int64_t skip; /* producer: PAD bytes before the reserved batch */
+  int64_t next; /* consumer: tail after the batch being read */
+};
+
+static inline uint32_t get32(const char *p) {
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+static inline void put32(char *p, uint32_t v) { memcpy(p, &v, 4); }
+
+/* the futexes are shared across processes; no FUTEX_PRIVATE_FLAG */
+static void futex_wait(uint32_t *addr, uint32_t val) {
+  const struct timespec ts = {0, POLLMS * 1000 * 1000};
+  syscall(SYS_futex, addr, FUTEX_WAIT, val, &ts, 0, 0);
+}
+
+/* check if process pid has gone away */
+static int gone(int32_t pid) {
+  return pid > 0 && kill(pid, 0) && errno == ESRCH;
+}
+
+static void futex_wake(uint32_t *addr) {
+  syscall(SYS_futex, addr, FUTEX_WAKE, 1, 0, 0, 0);
+}
+
+/* map the ring in fd; if size > 0, set it up as a new ring */
+static csvshm_t *map_ring(int fd, int64_t size) {
+  csvshm_t *shm = calloc(1, sizeof(*shm));
+  if (!shm) {
+    errno = ENOMEM;
+    return 0;
+  }
+
+  if (size > 0) {
+    shm->mapsz = sizeof(ring_t) + size;
+    if (ftruncate(fd, shm->mapsz)) {
+      goto bail;
+    }
+  } else {
+    struct stat st;
+    if (fstat(fd, &st)) {
+      goto bail;
+    }
+    shm->mapsz = st.st_size;
+    if (shm->mapsz < (int64_t)sizeof(ring_t)) {
+      errno = EINVAL;
+      goto bail;
+    }
+  }
+
+  void *p = mmap(0, shm->mapsz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    goto bail;
+  }
+  shm->ring = p;
+  shm->data = (char *)p + sizeof(ring_t);
+  shm->fd = fd;
+
+  if (size > 0) {
+    shm->ring->size = size;
+    shm->ring->ppid = getpid();
+    __atomic_store_n(&shm->ring->magic, MAGIC, __ATOMIC_RELEASE);
+  } else if (__atomic_load_n(&shm->ring->magic, __ATOMIC_ACQUIRE) != MAGIC ||
+             shm->ring->size + (int64_t)sizeof(ring_t) > shm->mapsz) {
+    munmap(p, shm->mapsz);
+    errno = EINVAL;
+    goto bail;
+  }
+  shm->next = shm->ring->tail;
+  return shm;
+
+bail:
+  free(shm);
+  return 0;
+}
+
+csvshm_t *csvshm_create(const char *name, int64_t size) {
+  size = ALIGN8(size);
+  if (size < 64 || size > INT32_MAX) {
+    errno = EINVAL;
+    return 0;
+  }
+
+  int fd = name ? shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600)
+                : memfd_create("csvshm", 0);
+  if (fd < 0) {
+    return 0;
+  }
+  csvshm_t *shm = map_ring(fd, size);
+  if (shm && name && !(shm->name = strdup(name))) {
+    csvshm_close(shm);
+    shm = 0;
+    fd = -1;
+    errno = ENOMEM;
+  }
+  if (!shm) {
+    int e = errno;
+    if (fd >= 0) {
+      close(fd);
+    }
+    if (name) {
+      shm_unlink(name);
+    }
+    errno = e;
+  }
+  return shm;
+}
+
+csvshm_t *csvshm_attach_fd(int fd) {
+  csvshm_t *shm = map_ring(fd, 0);
+  if (shm) {
+    __atomic_store_n(&shm->ring->cpid, getpid(), __ATOMIC_SEQ_CST);
+  }
+  return shm;
+}
+
+csvshm_t *csvshm_attach(const char *name, int timeout_ms) {
+  const struct timespec ms = {0, 1000 * 1000};
+  for (int i = 0;; i++) {
+    /* the producer may not have created or set up the ring yet */
+    int fd = shm_open(name, O_RDWR, 0);
+    csvshm_t *shm = fd < 0 ? 0 : csvshm_attach_fd(fd);
+    if (shm) {
+      shm_unlink(name);
+      return shm;
+    }
+    int e = errno;
+    if (fd >= 0) {
+      close(fd);
+    }
+    if ((e != ENOENT && e != EINVAL) || i >= timeout_ms) {
+      errno = e;
+      return 0;
+    }
+    nanosleep(&ms, 0);
+  }
+}
+
+int csvshm_fd(csvshm_t *shm) { return shm->fd; }
+
+void csvshm_close(csvshm_t *shm) {
+  if (shm) {
+    munmap(shm->ring, shm->mapsz);
+    close(shm->fd);
+    free(shm->name);
+    free(shm);
+  }
+}
+
+int csvshm_maxbatch(csvshm_t *shm) { return shm->ring->size / 2 - 8; }
+
+char *csvshm_reserve(csvshm_t *shm, int n) {
+  ring_t *const ring = shm->ring;
+  if (n < 0 || n > csvshm_maxbatch(shm)) {
+    errno = EINVAL;
+    return 0;
+  }
+
+  const int64_t size = ring->size;
+  const int64_t head = ring->head;
+  const int64_t pos = head % size;
+  const int64_t need = ALIGN8(4 + n);
+  shm->skip = size - pos < need ? size - pos : 0;
+
+  /* wait for the consumer to free up skip + need bytes */
+#define ROOM() (size - (head - __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST)))
+  while (ROOM() < shm->skip + need) {
+    uint32_t seq = __atomic_load_n(&ring->tailseq, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&ring->pwait, 1, __ATOMIC_SEQ_CST);
+    if (ROOM() < shm->skip + need) {
+      futex_wait(&ring->tailseq, seq);
+    }
+    __atomic_store_n(&ring->pwait, 0, __ATOMIC_SEQ_CST);
+    if (ROOM() < shm->skip + need &&
+        gone(__atomic_load_n(&ring->cpid, __ATOMIC_SEQ_CST))) {
+      errno = EPIPE;
+      return 0;
+    }
+  }
+#undef ROOM
+
+  if (shm->skip) {
+    put32(shm->data + pos, PAD);
+    return shm->data + 4;
+  }
+  return shm->data + pos + 4;
+}
+
+void csvshm_commit(csvshm_t *shm, int n) {
+  ring_t *const ring = shm->ring;
+  if (n <= 0) {
+    return; /* an empty batch would read as the end */
+  }
+  const int64_t head = ring->head + shm->skip;
+  put32(shm->data + head % ring->size, n);
+  __atomic_store_n(&ring->head, head + ALIGN8(4 + n), __ATOMIC_SEQ_CST);
+  __atomic_add_fetch(&ring->headseq, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&ring->cwait, __ATOMIC_SEQ_CST)) {
+    futex_wake(&ring->headseq);
+  }
+}
+
+static void set_done(csvshm_t *shm, uint32_t done) {
+  ring_t *const ring = shm->ring;
+  __atomic_store_n(&ring->done, done, __ATOMIC_SEQ_CST);
+  __atomic_add_fetch(&ring->headseq, 1, __ATOMIC_SEQ_CST);
+  futex_wake(&ring->headseq);
+}
+
+void csvshm_finish(csvshm_t *shm) { set_done(shm, DONE); }
+
+void csvshm_abort(csvshm_t *shm) {
+  set_done(shm, ABORT);
+  if (shm->name && !__atomic_load_n(&shm->ring->cpid, __ATOMIC_SEQ_CST)) {
+    shm_unlink(shm->name); /* the consumer unlinks it when it attaches */
+  }
+}
+
+int csvshm_get(csvshm_t *shm, const char **batch) {
+  ring_t *const ring = shm->ring;
+  int64_t tail = shm->next;
+
+  /* wait for the producer to publish a batch or finish */
+#define READY()                                                                \
+  (__atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) != tail ||                   \
+   __atomic_load_n(&ring->done, __ATOMIC_SEQ_CST))
+  while (!READY()) {
+    uint32_t seq = __atomic_load_n(&ring->headseq, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&ring->cwait, 1, __ATOMIC_SEQ_CST);
+    if (!READY()) {
+      futex_wait(&ring->headseq, seq);
+    }
+    __atomic_store_n(&ring->cwait, 0, __ATOMIC_SEQ_CST);
+    if (!READY() && gone(ring->ppid)) {
+      errno = EPIPE;
+      return -1;
+    }
+  }
+#undef READY
+  if (__atomic_load_n(&ring->done, __ATOMIC_SEQ_CST) == ABORT) {
+    errno = ECANCELED;
+    return -1;
+  }
+  if (__atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) == tail) {
+    return 0; /* done */
+  }
+
+  int64_t pos = tail % ring->size;
+  uint32_t n = get32(shm->data + pos);
+  if (n == PAD) {
+    tail += ring->size - pos;
+    pos = 0;
+    n = get32(shm->data);
+  }
+  shm->next = tail + ALIGN8(4 + n);
+  *batch = shm->data + pos + 4;
+  return n;
+}
+
+void csvshm_release(csvshm_t *shm) {
+  ring_t *const ring = shm->ring;
+  __atomic_store_n(&ring->tail, shm->next, __ATOMIC_SEQ_CST);
+  __atomic_add_fetch(&ring->tailseq, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&ring->pwait, __ATOMIC_SEQ_CST)) {
+    futex_wake(&ring->tailseq);
+  }
+}
@@ -0,0 +1,126 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#ifndef CSVSHM_H
+#define CSVSHM_H
+
+/*
+
+  A shared-memory ring for handing batches of parsed rows from one
+  producer process to one consumer process on the same host. Batches
+  are written and read in place in the ring, and each side sleeps on a
+  futex only when the ring is full or empty.
+
+  A batch is any run of bytes; the csv tools fill it with rows in the
+  csvbin format (see csvbin.h), so a consumer walks the rows with
+  csvbin_row() and csvbin_next().
+
+  The ring lives in a POSIX shared memory object named by the
+  producer, or in an anonymous memfd if the name is NULL, in which case
+  the fd from csvshm_fd() must be passed to the consumer process.
+
+  Neither side waits forever on the other: a producer that fails calls
+  csvshm_abort(), and a side that is waiting notices within a fraction
+  of a second if the process on the other side has exited.
+
+  General usage for the producer:
+
+     csvshm_create()
+         csvshm_reserve()
+         csvshm_commit()
+         ...
+         csvshm_finish() / csvshm_abort()
+     csvshm_close()
+
+  and for the consumer:
+
+     csvshm_attach() / csvshm_attach_fd()
+         csvshm_get()
+         csvshm_release()
+         ...
+     csvshm_close()
+
+*/
+
+#include "csv.h"
+
+typedef struct csvshm_t csvshm_t;
+
+/**
+ * Create a ring that holds up to size bytes of batches. Returns NULL
+ * on error, with errno set. The shm object is removed by the consumer
+ * once it attaches.
+ */
+CSV_EXTERN csvshm_t *csvshm_create(const char *name, int64_t size);
+
+/**
+ * Attach to the ring of a producer. Waits up to timeout_ms for the
+ * producer to create it. Returns NULL on error, with errno set.
+ */
+CSV_EXTERN csvshm_t *csvshm_attach(const char *name, int timeout_ms);
+CSV_EXTERN csvshm_t *csvshm_attach_fd(int fd);
+
+/**
+ * Get the fd of the shm object.
+ */
+CSV_EXTERN int csvshm_fd(csvshm_t *shm);
+
+/**
+ * Unmap the ring and release the handle.
+ */
+CSV_EXTERN void csvshm_close(csvshm_t *shm);
+
+/**
+ * Get the largest batch that the ring takes.
+ */
+CSV_EXTERN int csvshm_maxbatch(csvshm_t *shm);
+
+/**
+ * Producer: get room for a batch of up to n bytes, waiting for the
+ * consumer to free up space if needed. Returns NULL with errno set to
+ * EINVAL if n is bigger than csvshm_maxbatch(), or to EPIPE if the
+ * consumer has exited.
+ */
+CSV_EXTERN char *csvshm_reserve(csvshm_t *shm, int n);
+
+/**
+ * Producer: publish the first n bytes of the space from the last
+ * csvshm_reserve() as a batch.
+ */
+CSV_EXTERN void csvshm_commit(csvshm_t *shm, int n);
+
+/**
+ * Producer: tell the consumer that there are no more batches.
+ */
+CSV_EXTERN void csvshm_finish(csvshm_t *shm);
+
+/**
+ * Producer: tell the consumer that the producer has failed, and remove
+ * the shm object if the consumer has not attached yet.
+ */
+CSV_EXTERN void csvshm_abort(csvshm_t *shm);
+
+/**
+ * Consumer: wait for the next batch. Returns the #bytes in the batch,
+ * 0 if the producer has finished, or -1 with errno set to ECANCELED if
+ * the producer has aborted, or to EPIPE if it exited without
+ * finishing. The batch stays valid until csvshm_release().
+ */
+CSV_EXTERN int csvshm_get(csvshm_t *shm, const char **batch);
+
+/**
+ * Consumer: give back the space of the batch from the last
+ * csvshm_get().
+ */
+CSV_EXTERN void csvshm_release(csvshm_t *shm);
+
+#endif /*CSVSHM_H*/
@@ -0,0 +1,166 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#define _GNU_SOURCE
+#include "csvside.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void csvside_seterr(char *errbuf, int errbufsz, const char *fmt, ...) {
+  if (errbufsz > 0) {
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(errbuf, errbufsz, fmt, ap);
+    va_end(ap);
+  }
+}
+
+int csvside_identity(csvside_id_t *id, const char magic[8], int fd, int qte,
+                     int esc, int delim, const char *nullstr) {
+  struct stat st;
+  if (fstat(fd, &st)) {
+    return -1;
+  }
+  memset(id, 0, sizeof(*id));
+  memcpy(id->magic, magic, 8);
+  id->fsize = st.st_size;
+  id->mtime_sec = st.st_mtim.tv_sec;
+  id->mtime_nsec = st.st_mtim.tv_nsec;
+  id->ino = st.st_ino;
+  id->dev = st.st_dev;
+  id->qte = qte ? qte : '"';
+  id->esc = esc ? esc : id->qte;
+  id->delim = delim ? delim : ',';
+  if (nullstr) {
+    strncpy(id->nullstr, nullstr, sizeof(id->nullstr) - 1);
+  }
+  return 0;
+}
+
+int csvside_match(const csvside_id_t *a, const csvside_id_t *b) {
+  return 0 == memcmp(a, b, sizeof(*a));
+}
+
+void *csvside_map(const char *path, int64_t minsz, int64_t *size) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return 0;
+  }
+  struct stat st;
+  void *p = MAP_FAILED;
+  if (0 == fstat(fd, &st) && st.st_size >= minsz && st.st_size > 0) {
+    p = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (p == MAP_FAILED) {
+    return 0;
+  }
+  *size = st.st_size;
+  return p;
+}
+
+int csvside_save(const char *path, const void *data, int64_t size) {
+  char tmp[strlen(path) + 32];
+  sprintf(tmp, "%s.%d", path, (int)getpid());
+  int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return -1;
+  }
+  const char *p = data;
+  int64_t n = size;
+  while (n > 0) {
+    ssize_t nb = write(fd, p, n < CSV_WINDOW ? n : CSV_WINDOW);
+    if (nb < 0 && errno == EINTR) {
+      continue;
+    }
+    if (nb <= 0) {
+      break;
+    }
+    p += nb;
+    n -= nb;
+  }
+  if (close(fd) || n != 0 || rename(tmp, path)) {
+    unlink(tmp);
+    return -1;
+  }
+  return 0;
+}
+
+int csvside_scan_open(csvside_scan_t *sc, int fd, const char *data,
+                      int64_t datasz, char *errbuf, int errbufsz) {
+  memset(sc, 0, sizeof(*sc));
+  sc->data = data;
+  sc->datasz = datasz;
+  if (fd >= 0 && datasz > 0) {
+    void *p = mmap(0, datasz, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+      csvside_seterr(errbuf, errbufsz, "mmap - %s", strerror(errno));
+      return -1;
+    }
+    madvise(p, datasz, MADV_SEQUENTIAL);
+    sc->data = p;
+    sc->mapped = 1;
+  }
+  return 0;
+}
+
+int csvside_scan_next(csvside_scan_t *sc, csv_parse_t *cp, const char **row,
+                      char *errbuf, int errbufsz) {
+  if (sc->pos >= sc->datasz) {
+    return 0;
+  }
+  const int64_t rem = sc->datasz - sc->pos;
+  const int bufsz = rem < CSV_WINDOW ? rem : CSV_WINDOW;
+  const char *buf = sc->data + sc->pos;
+  int nb = csv_line(cp, buf, bufsz);
+  if (nb == 0 && bufsz == rem) {
+    /* the last row has no newline; parse a copy with one */
+    if (!(sc->tail = malloc(rem + 1))) {
+      csvside_seterr(errbuf, errbufsz, "out of memory");
+      return -1;
+    }
+    memcpy(sc->tail, buf, rem);
+    sc->tail[rem] = '\n';
+    buf = sc->tail;
+    nb = csv_line(cp, buf, rem + 1);
+    if (nb == 0) {
+      csvside_seterr(errbuf, errbufsz, "unterminated quote at end of file");
+      return -1;
+    }
+    nb = nb > rem ? rem : nb;
+  }
+  if (nb <= 0) {
+    csvside_seterr(errbuf, errbufsz, "%s",
+                   nb < 0 ? csv_errmsg(cp) : "row too long");
+    return -1;
+  }
+  *row = buf;
+  sc->off = sc->pos;
+  sc->pos += nb;
+  sc->rownum++;
+  return nb;
+}
+
+void csvside_scan_close(csvside_scan_t *sc) {
+  if (sc->mapped) {
+    munmap((void *)sc->data, sc->datasz);
+  }
+  free(sc->tail);
+  memset(sc, 0, sizeof(*sc));
+}
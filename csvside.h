@@ -0,0 +1,131 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#ifndef CSVSIDE_H
+#define CSVSIDE_H
+
+/*
+
+  Helpers for the sidecar files that csvidx, csvbloom, csvzone, csvbmp
+  and csvcache keep next to a csv file FILE.
+
+  Each sidecar starts with a csvside_id_t, which records the size,
+  mtime, inode and device of FILE and the dialect it was parsed with.
+  A sidecar is used only if its id matches the one of FILE now;
+  otherwise it is rebuilt by scanning FILE, and saved under a temp name
+  that is then renamed over the old one, so that a reader never sees a
+  half-written sidecar.
+
+  General usage:
+
+     csvside_identity()
+     csvside_map() and csvside_match(), or
+         csvside_scan_open()
+             csvside_scan_next()
+             ...
+         csvside_scan_close()
+         csvside_save()
+
+*/
+
+#include "csv.h"
+
+/* the first part of the header of every sidecar */
+typedef struct csvside_id_t csvside_id_t;
+struct csvside_id_t {
+  char magic[8];
+  /* identity of the csv file */
+  int64_t fsize;
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+  int64_t ino;
+  int64_t dev;
+  /* dialect */
+  int32_t qte, esc, delim;
+  char nullstr[20];
+};
+
+/* a scan of the rows of a csv file */
+typedef struct csvside_scan_t csvside_scan_t;
+struct csvside_scan_t {
+  const char *data; /* the csv file */
+  int64_t datasz;
+  int64_t pos;    /* offset of the next row */
+  int64_t off;    /* offset of the row last read */
+  int64_t rownum; /* num rows read */
+  char *tail;     /* copy of a last row that has no newline */
+  int mapped;     /* data is mmap'ed by csvside_scan_open() */
+};
+
+/**
+ * Put message in errbuf[0..errbufsz).
+ */
+CSV_EXTERN void csvside_seterr(char *errbuf, int errbufsz, const char *fmt,
+                               ...);
+
+/**
+ * Fill in id for the csv file open in fd, read with the dialect qte,
+ * esc, delim and nullstr, with the defaults of csv_open() applied. A
+ * NULL nullstr is not recorded. Returns 0 on success, or -1 with errno
+ * set.
+ */
+CSV_EXTERN int csvside_identity(csvside_id_t *id, const char magic[8],
+                                int fd, int qte, int esc, int delim,
+                                const char *nullstr);
+
+/**
+ * Check if the ids of two sidecars are the same.
+ */
+CSV_EXTERN int csvside_match(const csvside_id_t *a, const csvside_id_t *b);
+
+/**
+ * Map the sidecar at path read-only, if it has at least minsz bytes.
+ * Returns the mapping, of *size bytes, or NULL. Release it with
+ * munmap().
+ */
+CSV_EXTERN void *csvside_map(const char *path, int64_t minsz,
+                             int64_t *size);
+
+/**
+ * Write data[0..size) into the sidecar at path atomically. Failure is
+ * not an error, since the sidecar is only a cache; returns 0 if it was
+ * saved, -1 otherwise.
+ */
+CSV_EXTERN int csvside_save(const char *path, const void *data,
+                            int64_t size);
+
+/**
+ * Start a scan of the csv file of datasz bytes open in fd, which is
+ * mapped for the scan, or of data[0..datasz) already in memory if fd
+ * is negative. Returns 0 on success, -1 on error with a message in
+ * errbuf[0..errbufsz).
+ */
+CSV_EXTERN int csvside_scan_open(csvside_scan_t *sc, int fd,
+                                 const char *data, int64_t datasz,
+                                 char *errbuf, int errbufsz);
+
+/**
+ * Parse the next row with csv_line(cp). Returns the #bytes in the row,
+ * whose start is returned in row and whose offset is in off, 0 at the
+ * end of the file, or -1 on error with a message in errbuf[0..errbufsz).
+ * A last row without a newline is parsed from a copy that has one.
+ */
+CSV_EXTERN int csvside_scan_next(csvside_scan_t *sc, csv_parse_t *cp,
+                                 const char **row, char *errbuf,
+                                 int errbufsz);
+
+/**
+ * Finish the scan.
+ */
+CSV_EXTERN void csvside_scan_close(csvside_scan_t *sc);
+
+#endif /*CSVSIDE_H*/
@@ -12,7 +12,7 @@
 */
 
 const char *usagestr = "\n\
-  USAGE: %s [-h] [-d delim] [-q quote] [-e esc] [-n nullstr] [FILE]\n\
+  USAGE: %s [-h] [-C] [-d delim] [-q quote] [-e esc] [-n nullstr] [FILE]\n\
                         \n\
                         \n\
   Print a csv file in a format that can be read into a \n\
@@ -35,11 +35,13 @@ const char *usagestr = "\n\
       -q quote   : specify quote char; default to double-quote           \n\
       -e esc     : specify escape char; default to the quote char        \n\
       -n nullstr : specify string representing null; default to \"\"     \n\
+      -C         : read FILE through its parse cache FILE.csvcache       \n\
       \n\
 ";
 
 #define _GNU_SOURCE
 #include "csv.h"
+#include "csvcache.h"
 #include <errno.h>
 #include <inttypes.h>
 #include <stdio.h>
@@ -53,6 +55,7 @@ int qte = '"';
 int esc = '"';
 int delim = ',';
 char nullstr[20] = {0};
+int usecache = 0;
 
 #define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
 #define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
@@ -75,7 +78,7 @@ void parse_cmdline(int argc, char *const *argv) {
   int opt;
   char *q, *e, *d, *n;
   q = e = d = n = 0;
-  while ((opt = getopt(argc, argv, "d:q:e:n:h")) != -1) {
+  while ((opt = getopt(argc, argv, "d:q:e:n:Ch")) != -1) {
     switch (opt) {
     case 'd':
       d = optarg;
@@ -89,6 +92,9 @@ void parse_cmdline(int argc, char *const *argv) {
     case 'n':
       n = optarg;
       break;
+    case 'C':
+      usecache = 1;
+      break;
     case 'h':
       usage(0, 0);
       break;
@@ -105,6 +111,8 @@ void parse_cmdline(int argc, char *const *argv) {
     fname = argv[optind];
   else
     usage(1, "Error: please supply only one filename");
+  if (usecache && !fname)
+    usage(1, "Error: -C needs a FILE");
 
   /* qte */
   if (q) {
@@ -183,19 +191,37 @@ void do_error(intptr_t handle, int errtype, const char *errmsg,
   fatal("ERROR: %s\n", csv_errmsg(cp));
 }
 
+/* scan fname through its parse cache */
+static void scan_cache(void) {
+  char errmsg[200];
+  csvcache_t *cache =
+      csvcache_open(fname, qte, esc, delim, nullstr, errmsg, sizeof(errmsg));
+  if (!cache) {
+    fatal("ERROR: %s\n", errmsg);
+  }
+  csvcache_data(cache, &tot.nbytes);
+  if (csvcache_scan(cache, 0, 0, 0, do_row)) {
+    fatal("ERROR: out of memory\n");
+  }
+  csvcache_close(cache);
+}
+
 int main(int argc, char *argv[]) {
   parse_cmdline(argc, argv);
   FILE *fp = stdin;
 
-  if (fname && !(fp = fopen(fname, "r"))) {
-    perr("ERROR: fopen %s - %s\n", fname, strerror(errno));
-    exit(1);
+  if (usecache) {
+    scan_cache();
+  } else {
+    if (fname && !(fp = fopen(fname, "r"))) {
+      perr("ERROR: fopen %s - %s\n", fname, strerror(errno));
+      exit(1);
+    }
+    csv_scan((intptr_t)fp, qte, esc, delim, nullstr, do_read, do_row,
+             do_error);
+    fclose(fp);
   }
 
-  csv_scan((intptr_t)fp, qte, esc, delim, nullstr, do_read, do_row, do_error);
-
-  fclose(fp);
-
   printf("      #bytes: %" PRId64 "\n", tot.nbytes);
   printf("       #rows: %" PRId64 "\n", tot.nrows);
   printf("    #columns: ");
@@ -0,0 +1,221 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#include "csvsync.h"
+
+#define TAILWIN (64 * 1024) /* first window of csvsync_backward() */
+
+/* one guess of the quote state, followed through the data */
+typedef struct case_t case_t;
+struct case_t {
+  int64_t i;     /* next byte to look at */
+  int64_t first; /* start of the first row found, or -1 */
+  int in;        /* inside quotes */
+  int ok;        /* no contradiction found */
+  int nrow;      /* num good complete rows */
+  int nfield;    /* num fields so far in the current row */
+};
+
+typedef struct dialect_t dialect_t;
+struct dialect_t {
+  const char *data;
+  int64_t datasz;
+  int qte, esc, delim, ncol;
+};
+
+/* follow case c up to stop, or past the next newline */
+static void run(case_t *c, const dialect_t *d, int64_t stop) {
+  const char *const data = d->data;
+  int64_t i = c->i;
+  for (; i < stop && c->ok; i++) {
+    const int ch = data[i];
+    if (c->in) {
+      if (ch == d->esc && d->esc != d->qte) {
+        i++; /* skip the escaped char */
+        continue;
+      }
+      if (ch == '\n') {
+        i++;
+        break; /* let the other case catch up */
+      }
+      if (ch != d->qte) {
+        continue;
+      }
+      const int next = i + 1 < d->datasz ? data[i + 1] : '\n';
+      if (next == d->qte && d->esc == d->qte) {
+        i++; /* an escaped quote */
+        continue;
+      }
+      /* a closing quote must end the field */
+      c->ok = (next == d->delim || next == '\n' || next == '\r');
+      c->in = 0;
+      continue;
+    }
+
+    if (ch == d->delim) {
+      c->nfield++;
+    } else if (ch == '\n') {
+      if (c->first < 0) {
+        c->first = i + 1;
+      } else if (d->ncol <= 0 || c->nfield == d->ncol) {
+        c->nrow++;
+      } else {
+        c->ok = 0;
+      }
+      c->nfield = 1;
+      i++;
+      break;
+    } else if (ch == d->qte) {
+      /* an opening quote must start the field */
+      const int prev = i > 0 ? data[i - 1] : '\n';
+      c->ok = (prev == d->delim || prev == '\n');
+      c->in = 1;
+    }
+  }
+  c->i = i;
+
+  if (c->i >= d->datasz && c->ok) {
+    /* the data must not end inside quotes */
+    c->ok = !c->in;
+    c->first = c->first < 0 ? d->datasz : c->first;
+  }
+}
+
+/* find the first row at or after pos, 0 < pos < d->datasz, looking at
+ * up to maxscan bytes. A case is accepted early once it has confirm
+ * good rows and the other has none, unless confirm is 0. */
+static int64_t sync(const dialect_t *d, int64_t pos, int confirm,
+                    int64_t maxscan) {
+  const char *const data = d->data;
+  const int64_t datasz = d->datasz;
+  const int qte = d->qte;
+  const int esc = d->esc;
+
+  /* start at the byte before pos, which is a newline if pos starts a
+   * row. A quote there may be half of an escaped quote, which would
+   * throw both cases off, so start after a run of quotes and escapes. */
+  int64_t start = pos - 1;
+  while (start < datasz &&
+         (data[start] == qte ||
+          (esc != qte && start > 0 && data[start - 1] == esc))) {
+    start++;
+  }
+  case_t c[2] = {{start, -1, 0, 1, 0, 1}, {start, -1, 1, 1, 0, 1}};
+  const int64_t limit = datasz - pos < maxscan ? datasz : pos + maxscan;
+
+  /* advance the case that is behind by one row at a time, so that the
+   * decision is made as soon as the rows allow it */
+  for (;;) {
+    case_t *x = 0;
+    for (int k = 0; k < 2; k++) {
+      if (c[k].ok && c[k].i < limit && (!x || c[k].i < x->i)) {
+        x = &c[k];
+      }
+    }
+    if (!x) {
+      return -1;
+    }
+    run(x, d, limit);
+
+    if (!c[0].ok && !c[1].ok) {
+      return -1;
+    }
+    for (int k = 0; k < 2; k++) {
+      x = &c[k];
+      const case_t *y = &c[1 - k];
+      if (x->ok && x->first >= 0 &&
+          (!y->ok || (confirm && x->nrow >= confirm && y->nrow == 0))) {
+        return x->first;
+      }
+    }
+  }
+}
+
+int64_t csvsync_forward(const char *data, int64_t datasz, int64_t pos,
+                        int qte, int esc, int delim, int ncol) {
+  if (pos <= 0) {
+    return 0;
+  }
+  if (pos >= datasz) {
+    return datasz;
+  }
+  qte = qte ? qte : '"';
+  esc = esc ? esc : qte;
+  delim = delim ? delim : ',';
+  const dialect_t d = {data, datasz, qte, esc, delim, ncol};
+  return sync(&d, pos, CSVSYNC_CONFIRM, CSVSYNC_MAXSCAN);
+}
+
+/* the num rows that start in data[pos..datasz), where pos starts a row;
+ * if skip >= 0, return the offset of row skip instead */
+static int64_t count_rows(const dialect_t *d, int64_t pos, int64_t skip) {
+  const char *const data = d->data;
+  int64_t n = 0;
+  int in = 0;
+  for (int64_t i = pos; i < d->datasz; i++) {
+    const int ch = data[i];
+    if (in) {
+      if (ch == d->esc && d->esc != d->qte) {
+        i++;
+      } else if (ch == d->qte) {
+        in = 0;
+      }
+    } else if (ch == d->qte) {
+      in = 1;
+    } else if (ch == '\n') {
+      if (n++ == skip) {
+        return pos;
+      }
+      pos = i + 1;
+    }
+  }
+  if (pos < d->datasz && n++ == skip) {
+    return pos;
+  }
+  return skip >= 0 ? d->datasz : n;
+}
+
+int64_t csvsync_backward(const char *data, int64_t datasz, int64_t nrow,
+                         int qte, int esc, int delim, int ncol) {
+  if (nrow <= 0) {
+    return datasz;
+  }
+  qte = qte ? qte : '"';
+  esc = esc ? esc : qte;
+  delim = delim ? delim : ',';
+  const dialect_t d = {data, datasz, qte, esc, delim, ncol};
+
+  for (int64_t win = TAILWIN;; win *= 2) {
+    const int64_t ws = datasz > win ? datasz - win : 0;
+    /* the first row in the window; a newline just before ws is missed,
+     * but the row it ends is found when the window grows. The window
+     * ends at EOF, so both cases are run to it rather than accepted
+     * early: a long quoted field may look like rows in the wrong case,
+     * but that case cannot also end outside quotes at EOF. */
+    int64_t pos = 0;
+    if (ws > 0) {
+      const dialect_t wd = {data + ws, datasz - ws, qte, esc, delim, ncol};
+      pos = sync(&wd, 1, 0, wd.datasz);
+      if (pos < 0) {
+        continue; /* not sure of the quote state; look further back */
+      }
+      pos += ws;
+    }
+    const int64_t n = count_rows(&d, pos, -1);
+    if (n >= nrow) {
+      return n == nrow ? pos : count_rows(&d, pos, n - nrow);
+    }
+    if (ws == 0) {
+      return 0;
+    }
+  }
+}
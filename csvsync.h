@@ -0,0 +1,70 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#ifndef CSVSYNC_H
+#define CSVSYNC_H
+
+/*
+
+  Find row boundaries from an arbitrary byte offset in a csv file,
+  without parsing it from the beginning. A newline ends a row only if
+  it is not inside quotes, and whether an offset is inside quotes is
+  not known, so both cases are followed at once from the offset:
+
+    - a quote that opens a quoted field must follow a delim or a
+      newline, and one that closes it must be followed by a delim, a
+      newline or another quote. A case that breaks this is dropped.
+
+    - if the num columns is known, every complete row of a case must
+      have that many fields. A case that breaks this is dropped.
+
+  The scan stops when one case is dropped, or when one case has read
+  CSVSYNC_CONFIRM good rows while the other has read none. This is a
+  heuristic: a file that is not well formed, or a quoted field that
+  looks like many rows, may lead it astray.
+
+  To find the last rows of a file, csvsync_backward() looks at a window
+  at the end of the data, finds the first row in it as above, but with
+  both cases run to the end of the data instead of accepted early, and
+  counts the rows from there; if there are too few, or the quote state
+  could not be told, it doubles the window and tries again. Only the
+  last few blocks of a large file are looked at.
+
+*/
+
+#include "csv.h"
+
+#define CSVSYNC_CONFIRM 4        /* good rows to accept a case */
+#define CSVSYNC_MAXSCAN (1 << 24) /* max bytes looked at */
+
+/**
+ * Find the start of the first row at or after pos in data[0..datasz).
+ * If ncol > 0, rows are expected to have ncol fields. Params qte and
+ * esc are as in csv_open(). Returns the offset, or datasz if no row
+ * starts at or after pos, or -1 if the quote state could not be told
+ * within CSVSYNC_MAXSCAN bytes.
+ */
+CSV_EXTERN int64_t csvsync_forward(const char *data, int64_t datasz,
+                                   int64_t pos, int qte, int esc, int delim,
+                                   int ncol);
+
+/**
+ * Find the start of the last nrow rows in data[0..datasz). A last row
+ * without a newline counts as a row. If ncol > 0, rows are expected to
+ * have ncol fields. Params qte and esc are as in csv_open(). Returns the
+ * offset, which is 0 if there are nrow rows or fewer.
+ */
+CSV_EXTERN int64_t csvsync_backward(const char *data, int64_t datasz,
+                                    int64_t nrow, int qte, int esc,
+                                    int delim, int ncol);
+
+#endif /*CSVSYNC_H*/
@@ -0,0 +1,191 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+const char *usagestr = "\n\
+  USAGE: %s [-h] [-H] [-n rows] [-d delim] [-q quote] [-e esc] FILE\n\
+                        \n\
+                        \n\
+  Print the last rows of a csv file as they are in the file. Unlike\n\
+  tail -n, a newline inside a quoted field does not end a row. The file\n\
+  is read backward from the end in growing windows, and the row\n\
+  boundaries in a window are found with csvsync_backward(), so only the\n\
+  last few blocks of a large file are read.\n\
+                        \n\
+  OPTIONS:              \n\
+                        \n\
+      -h         : print this message          \n\
+      -H         : print the header row first                            \n\
+      -n rows    : specify num rows; default to 10                       \n\
+      -d delim   : specify delim char; default to comma                  \n\
+      -q quote   : specify quote char; default to double-quote           \n\
+      -e esc     : specify escape char; default to the quote char        \n\
+      \n\
+";
+
+#define _GNU_SOURCE
+#include "csv.h"
+#include "csvsync.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char *pname = 0;
+const char *fname = 0;
+int64_t nrow = 10;
+int header = 0;
+int qte = '"';
+int esc = 0;
+int delim = ',';
+
+#define perr(M, ...) fprintf(stderr, M, ##__VA_ARGS__)
+#define pout(M, ...) fprintf(stdout, M, ##__VA_ARGS__)
+#define fatal(M, ...)                                                          \
+  do {                                                                         \
+    fprintf(stderr, M, ##__VA_ARGS__);                                         \
+    exit(1);                                                                   \
+  } while (0)
+
+void usage(int exitcode, const char *msg) {
+  perr(usagestr, pname);
+  if (msg) {
+    perr("\n%s\n", msg);
+  }
+  exit(exitcode);
+}
+
+void parse_cmdline(int argc, char *const *argv) {
+  pname = argv[0];
+  int opt;
+  char *q, *e, *d;
+  q = e = d = 0;
+  while ((opt = getopt(argc, argv, "d:q:e:n:Hh")) != -1) {
+    switch (opt) {
+    case 'd':
+      d = optarg;
+      break;
+    case 'q':
+      q = optarg;
+      break;
+    case 'e':
+      e = optarg;
+      break;
+    case 'n': {
+      char *end;
+      nrow = strtoll(optarg, &end, 10);
+      if (*end || nrow < 0) {
+        usage(1, "Error: -n rows expects a number.");
+      }
+      break;
+    }
+    case 'H':
+      header = 1;
+      break;
+    case 'h':
+      usage(0, 0);
+      break;
+    default:
+      usage(1, 0);
+      break;
+    }
+  }
+
+  /* fname */
+  if (optind + 1 != argc) {
+    usage(1, "Error: please supply FILE");
+  }
+  fname = argv[optind];
+
+  /* qte */
+  if (q) {
+    if (strlen(q) != 1) {
+      usage(1, "Error: -q quote-char expects a single char.");
+    }
+    qte = q[0];
+  }
+
+  /* esc */
+  esc = qte;
+  if (e) {
+    if (strlen(e) != 1) {
+      usage(1, "Error: -e escape-char expects a single char.");
+    }
+    esc = e[0];
+  }
+
+  /* delim */
+  if (d) {
+    if (strlen(d) != 1) {
+      usage(1, "Error: -d delim-char expects a single char.");
+    }
+    delim = d[0];
+  }
+}
+
+/* write data[0..len), and a newline if it does not end with one */
+static void put_rows(const char *data, int64_t len) {
+  if (len > 0 && (fwrite(data, 1, len, stdout) != (size_t)len ||
+                  (data[len - 1] != '\n' && EOF == putchar('\n')))) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(errno));
+  }
+}
+
+int main(int argc, char *argv[]) {
+  parse_cmdline(argc, argv);
+
+  int fd = open(fname, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st)) {
+    fatal("ERROR: open %s - %s\n", fname, strerror(errno));
+  }
+  const int64_t datasz = st.st_size;
+  if (datasz == 0) {
+    close(fd);
+    return 0;
+  }
+  const char *data = mmap(0, datasz, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    fatal("ERROR: mmap %s - %s\n", fname, strerror(errno));
+  }
+  close(fd);
+  madvise((void *)data, datasz, MADV_RANDOM);
+
+  const int64_t start =
+      csvsync_backward(data, datasz, nrow, qte, esc, delim, 0);
+
+  /* the header row, unless it is among the last rows */
+  if (header && start > 0) {
+    csv_parse_t *cp = csv_open(qte, esc, delim, 0);
+    if (!cp) {
+      fatal("ERROR: out of memory\n");
+    }
+    int nb = csv_line(cp, data, datasz < CSV_WINDOW ? datasz : CSV_WINDOW);
+    if (nb < 0) {
+      fatal("ERROR: %s\n", csv_errmsg(cp));
+    }
+    put_rows(data, nb == 0 || nb > start ? start : nb);
+    csv_close(cp);
+  }
+  put_rows(data + start, datasz - start);
+
+  if (fflush(stdout)) {
+    fatal("ERROR: cannot write to stdout - %s\n", strerror(errno));
+  }
+  munmap((void *)data, datasz);
+  return 0;
+}
@@ -0,0 +1,147 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#define _GNU_SOURCE
+#include "csvwr.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* write p[0..n) to fd, retrying on partial writes */
+static int writeall(csvwr_t *wr, const char *p, int n) {
+  while (n > 0) {
+    ssize_t nb = write(wr->fd, p, n);
+    if (nb < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      wr->err = wr->err ? wr->err : errno;
+      return -1;
+    }
+    p += nb;
+    n -= nb;
+  }
+  return 0;
+}
+
+int csvwr_init(csvwr_t *wr, int fd, int bufsz) {
+  bufsz = bufsz > 0 ? bufsz : 1024 * 1024;
+  memset(wr, 0, sizeof(*wr));
+  if (!(wr->buf = malloc(bufsz))) {
+    wr->err = ENOMEM;
+    return -1;
+  }
+  wr->max = bufsz;
+  wr->fd = fd;
+  return 0;
+}
+
+int csvwr_fini(csvwr_t *wr) {
+  int ret = csvwr_flush(wr);
+  free(wr->buf);
+  wr->buf = 0;
+  wr->top = wr->max = 0;
+  return ret;
+}
+
+int csvwr_flush(csvwr_t *wr) {
+  if (wr->fd < 0 || wr->top == 0) {
+    return wr->err ? -1 : 0;
+  }
+  int ret = writeall(wr, wr->buf, wr->top);
+  wr->top = 0;
+  return ret;
+}
+
+int csvwr_room(csvwr_t *wr, int n) {
+  if (wr->top + n <= wr->max) {
+    return 0;
+  }
+  if (wr->fd >= 0 && csvwr_flush(wr)) {
+    return -1;
+  }
+  if (wr->top + n <= wr->max) {
+    return 0;
+  }
+
+  /* expand buf[] */
+  int64_t max = wr->max;
+  while (max < (int64_t)wr->top + n) {
+    max = max * 1.5 + 64;
+  }
+  if (max > INT32_MAX) {
+    wr->err = wr->err ? wr->err : ENOMEM;
+    return -1;
+  }
+  char *xp = realloc(wr->buf, max);
+  if (!xp) {
+    wr->err = wr->err ? wr->err : ENOMEM;
+    return -1;
+  }
+  wr->buf = xp;
+  wr->max = max;
+  return 0;
+}
+
+int csvwr_write_slow(csvwr_t *wr, const void *p, int n) {
+  /* big writes to fd go out directly without a copy */
+  if (wr->fd >= 0 && n >= wr->max / 2) {
+    return csvwr_flush(wr) || writeall(wr, p, n) ? -1 : 0;
+  }
+  if (csvwr_room(wr, n)) {
+    return -1;
+  }
+  memcpy(wr->buf + wr->top, p, n);
+  wr->top += n;
+  return 0;
+}
+
+int csvwr_must_quote(const csvwr_dialect_t *d, const char *s, int len) {
+  if (len == 0 || (len == d->nullsz && 0 == memcmp(s, d->nullstr, len))) {
+    return 1; /* would read back as NULL */
+  }
+  for (int i = 0; i < len; i++) {
+    const int ch = s[i];
+    if (ch == d->delim || ch == d->qte || ch == d->esc || ch == '\n' ||
+        ch == '\r') {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int csvwr_value(csvwr_t *wr, const csvwr_dialect_t *d, const char *s,
+                int len) {
+  if (!s) {
+    return csvwr_write(wr, d->nullstr, d->nullsz);
+  }
+  if (!csvwr_must_quote(d, s, len)) {
+    return csvwr_write(wr, s, len);
+  }
+
+  /* copy the runs between quote and escape chars, escaping those */
+  const char *const q = s + len;
+  csvwr_putc(wr, d->qte);
+  while (s < q) {
+    const char *p = s;
+    while (p < q && *p != d->qte && *p != d->esc) {
+      p++;
+    }
+    csvwr_write(wr, s, p - s);
+    if (p < q) {
+      csvwr_putc(wr, d->esc);
+      csvwr_putc(wr, *p++);
+    }
+    s = p;
+  }
+  return csvwr_putc(wr, d->qte) || wr->err ? -1 : 0;
+}
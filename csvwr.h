@@ -0,0 +1,126 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#ifndef CSVWR_H
+#define CSVWR_H
+
+/*
+
+  A simple buffered writer for the csv tools. Bytes are accumulated
+  in buf[] and written out to fd whenever buf[] fills up.
+
+  If fd is -1, the writer is an in-memory buffer that grows as needed
+  and is never flushed. The caller takes the bytes from buf[0..top)
+  and may call csvwr_reset() to reuse the buffer.
+
+  General usage:
+
+     csvwr_init()
+         csvwr_write() / csvwr_putc() / csvwr_puts() / csvwr_value()
+         ...
+         csvwr_flush()
+         csvwr_fini()
+
+  csvwr_value() writes a value as a csv field in the dialect given by a
+  csvwr_dialect_t, quoted only if it would not read back the same.
+
+*/
+
+#include "csv.h"
+#include <string.h>
+
+typedef struct csvwr_t csvwr_t;
+struct csvwr_t {
+  char *buf; /* buf[] - output buffer */
+  int top;   /* num used bytes in buf[] */
+  int max;   /* num allocated bytes in buf[] */
+  int fd;    /* output file descriptor; -1 for in-memory buffer */
+  int err;   /* errno of the first failed write or alloc, else 0 */
+};
+
+typedef struct csvwr_dialect_t csvwr_dialect_t;
+struct csvwr_dialect_t {
+  int qte;             /* quote char */
+  int esc;             /* escape char; same as qte to double quotes */
+  int delim;           /* delim char */
+  const char *nullstr; /* written for NULL */
+  int nullsz;          /* strlen(nullstr) */
+};
+
+/**
+ * Initialize a writer. Returns 0 on success, -1 on out-of-memory error.
+ * For bufsz that is 0, it assumes a default of 1MB.
+ */
+CSV_EXTERN int csvwr_init(csvwr_t *wr, int fd, int bufsz);
+
+/**
+ * Flush and release the writer. Returns 0 on success, -1 on error.
+ */
+CSV_EXTERN int csvwr_fini(csvwr_t *wr);
+
+/**
+ * Write out buf[] to fd. This is a noop for in-memory buffers.
+ * Returns 0 on success, -1 on error.
+ */
+CSV_EXTERN int csvwr_flush(csvwr_t *wr);
+
+/**
+ * Make room for n more bytes in buf[] by flushing or expanding it.
+ * Returns 0 on success, -1 on error.
+ */
+CSV_EXTERN int csvwr_room(csvwr_t *wr, int n);
+
+/**
+ * Slow path of csvwr_write(). Large writes bypass buf[] entirely.
+ */
+CSV_EXTERN int csvwr_write_slow(csvwr_t *wr, const void *p, int n);
+
+static inline int csvwr_write(csvwr_t *wr, const void *p, int n) {
+  if (wr->top + n > wr->max) {
+    return csvwr_write_slow(wr, p, n);
+  }
+  memcpy(wr->buf + wr->top, p, n);
+  wr->top += n;
+  return 0;
+}
+
+static inline int csvwr_putc(csvwr_t *wr, int ch) {
+  if (wr->top >= wr->max && csvwr_room(wr, 1)) {
+    return -1;
+  }
+  wr->buf[wr->top++] = ch;
+  return 0;
+}
+
+static inline int csvwr_puts(csvwr_t *wr, const char *s) {
+  return csvwr_write(wr, s, strlen(s));
+}
+
+static inline void csvwr_reset(csvwr_t *wr) { wr->top = 0; }
+
+/**
+ * Check if value s[0..len) must be quoted in dialect d to read back
+ * the same: it holds a delim, quote, escape, CR or LF char, or it is
+ * empty or the nullstr, which would read back as NULL.
+ */
+CSV_EXTERN int csvwr_must_quote(const csvwr_dialect_t *d, const char *s,
+                                int len);
+
+/**
+ * Write value s[0..len) as a field in dialect d, quoted and escaped if
+ * csvwr_must_quote() says so. If s is NULL, write the nullstr. Returns
+ * 0 on success, -1 on error.
+ */
+CSV_EXTERN int csvwr_value(csvwr_t *wr, const csvwr_dialect_t *d,
+                           const char *s, int len);
+
+#endif /*CSVWR_H*/
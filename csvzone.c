@@ -0,0 +1,432 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#define _GNU_SOURCE
+#include "csvzone.h"
+#include "csvnum.h"
+#include "csvside.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define MAGIC "CSVZONE1"
+
+/* the sidecar starts with this header; the zones follow, ncol arrays
+ * of nblock zones */
+typedef struct header_t header_t;
+struct header_t {
+  csvside_id_t id;
+  int32_t unused;
+  int64_t stride;
+  /* shape */
+  int64_t nblock;
+  int32_t ncol;
+  int32_t unused2;
+};
+
+/* the zone of one column in one block */
+typedef struct zone_t zone_t;
+struct zone_t {
+  int32_t nval;  /* num values that are not NULL */
+  int32_t nnull; /* num NULLs */
+  int32_t nnum;  /* num values that are numbers */
+  uint8_t minlen, maxlen;
+  uint8_t maxtrunc; /* max[] is a prefix of the max */
+  uint8_t unused;
+  double nmin, nmax; /* over the values that are numbers */
+  char min[CSVZONE_PREFIX];
+  char max[CSVZONE_PREFIX];
+};
+
+struct csvzone_t {
+  header_t *hdr;
+  int64_t hdrsz; /* num bytes in the sidecar */
+  int mapped;    /* hdr is mmap'ed, else malloc'ed */
+  const zone_t *zone; /* zone[col * nblock + k] */
+  int hit;
+};
+
+static inline int64_t sidecar_size(const header_t *hdr) {
+  return sizeof(header_t) + hdr->nblock * hdr->ncol * sizeof(zone_t);
+}
+
+/* compare a[0..alen) and b[0..blen) as bytes */
+static inline int bytecmp(const char *a, int alen, const char *b, int blen) {
+  int c = memcmp(a, b, alen < blen ? alen : blen);
+  return c ? c : (alen > blen) - (alen < blen);
+}
+
+/* map the sidecar at path if it matches want. Returns 0 on success. */
+static int load_sidecar(csvzone_t *zone, const char *path,
+                        const header_t *want) {
+  int64_t size;
+  header_t *hdr = csvside_map(path, sizeof(header_t), &size);
+  if (!hdr) {
+    return -1;
+  }
+  if (!csvside_match(&hdr->id, &want->id) || hdr->stride != want->stride ||
+      hdr->nblock < 0 || hdr->ncol < 0 || sidecar_size(hdr) != size) {
+    munmap(hdr, size);
+    return -1;
+  }
+
+  zone->hdr = hdr;
+  zone->hdrsz = size;
+  zone->mapped = 1;
+  zone->zone = (const zone_t *)(hdr + 1);
+  return 0;
+}
+
+/* the zones of one column while scanning */
+typedef struct colbuild_t colbuild_t;
+struct colbuild_t {
+  zone_t *zone; /* zone[nblock] */
+  /* the full min and max of the current block */
+  char *min, *max;
+  int minlen, maxlen;
+  int minmax, maxmax; /* num allocated bytes */
+};
+
+typedef struct build_t build_t;
+struct build_t {
+  int64_t nblock;
+  int64_t maxblock; /* num allocated zones per column */
+  int ncol;
+  colbuild_t *col;
+  char *scratch;
+  int scratchmax;
+};
+
+static void build_free(build_t *b) {
+  for (int c = 0; c < b->ncol; c++) {
+    free(b->col[c].zone);
+    free(b->col[c].min);
+    free(b->col[c].max);
+  }
+  free(b->col);
+  free(b->scratch);
+}
+
+/* copy s[0..len) into *buf, growing it as needed */
+static int copy_to(char **buf, int *max, int *buflen, const char *s, int len) {
+  if (len > *max) {
+    int n = len * 1.5 + 16;
+    char *p = realloc(*buf, n);
+    if (!p) {
+      return -1;
+    }
+    *buf = p;
+    *max = n;
+  }
+  memcpy(*buf, s, len);
+  *buflen = len;
+  return 0;
+}
+
+/* finish block k: put the prefixes of min and max, and count NULLs */
+static void finish_block(build_t *b, int64_t k, int nrow) {
+  for (int c = 0; c < b->ncol; c++) {
+    colbuild_t *cb = &b->col[c];
+    zone_t *z = &cb->zone[k];
+    z->nnull = nrow - z->nval;
+    if (z->nval) {
+      z->minlen = cb->minlen < CSVZONE_PREFIX ? cb->minlen : CSVZONE_PREFIX;
+      z->maxlen = cb->maxlen < CSVZONE_PREFIX ? cb->maxlen : CSVZONE_PREFIX;
+      z->maxtrunc = (cb->maxlen > CSVZONE_PREFIX);
+      memcpy(z->min, cb->min, z->minlen);
+      memcpy(z->max, cb->max, z->maxlen);
+    }
+  }
+}
+
+/* make room for the zones of blocks [0, nblock) and columns
+ * [0, ncol) */
+static int grow(build_t *b, int64_t nblock, int ncol) {
+  if (nblock > b->maxblock) {
+    int64_t max = b->maxblock * 1.5 + 16;
+    for (int c = 0; c < b->ncol; c++) {
+      zone_t *p = realloc(b->col[c].zone, max * sizeof(zone_t));
+      if (!p) {
+        return -1;
+      }
+      memset(p + b->maxblock, 0, (max - b->maxblock) * sizeof(zone_t));
+      b->col[c].zone = p;
+    }
+    b->maxblock = max;
+  }
+  if (ncol > b->ncol) {
+    colbuild_t *p = realloc(b->col, ncol * sizeof(*p));
+    if (!p) {
+      return -1;
+    }
+    b->col = p;
+    memset(p + b->ncol, 0, (ncol - b->ncol) * sizeof(*p));
+    for (; b->ncol < ncol; b->ncol++) {
+      /* the column was missing from earlier rows, so they are NULLs */
+      zone_t *z = calloc(b->maxblock, sizeof(zone_t));
+      if (!z) {
+        return -1;
+      }
+      for (int64_t k = 0; k + 1 < b->nblock; k++) {
+        z[k].nnull = b->col[0].zone[k].nnull + b->col[0].zone[k].nval;
+      }
+      b->col[b->ncol].zone = z;
+    }
+  }
+  return 0;
+}
+
+/* add value s[0..len) to the zone of column c in block k */
+static int add_value(build_t *b, int64_t k, int c, const char *s, int len) {
+  colbuild_t *cb = &b->col[c];
+  zone_t *z = &cb->zone[k];
+  double d;
+  if (0 == csvnum_double(s, len, &d)) {
+    if (z->nnum == 0 || d < z->nmin) {
+      z->nmin = d;
+    }
+    if (z->nnum == 0 || d > z->nmax) {
+      z->nmax = d;
+    }
+    z->nnum++;
+  }
+  if (z->nval == 0 || bytecmp(s, len, cb->min, cb->minlen) < 0) {
+    if (copy_to(&cb->min, &cb->minmax, &cb->minlen, s, len)) {
+      return -1;
+    }
+  }
+  if (z->nval == 0 || bytecmp(s, len, cb->max, cb->maxlen) > 0) {
+    if (copy_to(&cb->max, &cb->maxmax, &cb->maxlen, s, len)) {
+      return -1;
+    }
+  }
+  z->nval++;
+  return 0;
+}
+
+/* add the fields of the row last parsed by csv_line() to block k */
+static int add_row(build_t *b, csv_parse_t *cp, int64_t k) {
+  char **field;
+  int *len;
+  char *quoted;
+  const int nfield = csv_rawfields(cp, &field, &len, &quoted);
+  if (grow(b, k + 1, nfield)) {
+    return -1;
+  }
+  for (int c = 0; c < nfield; c++) {
+    if (len[c] >= b->scratchmax) {
+      int max = len[c] * 1.5 + 64;
+      char *p = realloc(b->scratch, max);
+      if (!p) {
+        return -1;
+      }
+      b->scratch = p;
+      b->scratchmax = max;
+    }
+    int n = csv_decode(cp, field[c], len[c], quoted[c], b->scratch);
+    if (n >= 0 && add_value(b, k, c, b->scratch, n)) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* scan the csv file in fd and collect the zones of each block */
+static int scan_file(build_t *b, csv_parse_t *cp, int64_t stride, int fd,
+                     int64_t datasz, char *errbuf, int errbufsz) {
+  csvside_scan_t sc;
+  if (csvside_scan_open(&sc, fd, 0, datasz, errbuf, errbufsz)) {
+    return -1;
+  }
+  const char *row;
+  int nb;
+  while ((nb = csvside_scan_next(&sc, cp, &row, errbuf, errbufsz)) > 0) {
+    const int64_t r = sc.rownum - 1;
+    const int64_t k = r / stride;
+    if (r % stride == 0) {
+      if (k > 0) {
+        finish_block(b, k - 1, stride);
+      }
+      b->nblock = k + 1;
+    }
+    if (add_row(b, cp, k)) {
+      csvside_seterr(errbuf, errbufsz, "out of memory");
+      nb = -1;
+      break;
+    }
+  }
+  if (nb == 0 && sc.rownum > 0) {
+    finish_block(b, b->nblock - 1, sc.rownum - (b->nblock - 1) * stride);
+  }
+
+  csvside_scan_close(&sc);
+  return nb;
+}
+
+/* scan the csv file in fd and lay out the sidecar in memory */
+static int build_sidecar(csvzone_t *zone, int fd, const header_t *want,
+                         char *errbuf, int errbufsz) {
+  const csvside_id_t *id = &want->id;
+  csv_parse_t *cp = csv_open(id->qte, id->esc, id->delim, id->nullstr);
+  if (!cp) {
+    csvside_seterr(errbuf, errbufsz, "out of memory");
+    return -1;
+  }
+
+  build_t b = {0};
+  int ret = scan_file(&b, cp, want->stride, fd, id->fsize, errbuf, errbufsz);
+  csv_close(cp);
+
+  if (ret == 0) {
+    header_t hdr = *want;
+    hdr.nblock = b.nblock;
+    hdr.ncol = b.ncol;
+    zone->hdrsz = sidecar_size(&hdr);
+    if (!(zone->hdr = malloc(zone->hdrsz))) {
+      csvside_seterr(errbuf, errbufsz, "out of memory");
+      ret = -1;
+    } else {
+      *zone->hdr = hdr;
+      zone_t *z = (zone_t *)(zone->hdr + 1);
+      for (int c = 0; c < b.ncol; c++) {
+        memcpy(z + c * b.nblock, b.col[c].zone, b.nblock * sizeof(zone_t));
+      }
+      zone->zone = z;
+    }
+  }
+  build_free(&b);
+  return ret;
+}
+
+csvzone_t *csvzone_open(const char *path, int qte, int esc, int delim,
+                        const char nullstr[20], int64_t stride, char *errbuf,
+                        int errbufsz) {
+  csvzone_t *zone = calloc(1, sizeof(*zone));
+  int fd = -1;
+  char *sidecar = 0;
+  if (!zone || !(sidecar = malloc(strlen(path) + 10))) {
+    csvside_seterr(errbuf, errbufsz, "out of memory");
+    goto bail;
+  }
+  sprintf(sidecar, "%s.csvzone", path);
+  if (stride <= 0) {
+    csvside_seterr(errbuf, errbufsz, "bad stride %" PRId64, stride);
+    goto bail;
+  }
+
+  header_t want;
+  memset(&want, 0, sizeof(want));
+  if ((fd = open(path, O_RDONLY)) < 0 ||
+      csvside_identity(&want.id, MAGIC, fd, qte, esc, delim, nullstr)) {
+    csvside_seterr(errbuf, errbufsz, "open %s - %s", path, strerror(errno));
+    goto bail;
+  }
+  want.stride = stride;
+  if (0 == load_sidecar(zone, sidecar, &want)) {
+    zone->hit = 1;
+  } else {
+    if (build_sidecar(zone, fd, &want, errbuf, errbufsz)) {
+      goto bail;
+    }
+    csvside_save(sidecar, zone->hdr, zone->hdrsz);
+  }
+
+  close(fd);
+  free(sidecar);
+  return zone;
+
+bail:
+  if (fd >= 0) {
+    close(fd);
+  }
+  free(sidecar);
+  csvzone_close(zone);
+  return 0;
+}
+
+void csvzone_close(csvzone_t *zone) {
+  if (!zone) {
+    return;
+  }
+  if (zone->hdr) {
+    if (zone->mapped) {
+      munmap(zone->hdr, zone->hdrsz);
+    } else {
+      free(zone->hdr);
+    }
+  }
+  free(zone);
+}
+
+int csvzone_hit(csvzone_t *zone) { return zone->hit; }
+
+int64_t csvzone_nblock(csvzone_t *zone) { return zone->hdr->nblock; }
+
+int csvzone_ncol(csvzone_t *zone) { return zone->hdr->ncol; }
+
+int64_t csvzone_nnull(csvzone_t *zone, int64_t k, int col) {
+  const header_t *hdr = zone->hdr;
+  if (col < 0 || col >= hdr->ncol) {
+    /* a column missing from every row is all NULLs */
+    const int64_t nrow = hdr->stride;
+    return k < hdr->nblock ? nrow : 0;
+  }
+  return zone->zone[col * hdr->nblock + k].nnull;
+}
+
+int csvzone_test(csvzone_t *zone, int64_t k, int col, const char *lo,
+                 const char *hi, int numeric) {
+  const header_t *hdr = zone->hdr;
+  if (col < 0 || col >= hdr->ncol) {
+    return 0;
+  }
+  const zone_t *z = &zone->zone[col * hdr->nblock + k];
+
+  if (numeric) {
+    double d;
+    if (z->nnum == 0) {
+      return 0;
+    }
+    if (lo && 0 == csvnum_double(lo, strlen(lo), &d) && z->nmax < d) {
+      return 0;
+    }
+    if (hi && 0 == csvnum_double(hi, strlen(hi), &d) && z->nmin > d) {
+      return 0;
+    }
+    return 1;
+  }
+
+  if (z->nval == 0) {
+    return 0;
+  }
+  if (lo) {
+    /* the max must reach lo; a cut max may be longer than it looks */
+    const int lolen = strlen(lo);
+    const int n = z->maxlen < lolen ? z->maxlen : lolen;
+    const int c = memcmp(z->max, lo, n);
+    if (c < 0 || (c == 0 && !z->maxtrunc && z->maxlen < lolen)) {
+      return 0;
+    }
+  }
+  if (hi) {
+    /* the min must not pass hi; a cut min is no larger than the min */
+    if (bytecmp(z->min, z->minlen, hi, strlen(hi)) > 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
@@ -0,0 +1,95 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+#ifndef CSVZONE_H
+#define CSVZONE_H
+
+/*
+
+  A zone map of a csv file: for each block of N rows and each column,
+  the num NULLs, the min and max of the values as bytes, and the min
+  and max of the values that are numbers. It is saved in a sidecar file
+  FILE.csvzone. A scan for a range of values tests each block's zone
+  and parses only the blocks that may hold a match. The blocks are
+  those of the sparse row index with the same N (see csvidx.h), so a
+  block is read with csvidx_read_rows().
+
+  The zones are stored by column, so a test on one column reads only
+  the zones of that column. Missing fields count as NULLs. The byte
+  min and max keep only the first CSVZONE_PREFIX bytes, which is enough
+  to rule most blocks out.
+
+  The sidecar is used only if the size, mtime, inode and device of
+  FILE, the dialect and N are unchanged. Otherwise it is rebuilt.
+
+  General usage:
+
+     csvzone_open()
+         csvzone_test() / csvzone_nnull() for each block
+         ...
+     csvzone_close()
+
+*/
+
+#include "csv.h"
+
+#define CSVZONE_PREFIX 24
+
+typedef struct csvzone_t csvzone_t;
+
+/**
+ * Open the zone map of the csv file at path, with a zone every stride
+ * rows. If there is no valid sidecar, the file is scanned and the
+ * sidecar is saved next to it; if the sidecar cannot be saved, the
+ * zones are kept in memory only.
+ *
+ * Params qte, esc, delim and nullstr are as in csv_open(). Returns NULL
+ * on error, with a message in errbuf[0..errbufsz).
+ */
+CSV_EXTERN csvzone_t *csvzone_open(const char *path, int qte, int esc,
+                                   int delim, const char nullstr[20],
+                                   int64_t stride, char *errbuf,
+                                   int errbufsz);
+
+/**
+ * Release the zone map.
+ */
+CSV_EXTERN void csvzone_close(csvzone_t *zone);
+
+/**
+ * Check if the sidecar was loaded rather than built by csvzone_open().
+ */
+CSV_EXTERN int csvzone_hit(csvzone_t *zone);
+
+/**
+ * Get the num blocks, and the num columns of the widest row.
+ */
+CSV_EXTERN int64_t csvzone_nblock(csvzone_t *zone);
+CSV_EXTERN int csvzone_ncol(csvzone_t *zone);
+
+/**
+ * Check if block k, rows k * stride + 1 to (k + 1) * stride, may have a
+ * value of column col between lo and hi inclusive. A NULL lo or hi
+ * leaves that end open. If numeric is set, the values and bounds are
+ * compared as numbers and values that are not numbers never match;
+ * otherwise they are compared as bytes. Returns 0 if the block surely
+ * has no such value.
+ */
+CSV_EXTERN int csvzone_test(csvzone_t *zone, int64_t k, int col,
+                            const char *lo, const char *hi, int numeric);
+
+/**
+ * Get the num NULLs of column col in block k.
+ */
+CSV_EXTERN int64_t csvzone_nnull(csvzone_t *zone, int64_t k, int col);
+
+#endif /*CSVZONE_H*/
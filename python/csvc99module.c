@@ -0,0 +1,384 @@
+/*
+  CSVC99 - SIMD-accelerated csv parser in C99
+  Copyright (c) 2019-2020 CK Tan
+  cktanx@gmail.com
+
+  CSVC99 can be used for free under the GNU General Public License
+  version 3, where anything released into public must be open source,
+  or under a commercial license. The commercial license does not
+  cover derived or ported versions created by third parties under
+  GPL. To inquire about commercial license, please send email to
+  cktanx@gmail.com.
+*/
+
+/*
+
+  Python binding. The input is read and parsed with the GIL released;
+  the GIL is only held to build the python objects from the parsed
+  fields.
+
+     import csvc99
+     rows = csvc99.read('file.csv')            # [[str|None, ...], ...]
+     cols = csvc99.read_columns('file.csv')    # [[str|None, ...], ...]
+     rows = csvc99.read(b'1,2\n3,4\n', delim='|', nullstr='\\N')
+
+  The first argument is a file path or a bytes-like object holding
+  the csv data. Values are decoded as utf-8 with surrogateescape.
+
+*/
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "../csv.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* the result of a parse: fields of all rows, back to back */
+typedef struct parsed_t parsed_t;
+struct parsed_t {
+  char *buf;        /* input data, modified in place by the parse */
+  Py_ssize_t bufsz;  /* num bytes in buf[] */
+  const char **fld;  /* fld[i] - value of field i */
+  int *len;          /* len[i] - length of field i; -1 for None */
+  Py_ssize_t nfld;   /* num used elements in fld[] and len[] */
+  Py_ssize_t fldmax; /* num allocated elements in fld[] and len[] */
+  int *rowlen;       /* rowlen[r] - num fields in row r */
+  Py_ssize_t nrow;   /* num used elements in rowlen[] */
+  Py_ssize_t rowmax; /* num allocated elements in rowlen[] */
+  int ncol;          /* max num fields in a row */
+
+  int err;          /* errno, or CSV_Exxx on parse error */
+  char errmsg[200]; /* parse error message */
+};
+
+static void parsed_free(parsed_t *pp) {
+  free(pp->buf);
+  free(pp->fld);
+  free(pp->len);
+  free(pp->rowlen);
+}
+
+/* read the whole file into pp->buf. Called without the GIL. */
+static int read_file(parsed_t *pp, const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    pp->err = errno;
+    return -1;
+  }
+
+  Py_ssize_t max = 1024 * 1024;
+  pp->bufsz = 0;
+  for (;;) {
+    /* leave room for a \n at the end */
+    if (!pp->buf || pp->bufsz + 1 >= max) {
+      max = pp->buf ? max * 2 : max;
+      char *xp = realloc(pp->buf, max);
+      if (!xp) {
+        pp->err = ENOMEM;
+        break;
+      }
+      pp->buf = xp;
+    }
+    ssize_t nb = read(fd, pp->buf + pp->bufsz, max - 1 - pp->bufsz);
+    if (nb < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      pp->err = errno;
+      break;
+    }
+    if (nb == 0) {
+      break;
+    }
+    pp->bufsz += nb;
+  }
+
+  close(fd);
+  return pp->err ? -1 : 0;
+}
+
+/* parse pp->buf[] into fields. Called without the GIL. */
+static int parse(parsed_t *pp, int qte, int esc, int delim,
+                 const char *nullstr) {
+  csv_parse_t *cp = csv_open(qte, esc, delim, nullstr);
+  if (!cp) {
+    pp->err = ENOMEM;
+    return -1;
+  }
+
+  /* terminate the last row if it is missing its \n */
+  if (pp->bufsz > 0 && pp->buf[pp->bufsz - 1] != '\n') {
+    pp->buf[pp->bufsz++] = '\n';
+  }
+
+  char *p = pp->buf;
+  char *const q = pp->buf + pp->bufsz;
+  while (p < q) {
+    /* csv_line() takes an int, so give it at most a window at a time */
+    const Py_ssize_t rem = q - p;
+    int nb = csv_line(cp, p, rem < CSV_WINDOW ? rem : CSV_WINDOW);
+    if (nb <= 0) {
+      if (nb < 0) {
+        pp->err = csv_errnum(cp);
+        snprintf(pp->errmsg, sizeof(pp->errmsg), "%s at row %d field %d",
+                 csv_errmsg(cp), csv_errrownum(cp), csv_errfldnum(cp));
+      } else if (rem >= CSV_WINDOW) {
+        pp->err = CSV_EROWTOOLONG;
+        snprintf(pp->errmsg, sizeof(pp->errmsg), "row too long");
+      } else {
+        pp->err = CSV_EEXTRAINPUT;
+        snprintf(pp->errmsg, sizeof(pp->errmsg),
+                 "extra data after last row");
+      }
+      break;
+    }
+
+    char **raw;
+    int *rawlen;
+    char *quoted;
+    int n = csv_rawfields(cp, &raw, &rawlen, &quoted);
+
+    /* make room for one more row of n fields */
+    if (pp->nrow == pp->rowmax) {
+      pp->rowmax = pp->rowmax * 1.5 + 1024;
+      int *xp = realloc(pp->rowlen, pp->rowmax * sizeof(*xp));
+      if (!xp) {
+        pp->err = ENOMEM;
+        break;
+      }
+      pp->rowlen = xp;
+    }
+    if (pp->nfld + n > pp->fldmax) {
+      pp->fldmax = (pp->nfld + n) * 1.5 + 1024;
+      const char **xfld = realloc(pp->fld, pp->fldmax * sizeof(*xfld));
+      if (xfld) {
+        pp->fld = xfld;
+      }
+      int *xlen = realloc(pp->len, pp->fldmax * sizeof(*xlen));
+      if (xlen) {
+        pp->len = xlen;
+      }
+      if (!xfld || !xlen) {
+        pp->err = ENOMEM;
+        break;
+      }
+    }
+
+    /* decode the fields in place */
+    for (int i = 0; i < n; i++) {
+      pp->fld[pp->nfld] = raw[i];
+      pp->len[pp->nfld] =
+          csv_decode(cp, raw[i], rawlen[i], quoted[i], raw[i]);
+      pp->nfld++;
+    }
+    pp->rowlen[pp->nrow++] = n;
+    pp->ncol = n > pp->ncol ? n : pp->ncol;
+    p += nb;
+  }
+
+  csv_close(cp);
+  return pp->err ? -1 : 0;
+}
+
+static PyObject *value(const char *s, int len) {
+  if (len < 0) {
+    Py_RETURN_NONE;
+  }
+  return PyUnicode_DecodeUTF8(s, len, "surrogateescape");
+}
+
+static PyObject *make_rows(parsed_t *pp) {
+  PyObject *rows = PyList_New(pp->nrow);
+  if (!rows) {
+    return 0;
+  }
+  Py_ssize_t k = 0;
+  for (Py_ssize_t r = 0; r < pp->nrow; r++) {
+    PyObject *row = PyList_New(pp->rowlen[r]);
+    if (!row) {
+      Py_DECREF(rows);
+      return 0;
+    }
+    PyList_SET_ITEM(rows, r, row);
+    for (int i = 0; i < pp->rowlen[r]; i++, k++) {
+      PyObject *v = value(pp->fld[k], pp->len[k]);
+      if (!v) {
+        Py_DECREF(rows);
+        return 0;
+      }
+      PyList_SET_ITEM(row, i, v);
+    }
+  }
+  return rows;
+}
+
+static PyObject *make_columns(parsed_t *pp) {
+  PyObject *cols = PyList_New(pp->ncol);
+  if (!cols) {
+    return 0;
+  }
+  for (int i = 0; i < pp->ncol; i++) {
+    PyObject *col = PyList_New(pp->nrow);
+    if (!col) {
+      Py_DECREF(cols);
+      return 0;
+    }
+    PyList_SET_ITEM(cols, i, col);
+  }
+
+  /* rows with fewer fields have None in the missing columns */
+  Py_ssize_t k = 0;
+  for (Py_ssize_t r = 0; r < pp->nrow; r++) {
+    for (int i = 0; i < pp->ncol; i++) {
+      PyObject *v;
+      if (i < pp->rowlen[r]) {
+        v = value(pp->fld[k], pp->len[k]);
+        k++;
+      } else {
+        Py_INCREF(Py_None);
+        v = Py_None;
+      }
+      if (!v) {
+        Py_DECREF(cols);
+        return 0;
+      }
+      PyList_SET_ITEM(PyList_GET_ITEM(cols, i), r, v);
+    }
+  }
+  return cols;
+}
+
+/* get a single char argument; 0 if it is None */
+static int chararg(PyObject *obj, const char *name, int *ret) {
+  *ret = 0;
+  if (!obj || obj == Py_None) {
+    return 0;
+  }
+  Py_ssize_t len;
+  const char *s =
+      PyUnicode_Check(obj) ? PyUnicode_AsUTF8AndSize(obj, &len) : 0;
+  if (!s || len != 1) {
+    PyErr_Format(PyExc_ValueError, "%s expects a single char", name);
+    return -1;
+  }
+  *ret = s[0];
+  return 0;
+}
+
+static PyObject *do_read(PyObject *args, PyObject *kwargs, int columns) {
+  static char *kwlist[] = {"source", "delim",   "quote",
+                           "escape", "nullstr", 0};
+  PyObject *source;
+  PyObject *d = 0, *q = 0, *e = 0;
+  const char *nullstr = "";
+  int delim, qte, esc;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|OOOs", kwlist, &source,
+                                   &d, &q, &e, &nullstr)) {
+    return 0;
+  }
+  if (chararg(d, "delim", &delim) || chararg(q, "quote", &qte) ||
+      chararg(e, "escape", &esc)) {
+    return 0;
+  }
+  if (strlen(nullstr) >= 20) {
+    PyErr_SetString(PyExc_ValueError, "nullstr is too long. max is 19 chars");
+    return 0;
+  }
+
+  parsed_t parsed = {0};
+  parsed_t *pp = &parsed;
+  int ret;
+
+  if (PyObject_CheckBuffer(source)) {
+    /* copy the data; the parse modifies it in place */
+    Py_buffer view;
+    if (PyObject_GetBuffer(source, &view, PyBUF_SIMPLE)) {
+      return 0;
+    }
+    Py_BEGIN_ALLOW_THREADS;
+    pp->bufsz = view.len;
+    if ((pp->buf = malloc(view.len + 1))) {
+      memcpy(pp->buf, view.buf, view.len);
+      ret = parse(pp, qte, esc, delim, nullstr);
+    } else {
+      pp->err = ENOMEM;
+      ret = -1;
+    }
+    Py_END_ALLOW_THREADS;
+    PyBuffer_Release(&view);
+  } else {
+    PyObject *path;
+    if (!PyUnicode_FSConverter(source, &path)) {
+      return 0;
+    }
+    const char *fname = PyBytes_AS_STRING(path);
+    int readerr;
+    Py_BEGIN_ALLOW_THREADS;
+    ret = readerr = read_file(pp, fname);
+    if (ret == 0) {
+      ret = parse(pp, qte, esc, delim, nullstr);
+    }
+    Py_END_ALLOW_THREADS;
+    if (readerr) {
+      errno = pp->err;
+      PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, source);
+      Py_DECREF(path);
+      parsed_free(pp);
+      return 0;
+    }
+    Py_DECREF(path);
+  }
+
+  if (ret) {
+    if (pp->err > 0) {
+      errno = pp->err;
+      PyErr_SetFromErrno(PyExc_OSError);
+    } else {
+      PyErr_SetString(PyExc_ValueError, pp->errmsg);
+    }
+    parsed_free(pp);
+    return 0;
+  }
+
+  PyObject *result = columns ? make_columns(pp) : make_rows(pp);
+  parsed_free(pp);
+  return result;
+}
+
+static PyObject *csvc99_read(PyObject *self, PyObject *args,
+                             PyObject *kwargs) {
+  (void)self;
+  return do_read(args, kwargs, 0);
+}
+
+static PyObject *csvc99_read_columns(PyObject *self, PyObject *args,
+                                     PyObject *kwargs) {
+  (void)self;
+  return do_read(args, kwargs, 1);
+}
+
+static PyMethodDef csvc99_methods[] = {
+    {"read", (PyCFunction)(void (*)(void))csvc99_read,
+     METH_VARARGS | METH_KEYWORDS,
+     "read(source, delim=',', quote='\"', escape=None, nullstr='')\n\n"
+     "Parse csv data from a file path or bytes-like object into a list of\n"
+     "rows. Each row is a list of str, or None for sql NULL."},
+    {"read_columns", (PyCFunction)(void (*)(void))csvc99_read_columns,
+     METH_VARARGS | METH_KEYWORDS,
+     "read_columns(source, delim=',', quote='\"', escape=None, nullstr='')"
+     "\n\n"
+     "Like read(), but return a list of columns. Rows with fewer fields\n"
+     "have None in the missing columns."},
+    {0, 0, 0, 0}};
+
+static struct PyModuleDef csvc99_module = {
+    PyModuleDef_HEAD_INIT, "csvc99", "SIMD-accelerated csv parser", -1,
+    csvc99_methods,        0,        0,                             0,
+    0};
+
+PyMODINIT_FUNC PyInit_csvc99(void) { return PyModule_Create(&csvc99_module); }
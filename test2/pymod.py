@@ -0,0 +1,9 @@
+import sys
+
+import csvc99
+
+with open(sys.argv[2]) as f2:
+    f2 = eval(f2.read())
+
+if csvc99.read(sys.argv[1]) != f2:
+    sys.exit(1)
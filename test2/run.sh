@@ -20,4 +20,10 @@ for i in {1..100}; do
                 { echo '--- csvnorm FAILED ---'; exit 1; }
         python3 $DIR/pydiff.py $OUT $GOOD ||
                 { echo '--- pydiff FAILED ---'; exit 1; }
+
+        # the python module, if built by 'make pymod'
+        if ls $DIR/../csvc99*.so >/dev/null 2>&1; then
+                PYTHONPATH=$DIR/.. python3 $DIR/pymod.py $IN $GOOD ||
+                        { echo '--- pymod FAILED ---'; exit 1; }
+        fi
 done
@@ -0,0 +1,2 @@
+# Test Case : inferred types and NULLs in 3 record batches, stream format
+../csv2arrow -s -b 2 in/csv2arrow-1.csv | od -A d -t x1
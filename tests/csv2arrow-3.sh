@@ -0,0 +1,5 @@
+# Test Case : types inferred from all batches, widened by later rows
+../csv2arrow -b 2 in/csv2arrow-3.csv | tee out/csv2arrow-3.arrow | od -A d -t x1
+
+# Test Case : same file from a pipe
+cat in/csv2arrow-3.csv | ../csv2arrow -b 2 | cmp - out/csv2arrow-3.arrow && echo same
@@ -0,0 +1,2 @@
+# Test Case : binary encoding of quoted, empty, NULL and CRLF fields
+../csv2bin in/csv2bin-1.csv | od -A d -t x1
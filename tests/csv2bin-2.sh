@@ -0,0 +1,2 @@
+# Test Case : round trip into another dialect
+../csv2bin in/csv2bin-1.csv | ../csv2bin -x -d '|' -n '\N'
@@ -0,0 +1,2 @@
+# Test Case : header-named keys and escaping
+../csv2json in/csv2json-1.csv
@@ -0,0 +1,2 @@
+# Test Case : type inference for numbers and bools
+../csv2json -t in/csv2json-1.csv
@@ -0,0 +1,4 @@
+# Test Case : CRLF rows with an empty last field read as NULL, with and without csv_rawfields
+printf 'a,b\r\nx,\r\ny,NULL\r\nz,1\r\n' | ../csv2json -n NULL
+printf 'a,b\r\nx,\r\ny,NULL\r\nz,1\r\n' | ../csvagg -n NULL -H -g b -a count
+printf 'a,b\r\nx,\r\ny,\r\nz,1\r\n' | ../csvagg -H -g b -a count
@@ -0,0 +1,2 @@
+# Test Case : inferred types, NULLs and dictionary pages in 3 row groups
+../csv2parquet -r 2 in/csv2parquet-1.csv | od -A d -t x1
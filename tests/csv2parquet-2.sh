@@ -0,0 +1,7 @@
+# Test Case : types given by -t
+../csv2parquet -t int32,string,float,date,bool in/csv2parquet-1.csv | od -A d -t x1
+
+# Test Case : invalid typed value and extra field
+../csv2parquet -t int32,date,float,date,bool in/csv2parquet-1.csv 2>&1 >/dev/null
+printf 'a,b\n1,2\n3,4,5\n' | ../csv2parquet 2>&1 >/dev/null
+echo
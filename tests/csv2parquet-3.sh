@@ -0,0 +1,5 @@
+# Test Case : types inferred from all row groups, widened by later rows
+../csv2parquet -r 2 in/csv2parquet-3.csv | tee out/csv2parquet-3.pq | od -A d -t x1
+
+# Test Case : same file from a pipe
+cat in/csv2parquet-3.csv | ../csv2parquet -r 2 | cmp - out/csv2parquet-3.pq && echo same
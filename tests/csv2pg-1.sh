@@ -0,0 +1,2 @@
+# Test Case : all fields as text
+../csv2pg -H in/csv2pg-1.csv | od -A d -t x1
@@ -0,0 +1,6 @@
+# Test Case : typed binary fields
+../csv2pg -H -t int8,text,float8,date,bool,int2 in/csv2pg-1.csv | od -A d -t x1
+
+# Test Case : invalid typed value
+../csv2pg -t int4,text,float8,date,bool,int2 in/csv2pg-1.csv 2>&1 >/dev/null
+echo
@@ -0,0 +1,2 @@
+# Test Case : dates in the years 0000 and 0001
+printf '0000-01-01\n0000-02-29\n0000-03-01\n0001-01-01\n1970-01-01\n' | ../csv2pg -t date | od -A d -t x1
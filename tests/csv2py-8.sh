@@ -0,0 +1,11 @@
+# Test Case : write columns to numpy files
+set -e
+
+rm -rf out/npy
+../csv2py -o out/npy in/csv2py-8.csv
+
+for f in out/npy/col{0..2}.npy; do
+	echo "# File: $f"
+	head -c 128 $f | tail -c 118 | tr -s ' '
+	tail -c +129 $f | od -A d -t x1
+done
@@ -0,0 +1,7 @@
+# Test Case : read through the parse cache; the second run loads it
+mkdir -p out/csv2py-9
+cp in/csv2py-3.csv out/csv2py-9/x.csv
+rm -f out/csv2py-9/x.csv.csvcache
+../csv2py -C -e '\' out/csv2py-9/x.csv
+../csv2py -C -e '\' out/csv2py-9/x.csv
+ls out/csv2py-9
@@ -0,0 +1,5 @@
+# Test Case : hand rows over a shm ring to a consumer process
+N=/csvc99-test-$$
+../csv2shm $N in/csv2bin-1.csv &
+../csv2shm -x -d '|' $N
+wait
@@ -0,0 +1,5 @@
+# Test Case : small ring that wraps around and fills up
+N=/csvc99-test-$$
+seq 1 200000 | sed 's/$/,"a,b",/' | ../csv2shm -s 16 -b 1 $N &
+../csv2shm -x $N | awk 'NR % 40000 == 1'
+wait
@@ -0,0 +1,10 @@
+# Test Case : consumer does not hang when the producer fails or is killed
+N=/csvc99-test-$$
+(printf 'a,b\n'; sleep 0.5; printf '1,"x\n') | ../csv2shm $N 2>/dev/null &
+../csv2shm -x $N 2>&1
+wait
+(sleep 1 | ../csv2shm $N 2>/dev/null) 2>/dev/null &
+while [ ! -e /dev/shm$N ]; do sleep 0.05; done
+pkill -9 -f "csv2shm $N\$"
+../csv2shm -x $N 2>&1
+wait
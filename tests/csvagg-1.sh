@@ -0,0 +1,6 @@
+# Test Case : group by names and numbers, all aggregates, NULLs
+../csvagg -g region -a count,count:qty,sum:amount,min:amount,max:amount,avg:amount in/csvagg-1.csv
+echo --
+../csvagg -H -g 1,2 -a count,sum:4 in/csvagg-1.csv
+echo --
+../csvagg -j 3 -a count,sum:qty,max:amount in/csvagg-1.csv
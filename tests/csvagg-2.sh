@@ -0,0 +1,7 @@
+# Test Case : another delim from stdin, and bad args
+printf "k|v\n'a|b'|1\nc|2\n'a|b'|3\n" | ../csvagg -d '|' -q "'" -g k -a sum:v,avg:v
+printf 'a,,c\nx,1,2\n' | ../csvagg -n NULL -H -g 2,a -a sum:c
+../csvagg -g region -a sum:region in/csvagg-1.csv 2>&1
+../csvagg -g nosuch -a count in/csvagg-1.csv 2>&1
+../csvagg -g region -a median:qty in/csvagg-1.csv 2>&1 | tail -1
+echo
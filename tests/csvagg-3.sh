@@ -0,0 +1,9 @@
+# Test Case : input of several chunks, merged from 3 threads
+mkdir -p out/csvagg-3
+awk 'BEGIN { for (i = 0; i < 1200000; i++)
+  printf "%d,k%d,%s,\"v,%d\"\n", i, i % 7, (i % 11 ? i % 1000 / 4 : ""), i }' \
+  > out/csvagg-3/x.csv
+../csvagg -g 2 -a count,sum:1,min:3,max:3,avg:3 out/csvagg-3/x.csv > out/csvagg-3/j1.csv
+../csvagg -j 3 -g 2 -a count,sum:1,min:3,max:3,avg:3 out/csvagg-3/x.csv > out/csvagg-3/j3.csv
+cmp out/csvagg-3/j1.csv out/csvagg-3/j3.csv && cat out/csvagg-3/j3.csv
+rm -f out/csvagg-3/x.csv
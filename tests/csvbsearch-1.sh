@@ -0,0 +1,12 @@
+# Test Case : point and range lookups on a sorted file with quoted newlines
+mkdir -p out/csvbsearch-1
+seq 1 3 6000 | awk '{ printf "%d,\"a \"\"%d\"\"\nb, c\",%s\n", $1, $1, ($1 % 2 ? "odd" : "") }' > out/csvbsearch-1/x.csv
+../csvbsearch -v -N out/csvbsearch-1/x.csv 2998 2>&1
+echo --
+../csvbsearch -N out/csvbsearch-1/x.csv 2999
+echo --
+../csvbsearch -N out/csvbsearch-1/x.csv 4490 4500
+echo --
+../csvbsearch -N out/csvbsearch-1/x.csv 5990 9999
+echo --
+../csvbsearch -N -- out/csvbsearch-1/x.csv -5 4
@@ -0,0 +1,11 @@
+# Test Case : lookups by a named text column, a last row without newline
+../csvbsearch -k city in/csvbsearch-2.csv oslo
+echo --
+../csvbsearch -k city in/csvbsearch-2.csv m 'rome, it'
+echo --
+../csvbsearch -k 1 in/csvbsearch-2.csv zurich
+echo --
+../csvbsearch -k city in/csvbsearch-2.csv ''
+echo --
+../csvbsearch -k nosuch in/csvbsearch-2.csv x 2>&1
+echo
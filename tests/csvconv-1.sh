@@ -0,0 +1,2 @@
+# Test Case : pipe-delimited with backslash escapes into csv
+../csvconv -d '|' -e '\' -n '\N' in/csvconv-1.csv
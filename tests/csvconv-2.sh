@@ -0,0 +1,3 @@
+# Test Case : csv into tsv, and into csv with CRLF and explicit NULL
+../csvconv -D '\t' in/csvconv-2.csv
+../csvconv -r -N NULL in/csvconv-2.csv
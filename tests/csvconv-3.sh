@@ -0,0 +1,3 @@
+# Test Case : unquoted fields with a bare CR are quoted on output
+printf 'a,b\r\r\nc\rd,e\r\nf,g\n' | ../csvconv | od -A d -c
+printf 'a,b\r\r\nc\rd,e\r\nf,g\n' | ../csvconv | ../csvconv -D '|' | od -A d -c
@@ -0,0 +1,6 @@
+# Test Case : cut by number, range and name, with quoted delims
+../csvcut -f 3,1 in/csvcut-1.csv
+echo --
+../csvcut -f 2- in/csvcut-1.csv
+echo --
+../csvcut -f n,-2,n in/csvcut-1.csv
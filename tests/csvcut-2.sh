@@ -0,0 +1,5 @@
+# Test Case : another delim from stdin, and bad cols
+printf "a|b|c\n1|'x|y'|3\n" | ../csvcut -d '|' -q "'" -f 2,3
+../csvcut -f nosuch in/csvcut-1.csv 2>&1
+../csvcut -f 3-1 in/csvcut-1.csv 2>&1 | tail -1
+echo
@@ -0,0 +1,10 @@
+# Test Case : look up keys by column name and number, with 2-row blocks
+mkdir -p out/csvfind-1
+cp in/csvfind-1.csv out/csvfind-1/x.csv
+rm -f out/csvfind-1/x.csv.csvidx out/csvfind-1/x.csv.csvbloom
+../csvfind -v -r 2 -k city out/csvfind-1/x.csv lima 2>&1
+echo --
+../csvfind -k 2 out/csvfind-1/x.csv 'new
+york' rome
+echo --
+../csvfind -k 1 out/csvfind-1/x.csv 6 id
@@ -0,0 +1,7 @@
+# Test Case : no such key, NULL key and no such column
+mkdir -p out/csvfind-2
+cp in/csvfind-1.csv out/csvfind-2/x.csv
+../csvfind -k note out/csvfind-2/x.csv zzz
+../csvfind -k note -n e out/csvfind-2/x.csv e
+../csvfind -k nosuch out/csvfind-2/x.csv 1 2>&1
+echo
@@ -0,0 +1,8 @@
+# Test Case : look up keys with the bitmap index, with 2-row blocks
+mkdir -p out/csvfind-3
+cp in/csvfind-1.csv out/csvfind-3/x.csv
+rm -f out/csvfind-3/x.csv.csvidx out/csvfind-3/x.csv.csvbmp
+../csvfind -b -v -r 2 -k city out/csvfind-3/x.csv lima rome 2>&1
+echo --
+../csvfind -b -v -k city out/csvfind-3/x.csv nosuch 2>&1
+echo
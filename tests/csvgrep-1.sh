@@ -0,0 +1,6 @@
+# Test Case : match any column, a column by name, and invert
+../csvgrep -e Oslo in/csvgrep-1.csv
+echo --
+../csvgrep -H -c city -e Oslo in/csvgrep-1.csv
+echo --
+../csvgrep -v -c 3 -e simd in/csvgrep-1.csv
@@ -0,0 +1,9 @@
+# Test Case : pattern with quote and delim, stdin, and bad args
+../csvgrep -e '"Oslo" ' in/csvgrep-1.csv
+echo --
+../csvgrep -e 'cold, dark' < in/csvgrep-1.csv
+echo --
+printf "a|b\n1|'x|y'\n2|z\n" | ../csvgrep -d '|' -q "'" -c 2 -e 'x|'
+../csvgrep -c nosuch -e x in/csvgrep-1.csv 2>&1
+../csvgrep in/csvgrep-1.csv 2>&1 | tail -1
+echo
@@ -0,0 +1,12 @@
+# Test Case : regex with anchors, classes and repeats, and bad regex
+mkdir -p out/csvgrep-3
+printf 'id,msg\n1,ERR-1234 disk\n2,"ERR-12, net"\n3,WARN ERR-5678\n4,"x\nERR-9999"\n' > out/csvgrep-3/x.csv
+../csvgrep -H -c msg -r '^ERR-[0-9]{4}' out/csvgrep-3/x.csv
+echo --
+../csvgrep -c 2 -r 'ERR-\d+$' out/csvgrep-3/x.csv
+echo --
+../csvgrep -r '^(1|3)$|net' out/csvgrep-3/x.csv
+echo --
+../csvgrep -r 'O{2,1}' out/csvgrep-3/x.csv 2>&1 | tail -1
+../csvgrep -r '(ab' out/csvgrep-3/x.csv 2>&1 | tail -1
+echo
@@ -0,0 +1,9 @@
+# Test Case : index every 2nd row across quoted newlines; reload and rebuild
+mkdir -p out/csvindex-1
+cp in/csvindex-1.csv out/csvindex-1/x.csv
+rm -f out/csvindex-1/x.csv.csvidx
+../csvindex -l -r 2 out/csvindex-1/x.csv
+../csvindex -p 3 out/csvindex-1/x.csv
+echo '8,"more' >> out/csvindex-1/x.csv
+echo 'rows"' >> out/csvindex-1/x.csv
+../csvindex -l -r 3 out/csvindex-1/x.csv
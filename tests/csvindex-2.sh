@@ -0,0 +1,4 @@
+# Test Case : bad stride and missing file
+../csvindex -r 0 in/csvindex-1.csv 2>&1 | tail -1
+../csvindex out/csvindex-2.missing 2>&1
+echo
@@ -0,0 +1,2 @@
+# Test Case : normalize using multiple threads
+../csvnorm -j 3 in/csvnorm-5.csv
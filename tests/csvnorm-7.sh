@@ -0,0 +1,3 @@
+# Test Case : rows already in normalized form, with LF and CRLF endings
+../csvnorm in/csvnorm-7.csv
+../csvnorm -n "\N" in/csvnorm-7.csv
@@ -0,0 +1,11 @@
+# Test Case : input of several chunks, with rows across chunk boundaries
+mkdir -p out/csvnorm-8
+awk 'BEGIN { for (i = 0; i < 600000; i++)
+  printf "%d,%s,\"multi\nline %d\",,x%d\n", i, (i % 3 ? "a b" : "\"q\"\"\""), i, i }' \
+  > out/csvnorm-8/x.csv
+../csvnorm out/csvnorm-8/x.csv > out/csvnorm-8/j1.csv
+../csvnorm -j 4 out/csvnorm-8/x.csv > out/csvnorm-8/j4.csv
+cmp out/csvnorm-8/j1.csv out/csvnorm-8/j4.csv && md5sum < out/csvnorm-8/j4.csv
+head -4 out/csvnorm-8/j4.csv
+tail -2 out/csvnorm-8/j4.csv
+rm -f out/csvnorm-8/*.csv
@@ -0,0 +1,9 @@
+# Test Case : numeric and byte ranges by column name, with 2-row blocks
+mkdir -p out/csvrange-1
+cp in/csvrange-1.csv out/csvrange-1/x.csv
+rm -f out/csvrange-1/x.csv.csvidx out/csvrange-1/x.csv.csvzone
+../csvrange -v -N -r 2 -k temp out/csvrange-1/x.csv 10 20 2>&1
+echo --
+../csvrange -r 2 -k city out/csvrange-1/x.csv m
+echo --
+../csvrange -N -r 2 -k 3 out/csvrange-1/x.csv '' 0
@@ -0,0 +1,8 @@
+# Test Case : NULL rows, an empty range and no such column
+mkdir -p out/csvrange-2
+cp in/csvrange-1.csv out/csvrange-2/x.csv
+../csvrange -z -k temp out/csvrange-2/x.csv
+echo --
+../csvrange -v -k city out/csvrange-2/x.csv x y 2>&1
+../csvrange -k nosuch out/csvrange-2/x.csv 1 2>&1
+echo
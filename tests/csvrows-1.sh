@@ -0,0 +1,10 @@
+# Test Case : pages across index entries, quoted newlines and a last row
+# without a newline
+mkdir -p out/csvrows-1
+cp in/csvindex-1.csv out/csvrows-1/x.csv
+rm -f out/csvrows-1/x.csv.csvidx
+../csvrows -r 2 out/csvrows-1/x.csv 1 3
+echo --
+../csvrows out/csvrows-1/x.csv 4 2
+echo --
+../csvrows out/csvrows-1/x.csv 6 100
@@ -0,0 +1,9 @@
+# Test Case : out of range rows and NULL fields
+mkdir -p out/csvrows-2
+cp in/csv2bin-1.csv out/csvrows-2/x.csv
+rm -f out/csvrows-2/x.csv.csvidx
+../csvrows out/csvrows-2/x.csv 2 2
+../csvrows -n '\N' out/csvrows-2/x.csv 4
+../csvrows out/csvrows-2/x.csv 6 2>&1
+../csvrows out/csvrows-2/x.csv 0 2>&1 | tail -1
+echo
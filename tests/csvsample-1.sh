@@ -0,0 +1,13 @@
+# Test Case : draws are uniform over short rows and long rows with newlines, and a whole small file
+mkdir -p out/csvsample-1
+awk 'BEGIN { x = sprintf("%100s", ""); gsub(/ /, "x", x);
+             for (i = 0; i < 200000; i++)
+               print i "," (i < 100000 ? "s" : "\"" x "\n" x "\"") }' > out/csvsample-1/x.csv
+for s in $(seq 1 200); do ../csvsample -s $s -n 10 out/csvsample-1/x.csv; done |
+  awk -F, '/^[0-9]+,/ { n++; short += ($2 == "s") }
+           END { p = short / n; print n, (p > 0.45 && p < 0.55) ? "uniform" : "biased " p }'
+../csvsample -v -s 1 -n 2 out/csvsample-1/x.csv 2>&1 >/dev/null |
+  awk '{ print ($3 < $5 / 4) ? "read a part" : "read all" }'
+rm -f out/csvsample-1/x.csv
+echo --
+../csvsample -H -n 100 in/csvtail-1.csv
@@ -0,0 +1,6 @@
+# Test Case : reservoir sample of a stream, and a bad arg
+cat in/csvtail-1.csv | ../csvsample -H -n 100
+echo --
+cat in/csvtail-1.csv | ../csvsample -s 5 -n 2 | wc -l
+../csvsample -n -1 in/csvtail-1.csv 2>&1 | tail -1
+echo
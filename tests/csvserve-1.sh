@@ -0,0 +1,15 @@
+# Test Case : serve key lookups and row ranges over a socket
+mkdir -p out/csvserve-1
+cp in/csvfind-1.csv out/csvserve-1/x.csv
+rm -f out/csvserve-1/x.csv.csvidx out/csvserve-1/x.csv.csvbloom
+../csvserve -r 2 -k city out/csvserve-1/s out/csvserve-1/x.csv &
+pid=$!
+for i in $(seq 50); do [ -S out/csvserve-1/s ] && break; sleep 0.1; done
+../csvserve -c out/csvserve-1/s find lima 'new
+york' city
+echo --
+../csvserve -c out/csvserve-1/s rows 3 2
+echo --
+../csvserve -c out/csvserve-1/s rows 0 2>&1
+kill $pid
+wait $pid
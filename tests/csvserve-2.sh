@@ -0,0 +1,13 @@
+# Test Case : bitmap index, and a last row with no newline
+mkdir -p out/csvserve-2
+cp in/csvtail-1.csv out/csvserve-2/x.csv
+rm -f out/csvserve-2/x.csv.csvidx out/csvserve-2/x.csv.csvbmp
+../csvserve -b -r 2 out/csvserve-2/s out/csvserve-2/x.csv &
+pid=$!
+for i in $(seq 50); do [ -S out/csvserve-2/s ] && break; sleep 0.1; done
+../csvserve -c out/csvserve-2/s find 6 3 9
+echo --
+../csvserve -c out/csvserve-2/s rows 6
+kill $pid
+wait $pid
+[ -S out/csvserve-2/s ] || echo gone
@@ -0,0 +1,8 @@
+# Test Case : read through the parse cache, which is rebuilt on change
+mkdir -p out/csvstat-5
+cp in/csvstat-1.csv out/csvstat-5/x.csv
+rm -f out/csvstat-5/x.csv.csvcache
+../csvstat -C out/csvstat-5/x.csv
+../csvstat -C out/csvstat-5/x.csv
+echo '1,"2,3",4' >> out/csvstat-5/x.csv
+../csvstat -C out/csvstat-5/x.csv
@@ -0,0 +1,6 @@
+# Test Case : last rows with newlines in quoted fields, no final newline
+../csvtail -n 2 in/csvtail-1.csv
+echo --
+../csvtail -H -n 3 in/csvtail-1.csv
+echo --
+../csvtail -n 100 in/csvtail-1.csv
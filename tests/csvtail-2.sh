@@ -0,0 +1,9 @@
+# Test Case : zero rows, another quote char and a bad arg
+../csvtail -n 0 in/csvtail-1.csv
+mkdir -p out/csvtail-2
+printf "a|b\n1|'x|\ny'\n2|z\n" > out/csvtail-2/x.csv
+../csvtail -n 2 -d '|' -q "'" out/csvtail-2/x.csv
+echo --
+../csvtail -n 2 -d '|' out/csvtail-2/x.csv
+../csvtail -n x in/csvtail-1.csv 2>&1 | tail -1
+echo
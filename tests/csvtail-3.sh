@@ -0,0 +1,10 @@
+# Test Case : last row has a quoted field longer than the first window that looks like rows
+mkdir -p out/csvtail-3
+awk 'BEGIN { for (i = 0; i < 100; i++) print i ",row" i;
+             printf "100,\"";
+             for (j = 0; j < 20000; j++) printf "%s%d,fake", j ? "\n" : "", j;
+             print "\""; print "101,end" }' > out/csvtail-3/x.csv
+../csvtail -n 2 out/csvtail-3/x.csv | awk 'NR <= 2 || NR >= 20000'
+echo --
+../csvtail -n 3 out/csvtail-3/x.csv | head -2
+rm -f out/csvtail-3/x.csv
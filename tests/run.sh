@@ -2,7 +2,7 @@
 
 mkdir -p out
 
-for i in csv2py-{1..10}.sh csvecho-{1..10}.sh csvnorm-{1..10}.sh csvsplit-{1..10}.sh csvstat-{1..10}.sh ; do
+for i in csv2arrow-{1..10}.sh csv2bin-{1..10}.sh csv2json-{1..10}.sh csv2parquet-{1..10}.sh csv2pg-{1..10}.sh csv2py-{1..10}.sh csv2shm-{1..10}.sh csvagg-{1..10}.sh csvbsearch-{1..10}.sh csvconv-{1..10}.sh csvcut-{1..10}.sh csvecho-{1..10}.sh csvfind-{1..10}.sh csvgrep-{1..10}.sh csvindex-{1..10}.sh csvnorm-{1..10}.sh csvrange-{1..10}.sh csvrows-{1..10}.sh csvsample-{1..10}.sh csvserve-{1..10}.sh csvsplit-{1..10}.sh csvstat-{1..10}.sh csvtail-{1..10}.sh ; do
 	F=$i
 	if [ -f $F ]; then
 		echo $F